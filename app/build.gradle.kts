@@ -17,6 +17,9 @@ android {
         externalNativeBuild {
             cmake {
                 cppFlags += "-std=c++11"
+
+                // OpenCV-android-sdk/sdk/native/jni, e.g. opencvDir=... in ~/.gradle/gradle.properties
+                (project.findProperty("opencvDir") as String?)?.let { arguments += "-DOpenCV_DIR=$it" }
             }
         }
     }
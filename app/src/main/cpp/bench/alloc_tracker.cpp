@@ -0,0 +1,290 @@
+//
+// Allocation counting for the host benchmark (malloc interposition, glibc only)
+//
+#include "alloc_tracker.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GLIBC__)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#define EDGE_ALLOC_TRACKING 1
+#else
+#define EDGE_ALLOC_TRACKING 0
+#endif
+
+namespace AllocTracker {
+
+#if EDGE_ALLOC_TRACKING
+
+    static const int kMaxFrames = 24;
+
+    // Frames belonging to the tracker itself: recordAllocation and the malloc wrapper
+    static const int kTrackerFrames = 2;
+
+    struct SiteSlot {
+        uint64_t hash;
+        int frameCount;
+        void* frames[kMaxFrames];
+        uint64_t count;
+        uint64_t bytes;
+    };
+
+    // Fixed storage: recording must not allocate
+    static SiteSlot siteSlots[kMaxSites];
+    static int siteCount = 0;
+    static std::atomic_flag siteLock = ATOMIC_FLAG_INIT;
+
+    static std::atomic<bool> tracking(false);
+    static std::atomic<uint64_t> allocations(0);
+    static std::atomic<uint64_t> bytes(0);
+    static thread_local bool insideTracker = false;
+
+    __attribute__((noinline)) static void recordAllocation(size_t size) {
+        if (!tracking.load(std::memory_order_relaxed) || insideTracker) {
+            return;
+        }
+        insideTracker = true;
+
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+
+        void* frames[kMaxFrames];
+        int frameCount = backtrace(frames, kMaxFrames);
+        uint64_t hash = 1469598103934665603ull;
+        for (int i = kTrackerFrames; i < frameCount; i++) {
+            hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+        }
+
+        while (siteLock.test_and_set(std::memory_order_acquire)) {
+        }
+        int index = 0;
+        while (index < siteCount && siteSlots[index].hash != hash) {
+            index++;
+        }
+        if (index == siteCount && siteCount < kMaxSites) {
+            SiteSlot& slot = siteSlots[siteCount++];
+            slot.hash = hash;
+            slot.frameCount = std::max(0, frameCount - kTrackerFrames);
+            memcpy(slot.frames, frames + kTrackerFrames, slot.frameCount * sizeof(void*));
+            slot.count = 0;
+            slot.bytes = 0;
+        }
+        if (index < siteCount) {
+            siteSlots[index].count++;
+            siteSlots[index].bytes += size;
+        }
+        siteLock.clear(std::memory_order_release);
+
+        insideTracker = false;
+    }
+
+    bool available() {
+        return true;
+    }
+
+    void start() {
+        // The first backtrace() loads the unwinder, which allocates: get that out of the way
+        void* frames[4];
+        backtrace(frames, 4);
+
+        while (siteLock.test_and_set(std::memory_order_acquire)) {
+        }
+        siteCount = 0;
+        siteLock.clear(std::memory_order_release);
+        allocations.store(0, std::memory_order_relaxed);
+        bytes.store(0, std::memory_order_relaxed);
+        tracking.store(true, std::memory_order_seq_cst);
+    }
+
+    void stop() {
+        tracking.store(false, std::memory_order_seq_cst);
+    }
+
+    uint64_t allocationCount() {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    uint64_t allocatedBytes() {
+        return bytes.load(std::memory_order_relaxed);
+    }
+
+    static bool isRuntimeModule(const char* path) {
+        static const char* const runtimes[] = {"/libc.so", "/libc-", "/libstdc++", "/libgcc_s", "/ld-linux", "/libm.so"};
+        for (const char* runtime : runtimes) {
+            if (path && strstr(path, runtime)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static Origin classify(const std::vector<void*>& frames) {
+        Dl_info self;
+        if (!dladdr(reinterpret_cast<void*>(&classify), &self)) {
+            return Origin::Project;
+        }
+        for (void* frame : frames) {
+            Dl_info info;
+            if (!dladdr(frame, &info) || isRuntimeModule(info.dli_fname)) {
+                continue;
+            }
+            return info.dli_fbase == self.dli_fbase ? Origin::Project : Origin::External;
+        }
+        return Origin::Project;
+    }
+
+    std::vector<Site> sites() {
+        std::vector<SiteSlot> slots;
+        while (siteLock.test_and_set(std::memory_order_acquire)) {
+        }
+        slots.assign(siteSlots, siteSlots + siteCount);
+        siteLock.clear(std::memory_order_release);
+
+        std::vector<Site> result;
+        for (const SiteSlot& slot : slots) {
+            Site site;
+            site.frames.assign(slot.frames, slot.frames + slot.frameCount);
+            site.count = slot.count;
+            site.bytes = slot.bytes;
+            site.origin = classify(site.frames);
+            result.push_back(site);
+        }
+        std::sort(result.begin(), result.end(), [](const Site& a, const Site& b) {
+            return a.count > b.count;
+        });
+        return result;
+    }
+
+    std::string describe(const Site& site, int maxFrames) {
+        std::string text;
+        int shown = 0;
+        for (void* frame : site.frames) {
+            if (shown++ >= maxFrames) {
+                break;
+            }
+            Dl_info info;
+            const char* module = "?";
+            const char* symbol = nullptr;
+            uintptr_t offset = 0;
+            if (dladdr(frame, &info)) {
+                if (info.dli_fname) {
+                    const char* slash = strrchr(info.dli_fname, '/');
+                    module = slash ? slash + 1 : info.dli_fname;
+                }
+                symbol = info.dli_sname;
+                offset = reinterpret_cast<uintptr_t>(frame) - reinterpret_cast<uintptr_t>(info.dli_saddr);
+            }
+
+            char line[512];
+            int status = -1;
+            char* demangled = symbol ? abi::__cxa_demangle(symbol, nullptr, nullptr, &status) : nullptr;
+            if (symbol) {
+                snprintf(line, sizeof(line), "%s: %s+0x%zx\n", module,
+                         status == 0 ? demangled : symbol, static_cast<size_t>(offset));
+            } else {
+                snprintf(line, sizeof(line), "%s: %p\n", module, frame);
+            }
+            free(demangled);
+            text += line;
+        }
+        return text;
+    }
+
+#else
+
+    bool available() { return false; }
+    void start() {}
+    void stop() {}
+    uint64_t allocationCount() { return 0; }
+    uint64_t allocatedBytes() { return 0; }
+    std::vector<Site> sites() { return {}; }
+    std::string describe(const Site&, int) { return {}; }
+
+#endif
+
+} // namespace AllocTracker
+
+#if EDGE_ALLOC_TRACKING
+
+// glibc's real allocator entry points
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void* __libc_valloc(size_t size);
+    void* __libc_pvalloc(size_t size);
+    void __libc_free(void* pointer);
+}
+
+// Interposed for the whole process: shared libraries bind to the executable's definitions
+extern "C" {
+
+    void* malloc(size_t size) {
+        void* pointer = __libc_malloc(size);
+        AllocTracker::recordAllocation(size);
+        return pointer;
+    }
+
+    void* calloc(size_t count, size_t size) {
+        void* pointer = __libc_calloc(count, size);
+        AllocTracker::recordAllocation(count * size);
+        return pointer;
+    }
+
+    void* realloc(void* pointer, size_t size) {
+        void* result = __libc_realloc(pointer, size);
+        AllocTracker::recordAllocation(size);
+        return result;
+    }
+
+    void* memalign(size_t alignment, size_t size) {
+        void* pointer = __libc_memalign(alignment, size);
+        AllocTracker::recordAllocation(size);
+        return pointer;
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) {
+        void* pointer = __libc_memalign(alignment, size);
+        AllocTracker::recordAllocation(size);
+        return pointer;
+    }
+
+    void* valloc(size_t size) {
+        void* pointer = __libc_valloc(size);
+        AllocTracker::recordAllocation(size);
+        return pointer;
+    }
+
+    void* pvalloc(size_t size) {
+        void* pointer = __libc_pvalloc(size);
+        AllocTracker::recordAllocation(size);
+        return pointer;
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) {
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+            return EINVAL;
+        }
+        void* pointer = __libc_memalign(alignment, size);
+        AllocTracker::recordAllocation(size);
+        if (!pointer) {
+            return ENOMEM;
+        }
+        *result = pointer;
+        return 0;
+    }
+
+    void free(void* pointer) {
+        __libc_free(pointer);
+    }
+
+}
+
+#endif
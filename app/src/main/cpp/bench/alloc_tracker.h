@@ -0,0 +1,71 @@
+#ifndef EDGE_BENCH_ALLOC_TRACKER_H
+#define EDGE_BENCH_ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Heap allocation counter for the host benchmark
+ *
+ * Interposes glibc's allocation entry points (malloc, calloc, realloc,
+ * memalign, aligned_alloc, posix_memalign, valloc and pvalloc, and with them
+ * operator new) in the benchmark executable. While tracking is on, every
+ * allocation from any thread is counted and its call stack recorded, so a
+ * steady-state frame loop can be checked for hidden allocations. Needs glibc; available() is false elsewhere.
+ */
+
+namespace AllocTracker {
+
+/**
+ * @brief Where an allocation came from
+ */
+    enum class Origin {
+        Project,    // Innermost caller is code built into this executable (edge_core)
+        External    // Made by a shared library on its own behalf (e.g. OpenCV internals)
+    };
+
+/**
+ * @brief One distinct allocating call stack
+ */
+    struct Site {
+        std::vector<void*> frames;  // Innermost first, allocator frames removed
+        uint64_t count;
+        uint64_t bytes;
+        Origin origin;
+    };
+
+    bool available();
+
+/**
+ * @brief Forget previous results and count allocations from now on
+ */
+    void start();
+
+/**
+ * @brief Stop counting
+ */
+    void stop();
+
+    uint64_t allocationCount();
+    uint64_t allocatedBytes();
+
+/**
+ * @brief Distinct call stacks seen since start(), most frequent first
+ *
+ * Only the first kMaxSites distinct stacks are kept; later ones are counted
+ * in allocationCount() but not listed.
+ */
+    std::vector<Site> sites();
+
+/**
+ * @brief Symbolized call stack, one "module: function+offset" per line
+ */
+    std::string describe(const Site& site, int maxFrames = 12);
+
+    constexpr int kMaxSites = 128;
+
+} // namespace AllocTracker
+
+#endif // EDGE_BENCH_ALLOC_TRACKER_H
@@ -0,0 +1,731 @@
+//
+// Microbenchmarks for the edge detection core
+//
+// Times applyCanny, streaming Canny, applySobel, the staged Canny cache,
+// threshold sweeps, tiled large-image Canny, edgeToRGBA, edgeToPackedRGBA and
+// the full processFrame path over common camera resolutions, kernel sizes and
+// thread counts, and prints one JSON document to stdout (logs go to stderr):
+//
+//   edge_bench [--iterations N] [--warmup N] [--quick] [--filter NAME] [--std-alloc] > results.json
+//
+// Like the app, Mats come from the pooled allocator unless --std-alloc is given.
+//
+// With --check-allocs it instead runs each public per-frame entry point for
+// --frames N frames (default 1000) after warm-up with malloc interposed, and
+// fails (exit code 1) if any of them allocated from project code. Allocations
+// OpenCV makes internally are listed but only fail the check with --strict.
+// Entries meant for one detector path (motion gate repeats, motion-compensated
+// reuse) also fail if the detector never took it. Call stacks of offending
+// allocations go to stderr.
+//
+// With --check-bands it compares the banded EdgeDetector::processFrame path with
+// whole-frame applyCanny over resolutions, kernel sizes and thresholds, and
+// fails (exit code 1) if the share of differing edge pixels at any resolution
+// exceeds kMaxBandMismatch. Bands run hysteresis with a limited margin, so weak
+// chains that leave it are cut at band borders; this bounds what that costs.
+//
+#include "image_processor.h"
+#include "canny_stages.h"
+#include "edge_detector.h"
+#include "mat_allocator.h"
+#include "stream_scheduler.h"
+#include "streaming_canny.h"
+#include "threshold_sweep.h"
+#include "tiled_canny.h"
+#include "alloc_tracker.h"
+#include "worker_pool.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace EdgeDetection;
+
+namespace {
+
+    struct Resolution {
+        const char* name;
+        int width;
+        int height;
+    };
+
+    struct Options {
+        int iterations = 30;
+        int warmup = 3;
+        bool quick = false;
+        bool stdAllocator = false;
+        bool checkAllocations = false;
+        bool checkBands = false;
+        bool strict = false;
+        int frames = 1000;
+        std::string filter;
+    };
+
+    struct Result {
+        std::string function;
+        const Resolution* resolution;
+        int kernel;
+        int threads;
+        double medianMs;
+        double p99Ms;
+        double meanMs;
+        double minMs;
+        double mbPerSecond;
+    };
+
+    // Largest share of edge pixels, over all kernels and thresholds of a resolution, that the
+    // banded frame path may get wrong against whole-frame Canny
+    const double kMaxBandMismatch = 0.10;
+
+    // Pool size of the band check; fixed so the band layout does not depend on the machine
+    const int kBandCheckWorkers = 4;
+
+    // Camera pan of the motion compensation allocation check: pixels per frame, frames per sweep
+    const int kPanStep = 4;
+    const int kPanFrames = 6;
+
+    const Resolution kResolutions[] = {
+            {"480p", 640, 480},
+            {"720p", 1280, 720},
+            {"1080p", 1920, 1080},
+            {"4K", 3840, 2160},
+    };
+
+/**
+ * @brief Deterministic camera-like test frame: gradient, shapes and sensor noise
+ */
+    cv::Mat makeTestFrame(int width, int height) {
+        cv::Mat frame(height, width, CV_8UC4);
+        for (int y = 0; y < height; y++) {
+            uint8_t* row = frame.ptr<uint8_t>(y);
+            for (int x = 0; x < width; x++) {
+                uint8_t level = static_cast<uint8_t>((x * 255 / width + y * 128 / height) / 2);
+                row[x * 4 + 0] = level;
+                row[x * 4 + 1] = level;
+                row[x * 4 + 2] = static_cast<uint8_t>(255 - level);
+                row[x * 4 + 3] = 255;
+            }
+        }
+
+        cv::RNG rng(12345);
+        int shapes = std::max(16, width * height / 20000);
+        for (int i = 0; i < shapes; i++) {
+            cv::Point center(rng.uniform(0, width), rng.uniform(0, height));
+            cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256), 255);
+            int size = rng.uniform(4, std::max(5, width / 12));
+            if (i % 2 == 0) {
+                cv::circle(frame, center, size, color, i % 3 == 0 ? -1 : 2);
+            } else {
+                cv::rectangle(frame, center, center + cv::Point(size, size / 2), color, i % 3 == 0 ? -1 : 2);
+            }
+        }
+
+        cv::Mat noise(height, width, CV_8UC4);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 6);
+        cv::add(frame, noise, frame);
+        return frame;
+    }
+
+/**
+ * @brief Run fn warmup + iterations times and summarize per-iteration latency
+ */
+    Result measure(const Options& options, const char* function, const Resolution& resolution,
+                   int kernel, int threads, size_t inputBytes, const std::function<void()>& fn) {
+        for (int i = 0; i < options.warmup; i++) {
+            fn();
+        }
+
+        std::vector<double> samplesMs(options.iterations);
+        for (int i = 0; i < options.iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto end = std::chrono::steady_clock::now();
+            samplesMs[i] = std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        std::vector<double> sorted = samplesMs;
+        std::sort(sorted.begin(), sorted.end());
+        size_t count = sorted.size();
+
+        Result result;
+        result.function = function;
+        result.resolution = &resolution;
+        result.kernel = kernel;
+        result.threads = threads;
+        result.medianMs = count % 2 ? sorted[count / 2]
+                                    : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+        // Nearest-rank percentile
+        size_t p99Rank = static_cast<size_t>(std::ceil(0.99 * count));
+        result.p99Ms = sorted[std::min(count, std::max<size_t>(p99Rank, 1)) - 1];
+        double total = 0.0;
+        for (double sample : sorted) {
+            total += sample;
+        }
+        result.meanMs = total / count;
+        result.minMs = sorted.front();
+        result.mbPerSecond = result.medianMs > 0.0 ? inputBytes / (result.medianMs * 1e3) : 0.0;
+        return result;
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (strcmp(arg, "--iterations") == 0 && hasValue) {
+                options.iterations = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(arg, "--warmup") == 0 && hasValue) {
+                options.warmup = std::max(0, atoi(argv[++i]));
+            } else if (strcmp(arg, "--quick") == 0) {
+                options.quick = true;
+            } else if (strcmp(arg, "--filter") == 0 && hasValue) {
+                options.filter = argv[++i];
+            } else if (strcmp(arg, "--std-alloc") == 0) {
+                options.stdAllocator = true;
+            } else if (strcmp(arg, "--check-allocs") == 0) {
+                options.checkAllocations = true;
+            } else if (strcmp(arg, "--check-bands") == 0) {
+                options.checkBands = true;
+            } else if (strcmp(arg, "--frames") == 0 && hasValue) {
+                options.frames = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(arg, "--strict") == 0) {
+                options.strict = true;
+            } else {
+                fprintf(stderr, "usage: %s [--iterations N] [--warmup N] [--quick] [--filter NAME] "
+                                "[--std-alloc] [--check-allocs [--frames N] [--strict]] [--check-bands]\n", argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool selected(const Options& options, const char* function) {
+        return options.filter.empty() || options.filter == function;
+    }
+
+    void printJson(const std::vector<Result>& results, const Options& options, int hardwareThreads) {
+        printf("{\n");
+        printf("  \"opencv\": \"%s\",\n", CV_VERSION);
+        printf("  \"hardware_threads\": %d,\n", hardwareThreads);
+        printf("  \"iterations\": %d,\n", options.iterations);
+        printf("  \"warmup\": %d,\n", options.warmup);
+        printf("  \"allocator\": \"%s\",\n", options.stdAllocator ? "opencv" : "pooled");
+        printf("  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            printf("    {\"function\": \"%s\", \"resolution\": \"%s\", \"width\": %d, \"height\": %d, "
+                   "\"kernel\": %d, \"threads\": %d, \"median_ms\": %.4f, \"p99_ms\": %.4f, "
+                   "\"mean_ms\": %.4f, \"min_ms\": %.4f, \"mb_per_s\": %.2f}%s\n",
+                   r.function.c_str(), r.resolution->name, r.resolution->width, r.resolution->height,
+                   r.kernel, r.threads, r.medianMs, r.p99Ms, r.meanMs, r.minMs, r.mbPerSecond,
+                   i + 1 < results.size() ? "," : "");
+        }
+        printf("  ]\n");
+        printf("}\n");
+    }
+
+    struct AllocationResult {
+        std::string entry;
+        uint64_t allocations;
+        uint64_t projectAllocations;
+        uint64_t externalAllocations;
+        uint64_t bytes;
+        bool pathTaken;         // False if the entry fell back to another path, so its count proves nothing
+    };
+
+/**
+ * @brief Run fn after warm-up with allocation tracking on and attribute what it allocated
+ */
+    AllocationResult checkAllocations(const Options& options, const char* entry,
+                                      const std::function<void()>& fn) {
+        const int warmupFrames = 20;
+        for (int i = 0; i < warmupFrames; i++) {
+            fn();
+        }
+
+        AllocTracker::start();
+        for (int i = 0; i < options.frames; i++) {
+            fn();
+        }
+        AllocTracker::stop();
+
+        AllocationResult result = {entry, AllocTracker::allocationCount(), 0, 0, AllocTracker::allocatedBytes(), true};
+        for (const AllocTracker::Site& site : AllocTracker::sites()) {
+            bool project = site.origin == AllocTracker::Origin::Project;
+            (project ? result.projectAllocations : result.externalAllocations) += site.count;
+            if (project || options.strict) {
+                fprintf(stderr, "%s: %llu allocations (%llu bytes) from %s code at:\n%s\n", entry,
+                        static_cast<unsigned long long>(site.count),
+                        static_cast<unsigned long long>(site.bytes),
+                        project ? "project" : "external", AllocTracker::describe(site).c_str());
+            }
+        }
+        // Sites past the tracker's table are counted but unattributed: blame the project
+        uint64_t attributed = result.projectAllocations + result.externalAllocations;
+        if (result.allocations > attributed) {
+            result.projectAllocations += result.allocations - attributed;
+        }
+
+        fprintf(stderr, "%-28s %8llu allocations in %d frames (%llu project, %llu external)\n", entry,
+                static_cast<unsigned long long>(result.allocations), options.frames,
+                static_cast<unsigned long long>(result.projectAllocations),
+                static_cast<unsigned long long>(result.externalAllocations));
+        return result;
+    }
+
+/**
+ * @brief Steady-state allocation check of every per-frame entry point
+ * @return Process exit code: 0 if no entry point allocated (from project code unless strict)
+ */
+    int runAllocationCheck(const Options& options, int hardwareThreads) {
+        if (!AllocTracker::available()) {
+            fprintf(stderr, "Allocation tracking needs glibc\n");
+            return 2;
+        }
+
+        const Resolution& resolution = kResolutions[0];
+        const int width = resolution.width;
+        const int height = resolution.height;
+        cv::Mat frame = makeTestFrame(width, height);
+        size_t frameBytes = frame.total() * frame.elemSize();
+        std::vector<uint8_t> outputFrame(frameBytes);
+        cv::Mat edges;
+        Workspace edgeWorkspace;    // Keeps the gradients of edges for the packed expansion
+        applyCanny(frame, edges, 50.0, 150.0, 3, edgeWorkspace);
+        cv::Mat output;
+        Workspace workspace;
+
+        std::vector<AllocationResult> results;
+        auto check = [&](const char* entry, const std::function<void()>& fn) {
+            if (selected(options, entry)) {
+                results.push_back(checkAllocations(options, entry, fn));
+            }
+        };
+
+        check("applyCanny", [&] {
+            applyCanny(frame, output, 50.0, 150.0, 3, workspace);
+        });
+        check("applySobel", [&] {
+            applySobel(frame, output, 3);
+        });
+        check("edgeToRGBA", [&] {
+            edgeToRGBA(edges, output);
+        });
+        check("edgeToPackedRGBA", [&] {
+            edgeToPackedRGBA(edges, edgeWorkspace.dxMat, edgeWorkspace.dyMat, 50.0, 150.0, output);
+        });
+        check("processFrame", [&] {
+            processFrame(frame.data, width, height, outputFrame.data());
+        });
+        check("processFrameRows", [&] {
+            processFrameRows(frame.data, width, height, outputFrame.data(), height / 4, height / 2,
+                             50.0, 150.0, 3, workspace);
+        });
+
+        EdgeDetector serialDetector;
+        check("EdgeDetector.processFrame", [&] {
+            serialDetector.processFrame(frame.data, width, height, outputFrame.data());
+        });
+
+        std::shared_ptr<WorkerPool> pool = std::make_shared<WorkerPool>(hardwareThreads);
+        EdgeDetector bandedDetector;
+        bandedDetector.setWorkerPool(pool);
+        check("EdgeDetector.bands", [&] {
+            bandedDetector.processFrame(frame.data, width, height, outputFrame.data());
+        });
+
+        // The GL thread's side of the progressive path: drain the frame's bands as they are published
+        FrameBand band;
+        auto drainBands = [&](ProgressiveFrame& progressive) {
+            while (progressive.takeBand(band, 0)) {
+                progressive.releaseBand();
+            }
+        };
+
+        EdgeDetector progressiveDetector;
+        progressiveDetector.setWorkerPool(pool);
+        check("EdgeDetector.progressive", [&] {
+            progressiveDetector.processFrameProgressive(frame.data, width, height);
+            drainBands(progressiveDetector.progressiveFrame());
+        });
+
+        for (int factor : {2, 4}) {
+            EdgeDetector interlacedDetector;
+            interlacedDetector.setWorkerPool(pool);
+            interlacedDetector.setInterlace(factor);
+            check(factor == 2 ? "EdgeDetector.interlace2" : "EdgeDetector.interlace4", [&] {
+                interlacedDetector.processFrame(frame.data, width, height, outputFrame.data());
+            });
+        }
+
+        EdgeDetector packedDetector;
+        packedDetector.setWorkerPool(pool);
+        packedDetector.setOutputFormat(OutputFormat::Packed);
+        check("EdgeDetector.packed", [&] {
+            packedDetector.processFrame(frame.data, width, height, outputFrame.data());
+        });
+
+        // Some entries only count if the detector took the path under test instead of falling back
+        auto requirePath = [&](const char* entry, bool taken) {
+            if (!results.empty() && results.back().entry == entry && !taken) {
+                fprintf(stderr, "%s: the path under test was never taken\n", entry);
+                results.back().pathTaken = false;
+            }
+        };
+
+        // A static scene: every frame after the first is a motion gate repeat
+        EdgeDetector gatedDetector;
+        gatedDetector.setWorkerPool(pool);
+        gatedDetector.setMotionGate(true);
+        check("EdgeDetector.motionGate", [&] {
+            gatedDetector.processFrameProgressive(frame.data, width, height);
+            drainBands(gatedDetector.progressiveFrame());
+        });
+        requirePath("EdgeDetector.motionGate", gatedDetector.getStats().framesSkipped > 0);
+
+        // A camera panning back and forth over a wider scene, kPanStep pixels per frame
+        cv::Mat scene = makeTestFrame(width + kPanStep * kPanFrames, height);
+        std::vector<cv::Mat> panFrames;
+        for (int i = 0; i < 2 * kPanFrames; i++) {
+            int offset = i < kPanFrames ? i : 2 * kPanFrames - i;
+            panFrames.push_back(scene(cv::Rect(offset * kPanStep, 0, width, height)).clone());
+        }
+        EdgeDetector compensatedDetector;
+        compensatedDetector.setWorkerPool(pool);
+        compensatedDetector.setMotionCompensation(true);
+        size_t panFrame = 0;
+        check("EdgeDetector.motionCompensation", [&] {
+            const cv::Mat& input = panFrames[panFrame++ % panFrames.size()];
+            compensatedDetector.processFrame(input.data, width, height, outputFrame.data());
+        });
+        requirePath("EdgeDetector.motionCompensation", compensatedDetector.getStats().framesReused > 0);
+
+        // Calibration sweeps after setImage: only the threshold passes run per call
+        std::vector<ThresholdPair> pairs;
+        for (int i = 0; i < 32; i++) {
+            pairs.push_back({20.0 + 5.0 * i, 60.0 + 10.0 * i});
+        }
+        ThresholdSweep sweep(pool);
+        sweep.setImage(frame, 3);
+        SweepOutput sweepOutput;
+        check("ThresholdSweep.perPair", [&] {
+            sweep.run(pairs, sweepOutput, SweepMode::PerPair);
+        });
+        check("ThresholdSweep.sliced", [&] {
+            sweep.run(pairs, sweepOutput, SweepMode::BitSliced);
+        });
+
+        // One StreamingCanny kept across frames, as a row-by-row producer would (applyCannyStreaming builds a new one per image)
+        StreamingCanny streaming;
+        check("StreamingCanny", [&] {
+            output.create(height, width, CV_8UC1);
+            streaming.begin(width, height, frame.channels(), 50.0, 150.0, 3, [&](int y, const uint8_t* rowEdges) {
+                memcpy(output.ptr<uint8_t>(y), rowEdges, width);
+            });
+            for (int y = 0; y < height; y++) {
+                streaming.pushRow(frame.ptr<uint8_t>(y));
+            }
+            streaming.finish([&](int y, int xStart, int xEnd) {
+                memset(output.ptr<uint8_t>(y) + xStart, 255, xEnd - xStart);
+            });
+        });
+
+        FrameMailbox& mailbox = serialDetector.mailbox();
+        check("FrameMailbox", [&] {
+            memcpy(mailbox.beginWrite(width, height), frame.data, frameBytes);
+            mailbox.publish(0);
+            mailbox.acquireLatest();
+        });
+
+        std::atomic<uint64_t> delivered(0);
+        StreamScheduler scheduler(std::make_shared<WorkerPool>(hardwareThreads),
+                                  [&](int, const FrameSlot&) {
+                                      delivered.fetch_add(1, std::memory_order_release);
+                                  });
+        StreamConfig config;
+        config.targetFps = 0.0;
+        config.dropLateFrames = false;
+        int stream = scheduler.registerStream(config);
+        uint64_t submitted = 0;
+        check("StreamScheduler", [&] {
+            scheduler.submitFrame(stream, frame.data, width, height, 0);
+            submitted++;
+            while (delivered.load(std::memory_order_acquire) < submitted) {
+                std::this_thread::yield();
+            }
+        });
+
+        bool passed = true;
+        printf("{\n");
+        printf("  \"allocator\": \"%s\",\n", options.stdAllocator ? "opencv" : "pooled");
+        printf("  \"resolution\": \"%s\",\n", resolution.name);
+        printf("  \"frames\": %d,\n", options.frames);
+        printf("  \"strict\": %s,\n", options.strict ? "true" : "false");
+        printf("  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const AllocationResult& r = results[i];
+            bool ok = r.pathTaken && r.projectAllocations == 0 && (!options.strict || r.externalAllocations == 0);
+            passed = passed && ok;
+            printf("    {\"entry\": \"%s\", \"allocations\": %llu, \"project\": %llu, \"external\": %llu, "
+                   "\"bytes\": %llu, \"per_frame\": %.3f, \"passed\": %s}%s\n",
+                   r.entry.c_str(), static_cast<unsigned long long>(r.allocations),
+                   static_cast<unsigned long long>(r.projectAllocations),
+                   static_cast<unsigned long long>(r.externalAllocations),
+                   static_cast<unsigned long long>(r.bytes),
+                   static_cast<double>(r.allocations) / options.frames, ok ? "true" : "false",
+                   i + 1 < results.size() ? "," : "");
+        }
+        printf("  ],\n");
+        printf("  \"passed\": %s\n", passed ? "true" : "false");
+        printf("}\n");
+        return passed ? 0 : 1;
+    }
+
+/**
+ * @brief Bound the edge pixels the banded frame path loses against whole-frame applyCanny
+ *
+ * Every kernel size and threshold pair of a resolution is compared, and the
+ * share of differing edge pixels summed over them must stay within
+ * kMaxBandMismatch. Single cases vary much more with the scene (one long weak
+ * outline can dominate), so they are reported but not bounded on their own.
+ * @return Process exit code: 0 if every resolution stayed within the bound
+ */
+    int runBandCheck(const Options& options) {
+        size_t resolutionCount = options.quick ? 1 : sizeof(kResolutions) / sizeof(kResolutions[0]);
+        const int kernels[] = {3, 5, 7, 9, 13};
+        const ThresholdPair thresholds[] = {{50.0, 150.0}, {20.0, 60.0}};
+        std::shared_ptr<WorkerPool> pool = std::make_shared<WorkerPool>(kBandCheckWorkers);
+
+        bool passed = true;
+        printf("{\n");
+        printf("  \"max_mismatch\": %.4f,\n", kMaxBandMismatch);
+        printf("  \"results\": [\n");
+        for (size_t r = 0; r < resolutionCount; r++) {
+            const Resolution& resolution = kResolutions[r];
+            cv::Mat frame = makeTestFrame(resolution.width, resolution.height);
+            std::vector<uint8_t> outputFrame(frame.total() * frame.elemSize());
+            uint64_t totalEdges = 0;
+            uint64_t totalDiffering = 0;
+            double worst = 0.0;
+
+            fprintf(stderr, "Checking bands at %s (%dx%d, %d bands)\n", resolution.name, resolution.width,
+                    resolution.height, frameBandCount(resolution.height, kBandCheckWorkers));
+            for (int kernel : kernels) {
+                for (const ThresholdPair& pair : thresholds) {
+                    Workspace workspace;
+                    cv::Mat reference;
+                    EdgeDetector detector;
+                    detector.setWorkerPool(pool);
+                    detector.updateParameters(pair.low, pair.high, kernel);
+                    if (!applyCanny(frame, reference, pair.low, pair.high, kernel, workspace) ||
+                        !detector.processFrame(frame.data, resolution.width, resolution.height,
+                                               outputFrame.data())) {
+                        fprintf(stderr, "%s kernel %d: processing failed\n", resolution.name, kernel);
+                        return 2;
+                    }
+
+                    // Channel 0 of the RGBA output is the edge mask
+                    uint64_t edgePixels = 0;
+                    uint64_t differing = 0;
+                    for (int y = 0; y < resolution.height; y++) {
+                        const uint8_t* expected = reference.ptr<uint8_t>(y);
+                        const uint8_t* banded = outputFrame.data() + static_cast<size_t>(y) * resolution.width * 4;
+                        for (int x = 0; x < resolution.width; x++) {
+                            edgePixels += expected[x] != 0;
+                            differing += (expected[x] != 0) != (banded[x * 4] != 0);
+                        }
+                    }
+                    double mismatch = static_cast<double>(differing) / std::max<uint64_t>(1, edgePixels);
+                    fprintf(stderr, "  kernel %2d, thresholds %3.0f/%3.0f: %llu of %llu edge pixels differ (%.2f%%)\n",
+                            kernel, pair.low, pair.high, static_cast<unsigned long long>(differing),
+                            static_cast<unsigned long long>(edgePixels), mismatch * 100.0);
+                    totalEdges += edgePixels;
+                    totalDiffering += differing;
+                    worst = std::max(worst, mismatch);
+                }
+            }
+
+            double mismatch = static_cast<double>(totalDiffering) / std::max<uint64_t>(1, totalEdges);
+            bool ok = mismatch <= kMaxBandMismatch;
+            passed = passed && ok;
+            printf("    {\"resolution\": \"%s\", \"bands\": %d, \"edge_pixels\": %llu, \"differing\": %llu, "
+                   "\"mismatch\": %.5f, \"worst_case\": %.5f, \"passed\": %s}%s\n",
+                   resolution.name, frameBandCount(resolution.height, kBandCheckWorkers),
+                   static_cast<unsigned long long>(totalEdges), static_cast<unsigned long long>(totalDiffering),
+                   mismatch, worst, ok ? "true" : "false", r + 1 < resolutionCount ? "," : "");
+        }
+        printf("  ],\n");
+        printf("  \"passed\": %s\n", passed ? "true" : "false");
+        printf("}\n");
+        return passed ? 0 : 1;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (!options.stdAllocator) {
+        PooledMatAllocator::install();
+    }
+
+    int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts;
+    for (int threads : {1, 2, 4, hardwareThreads}) {
+        if (threads <= hardwareThreads &&
+            std::find(threadCounts.begin(), threadCounts.end(), threads) == threadCounts.end()) {
+            threadCounts.push_back(threads);
+        }
+    }
+
+    if (options.checkAllocations) {
+        return runAllocationCheck(options, hardwareThreads);
+    }
+    if (options.checkBands) {
+        return runBandCheck(options);
+    }
+
+    std::vector<int> kernels = {3, 5, 7};
+    size_t resolutionCount = sizeof(kResolutions) / sizeof(kResolutions[0]);
+    if (options.quick) {
+        kernels = {3};
+        resolutionCount = 2;
+        threadCounts = {1, hardwareThreads};
+        threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+    }
+
+    std::vector<Result> results;
+
+    for (size_t r = 0; r < resolutionCount; r++) {
+        const Resolution& resolution = kResolutions[r];
+        cv::Mat frame = makeTestFrame(resolution.width, resolution.height);
+        size_t frameBytes = frame.total() * frame.elemSize();
+
+        cv::Mat edges;
+        Workspace edgeWorkspace;    // Keeps the gradients of edges for the packed expansion
+        applyCanny(frame, edges, 50.0, 150.0, 3, edgeWorkspace);
+        cv::Mat output;
+        std::vector<uint8_t> outputFrame(frameBytes);
+
+        fprintf(stderr, "Benchmarking %s (%dx%d)\n", resolution.name, resolution.width, resolution.height);
+
+        for (int threads : threadCounts) {
+            // Single-call stages scale through OpenCV's own thread pool
+            cv::setNumThreads(threads);
+
+            for (int kernel : kernels) {
+                if (selected(options, "applyCanny")) {
+                    Workspace workspace;
+                    results.push_back(measure(options, "applyCanny", resolution, kernel, threads, frameBytes, [&] {
+                        applyCanny(frame, output, 50.0, 150.0, kernel, workspace);
+                    }));
+                }
+                // Row-streaming mode for small-cache targets: single threaded, a few rows of scratch.
+                // Its blur is not applyCanny's (see StreamingCanny), so the edges are close, not equal
+                if (selected(options, "applyCannyStreaming")) {
+                    results.push_back(measure(options, "applyCannyStreaming", resolution, kernel, threads, frameBytes, [&] {
+                        applyCannyStreaming(frame, output, 50.0, 150.0, kernel);
+                    }));
+                }
+                if (selected(options, "applySobel")) {
+                    results.push_back(measure(options, "applySobel", resolution, kernel, threads, frameBytes, [&] {
+                        applySobel(frame, output, kernel);
+                    }));
+                }
+            }
+
+            // Interactive tuning on one image: full recompute vs. what a slider change reruns
+            if (selected(options, "cannyStages")) {
+                CannyStageCache stages;
+                uint64_t imageId = 0;
+                results.push_back(measure(options, "cannyStages.image", resolution, 3, threads, frameBytes, [&] {
+                    stages.run(frame, ++imageId, 50.0, 150.0, 3, output);
+                }));
+                int step = 0;
+                results.push_back(measure(options, "cannyStages.threshold", resolution, 3, threads, frameBytes, [&] {
+                    stages.run(frame, imageId, 50.0 + (++step & 1), 150.0, 3, output);
+                }));
+                results.push_back(measure(options, "cannyStages.kernel", resolution, 0, threads, frameBytes, [&] {
+                    stages.run(frame, imageId, 50.0, 150.0, (++step & 1) ? 5 : 3, output);
+                }));
+            }
+
+            // Calibration sweep of 32 threshold pairs: applyCanny per pair vs. one shared NMS pass
+            if (selected(options, "thresholdSweep")) {
+                std::vector<ThresholdPair> pairs;
+                for (int i = 0; i < 32; i++) {
+                    pairs.push_back({20.0 + 5.0 * i, 60.0 + 10.0 * i});
+                }
+                Workspace workspace;
+                results.push_back(measure(options, "thresholdSweep.applyCanny", resolution, 3, threads, frameBytes, [&] {
+                    for (const ThresholdPair& pair : pairs) {
+                        applyCanny(frame, output, pair.low, pair.high, 3, workspace);
+                    }
+                }));
+
+                ThresholdSweep sweep(std::make_shared<WorkerPool>(threads));
+                SweepOutput sweepOutput;
+                results.push_back(measure(options, "thresholdSweep.perPair", resolution, 3, threads, frameBytes, [&] {
+                    sweep.setImage(frame, 3);
+                    sweep.run(pairs, sweepOutput, SweepMode::PerPair);
+                }));
+                results.push_back(measure(options, "thresholdSweep.sliced", resolution, 3, threads, frameBytes, [&] {
+                    sweep.setImage(frame, 3);
+                    sweep.run(pairs, sweepOutput, SweepMode::BitSliced);
+                }));
+            }
+
+            // Large-image mode: same edges in bounded memory, tiles on a pool of the given size
+            if (selected(options, "applyCannyTiled")) {
+                WorkerPool tilePool(threads);
+                std::atomic<uint64_t> tilePixels(0);
+                results.push_back(measure(options, "applyCannyTiled", resolution, 3, threads, frameBytes, [&] {
+                    applyCannyTiled(frame, 50.0, 150.0, 3, [&](const cv::Rect& tile, const cv::Mat&) {
+                        tilePixels.fetch_add(static_cast<uint64_t>(tile.area()), std::memory_order_relaxed);
+                    }, &tilePool);
+                }));
+            }
+
+            if (selected(options, "edgeToRGBA")) {
+                results.push_back(measure(options, "edgeToRGBA", resolution, 0, threads, edges.total(), [&] {
+                    edgeToRGBA(edges, output);
+                }));
+            }
+
+            if (selected(options, "edgeToPackedRGBA")) {
+                results.push_back(measure(options, "edgeToPackedRGBA", resolution, 0, threads, edges.total(), [&] {
+                    edgeToPackedRGBA(edges, edgeWorkspace.dxMat, edgeWorkspace.dyMat, 50.0, 150.0, output);
+                }));
+            }
+
+            // Full frame path: row bands on a worker pool of the given size
+            if (selected(options, "processFrame")) {
+                for (int kernel : kernels) {
+                    EdgeDetector detector;
+                    detector.updateParameters(50.0, 150.0, kernel);
+                    if (threads > 1) {
+                        detector.setWorkerPool(std::make_shared<WorkerPool>(threads));
+                    }
+                    results.push_back(measure(options, "processFrame", resolution, kernel, threads, frameBytes, [&] {
+                        detector.processFrame(frame.data, resolution.width, resolution.height,
+                                              outputFrame.data());
+                    }));
+                    cv::setNumThreads(threads);
+                }
+            }
+        }
+    }
+
+    printJson(results, options, hardwareThreads);
+    return 0;
+}
@@ -0,0 +1,241 @@
+//
+// Gaussian blur backends: exact, running-sum box cascade and recursive (IIR)
+//
+#include "blur_filters.h"
+#include "log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define LOG_TAG "BlurFilters"
+
+namespace EdgeDetection {
+
+    // Sigma the pipeline has always blurred with
+    static const double kBaseBlurSigma = 1.4;
+
+    // Box filters per axis; three already make a good Gaussian (central limit)
+    static const int kBoxPasses = 3;
+
+    // Recursive filter support cut-off for halos, in sigmas
+    static const double kRecursiveSupportSigmas = 6.0;
+
+/**
+ * @brief Index of position i in n rows under BORDER_REFLECT_101 (GaussianBlur's default)
+ */
+    static int reflect101(int i, int n) {
+        if (n == 1) {
+            return 0;
+        }
+        while (i < 0 || i >= n) {
+            i = i < 0 ? -i : 2 * n - 2 - i;
+        }
+        return i;
+    }
+
+/**
+ * @brief Radii of the kBoxPasses boxes whose cascade has variance closest to sigma^2
+ *
+ * Widths are the odd integers around the ideal width sqrt(12 sigma^2 / n + 1),
+ * with as many of the lower one as bring the summed variance nearest sigma^2
+ * (Kovesi, "Fast almost-Gaussian filtering").
+ */
+    static void boxRadii(double sigma, int radii[kBoxPasses]) {
+        double variance = 12.0 * sigma * sigma;
+        int lower = static_cast<int>(std::floor(std::sqrt(variance / kBoxPasses + 1.0)));
+        if (lower % 2 == 0) {
+            lower--;
+        }
+        lower = std::max(lower, 1);
+        int upper = lower + 2;
+
+        double idealLowerCount = (variance - kBoxPasses * (lower * lower + 4.0 * lower + 3.0)) / (-4.0 * lower - 4.0);
+        int lowerCount = std::min(kBoxPasses, std::max(0, static_cast<int>(std::lround(idealLowerCount))));
+        for (int i = 0; i < kBoxPasses; i++) {
+            radii[i] = ((i < lowerCount ? lower : upper) - 1) / 2;
+        }
+    }
+
+/**
+ * @brief One box filter down the columns: running column sums, updated by one row in and one out
+ *
+ * Every inner loop runs across a whole row with independent columns, so the
+ * compiler vectorizes it. src and dst must differ.
+ * @param sums At least src.cols ints
+ */
+    static void boxColumns(const cv::Mat& src, cv::Mat& dst, int radius, int* sums) {
+        const int rows = src.rows;
+        const int cols = src.cols;
+        const int width = 2 * radius + 1;
+        const int scale = (65536 + width / 2) / width;     // 1 / width in Q16
+        dst.create(rows, cols, CV_8UC1);
+
+        std::fill(sums, sums + cols, 0);
+        for (int k = -radius; k <= radius; k++) {
+            const uchar* in = src.ptr<uchar>(reflect101(k, rows));
+            for (int x = 0; x < cols; x++) {
+                sums[x] += in[x];
+            }
+        }
+
+        for (int y = 0; y < rows; y++) {
+            uchar* out = dst.ptr<uchar>(y);
+            for (int x = 0; x < cols; x++) {
+                out[x] = static_cast<uchar>((sums[x] * scale + 32768) >> 16);
+            }
+            if (y + 1 < rows) {
+                const uchar* entering = src.ptr<uchar>(reflect101(y + radius + 1, rows));
+                const uchar* leaving = src.ptr<uchar>(reflect101(y - radius, rows));
+                for (int x = 0; x < cols; x++) {
+                    sums[x] += entering[x] - leaving[x];
+                }
+            }
+        }
+    }
+
+/**
+ * @brief Young-van Vliet coefficients: y[n] = b x[n] + a1 y[n-1] + a2 y[n-2] + a3 y[n-3]
+ */
+    struct RecursiveCoefficients {
+        float b;
+        float a1;
+        float a2;
+        float a3;
+    };
+
+    static RecursiveCoefficients recursiveCoefficients(double sigma) {
+        sigma = std::max(sigma, 0.5);
+        double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330
+                                : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+        double q2 = q * q;
+        double q3 = q2 * q;
+        double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+        double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+        double b2 = -(1.4281 * q2 + 1.26661 * q3);
+        double b3 = 0.422205 * q3;
+
+        RecursiveCoefficients c;
+        c.a1 = static_cast<float>(b1 / b0);
+        c.a2 = static_cast<float>(b2 / b0);
+        c.a3 = static_cast<float>(b3 / b0);
+        c.b = static_cast<float>(1.0 - (b1 + b2 + b3) / b0);
+        return c;
+    }
+
+/**
+ * @brief Recursive Gaussian down the columns of a float image, in place
+ *
+ * The recursion runs along the rows and the inner loops across the columns,
+ * which are independent, so they vectorize. Outside the image the signal is
+ * taken to continue as its edge row, whose steady-state response is that row.
+ * @param edge At least data.cols floats
+ */
+    static void recursiveColumns(cv::Mat& data, const RecursiveCoefficients& c, float* edge) {
+        const int rows = data.rows;
+        const int cols = data.cols;
+
+        // Causal pass, top to bottom
+        std::memcpy(edge, data.ptr<float>(0), cols * sizeof(float));
+        for (int y = 0; y < rows; y++) {
+            float* out = data.ptr<float>(y);
+            const float* p1 = y >= 1 ? data.ptr<float>(y - 1) : edge;
+            const float* p2 = y >= 2 ? data.ptr<float>(y - 2) : edge;
+            const float* p3 = y >= 3 ? data.ptr<float>(y - 3) : edge;
+            for (int x = 0; x < cols; x++) {
+                out[x] = c.b * out[x] + c.a1 * p1[x] + c.a2 * p2[x] + c.a3 * p3[x];
+            }
+        }
+
+        // Anti-causal pass over the causal result, bottom to top
+        std::memcpy(edge, data.ptr<float>(rows - 1), cols * sizeof(float));
+        for (int y = rows - 1; y >= 0; y--) {
+            float* out = data.ptr<float>(y);
+            const float* p1 = y + 1 < rows ? data.ptr<float>(y + 1) : edge;
+            const float* p2 = y + 2 < rows ? data.ptr<float>(y + 2) : edge;
+            const float* p3 = y + 3 < rows ? data.ptr<float>(y + 3) : edge;
+            for (int x = 0; x < cols; x++) {
+                out[x] = c.b * out[x] + c.a1 * p1[x] + c.a2 * p2[x] + c.a3 * p3[x];
+            }
+        }
+    }
+
+    double blurSigma(int kernelSize) {
+        return std::max(kBaseBlurSigma, 0.3 * ((kernelSize - 1) * 0.5 - 1.0) + 0.8);
+    }
+
+    BlurBackend blurBackend(int kernelSize) {
+        if (kernelSize <= kMaxExactBlurKernel) {
+            return BlurBackend::Exact;
+        }
+        return kernelSize <= kMaxRecursiveBlurKernel ? BlurBackend::Recursive : BlurBackend::BoxCascade;
+    }
+
+    int blurSupportRadius(int kernelSize) {
+        switch (blurBackend(kernelSize)) {
+            case BlurBackend::Exact:
+                return kernelSize / 2;
+            case BlurBackend::Recursive:
+                return static_cast<int>(std::ceil(kRecursiveSupportSigmas * blurSigma(kernelSize)));
+            case BlurBackend::BoxCascade: {
+                int radii[kBoxPasses];
+                boxRadii(blurSigma(kernelSize), radii);
+                int support = 0;
+                for (int radius : radii) {
+                    support += radius;
+                }
+                return support;
+            }
+        }
+        return kernelSize / 2;
+    }
+
+    void gaussianBlur(const cv::Mat& src, cv::Mat& dst, int kernelSize, BlurBuffers& buffers) {
+        double sigma = blurSigma(kernelSize);
+        switch (blurBackend(kernelSize)) {
+            case BlurBackend::Exact:
+                cv::GaussianBlur(src, dst, cv::Size(kernelSize, kernelSize), sigma);
+                break;
+            case BlurBackend::Recursive:
+                recursiveGaussianBlur(src, dst, sigma, buffers);
+                break;
+            case BlurBackend::BoxCascade:
+                boxCascadeBlur(src, dst, sigma, buffers);
+                break;
+        }
+    }
+
+    void boxCascadeBlur(const cv::Mat& src, cv::Mat& dst, double sigma, BlurBuffers& buffers) {
+        int radii[kBoxPasses];
+        boxRadii(sigma, radii);
+
+        // One length for both orientations, so the buffer is not reallocated between them
+        buffers.row.create(1, std::max(src.rows, src.cols), CV_32S);
+        int* sums = buffers.row.ptr<int>(0);
+
+        // Columns first; the rows are the columns of the transpose
+        boxColumns(src, buffers.passA, radii[0], sums);
+        boxColumns(buffers.passA, buffers.passB, radii[1], sums);
+        boxColumns(buffers.passB, buffers.passA, radii[2], sums);
+        cv::transpose(buffers.passA, buffers.transposedA);
+        boxColumns(buffers.transposedA, buffers.transposedB, radii[0], sums);
+        boxColumns(buffers.transposedB, buffers.transposedA, radii[1], sums);
+        boxColumns(buffers.transposedA, buffers.transposedB, radii[2], sums);
+        cv::transpose(buffers.transposedB, dst);
+    }
+
+    void recursiveGaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, BlurBuffers& buffers) {
+        RecursiveCoefficients coefficients = recursiveCoefficients(sigma);
+        buffers.row.create(1, std::max(src.rows, src.cols), CV_32F);
+        float* edge = buffers.row.ptr<float>(0);
+
+        src.convertTo(buffers.passA, CV_32F);
+        recursiveColumns(buffers.passA, coefficients, edge);
+        cv::transpose(buffers.passA, buffers.transposedA);
+        recursiveColumns(buffers.transposedA, coefficients, edge);
+        cv::transpose(buffers.transposedA, buffers.passA);
+
+        // Rounds and saturates back to 8 bits
+        buffers.passA.convertTo(dst, CV_8U);
+    }
+
+} // namespace EdgeDetection
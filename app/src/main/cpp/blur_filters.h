@@ -0,0 +1,97 @@
+#ifndef BLUR_FILTERS_H
+#define BLUR_FILTERS_H
+
+#include <opencv2/opencv.hpp>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Implementation chosen for a Gaussian blur of a given kernel size
+ */
+    enum class BlurBackend {
+        Exact,          // Full sampled Gaussian; cost grows with the kernel size
+        Recursive,      // Young-van Vliet third-order recursive filter, O(1) per pixel
+        BoxCascade,     // Three running-sum box filters, O(1) per pixel
+    };
+
+/**
+ * @brief Largest kernel of the exact backend, which convolves with every tap of the sampled Gaussian
+ *
+ * gaussianBlur() runs cv::GaussianBlur for these sizes. applyCanny and
+ * applySobel do not blur separately at all: they fold the Gaussian into a
+ * derivative-of-Gaussian gradient pass (see cannyGradientKernel), which keeps
+ * the blurred values unrounded and reflects the border (BORDER_REFLECT_101).
+ * Their edges therefore differ from 8-bit cv::GaussianBlur followed by
+ * cv::Canny where a gradient lands within rounding of a threshold and within
+ * a few pixels of the image border.
+ */
+    constexpr int kMaxExactBlurKernel = 7;
+
+/**
+ * @brief Largest kernel blurred by the recursive filter; larger ones use the box cascade
+ *
+ * Box widths are odd integers, so the cascade is coarse at small sigmas: its
+ * peak is 15% off a true Gaussian at sigma 1.7 (kernel 9) and 6% at 2.0, but
+ * 3-5% from sigma 2.3 (kernel 13) on, no worse than the recursive filter.
+ * The recursive filter works in float and costs more, so it only covers the
+ * sizes the boxes cannot.
+ */
+    constexpr int kMaxRecursiveBlurKernel = 11;
+
+/**
+ * @brief Gaussian sigma used for a blur kernel size
+ *
+ * 1.4 up to kernel 7 as before; larger kernels follow OpenCV's rule
+ * 0.3 * ((size - 1) / 2 - 1) + 0.8, which also gives 1.4 at size 7, so a
+ * larger kernel now means a stronger blur instead of more taps of the same one.
+ */
+    double blurSigma(int kernelSize);
+
+/**
+ * @brief Backend gaussianBlur() uses for a kernel size
+ */
+    BlurBackend blurBackend(int kernelSize);
+
+/**
+ * @brief Rows (or columns) of input beyond a pixel that its blurred value depends on
+ *
+ * kernelSize / 2 for the exact blur, the summed box radii for the cascade. The
+ * recursive filter's response never ends; beyond 6 sigma it carries under
+ * 1e-4 of the signal, well below 8-bit rounding, so that is where band and tile
+ * halos stop.
+ */
+    int blurSupportRadius(int kernelSize);
+
+/**
+ * @brief Scratch images of the O(1) blur backends, kept so steady-state frames never allocate
+ */
+    struct BlurBuffers {
+        cv::Mat passA;          // Column passes over the image, ping-ponged
+        cv::Mat passB;
+        cv::Mat transposedA;    // ... and over its transpose, which are the row passes
+        cv::Mat transposedB;
+        cv::Mat row;            // Running sums or boundary values, long enough for either shape
+    };
+
+/**
+ * @brief Gaussian blur of a single-channel 8-bit image with the backend chosen for the kernel size
+ * @param src Input image (CV_8UC1)
+ * @param dst Output image, same size and type; may be src
+ * @param kernelSize Odd blur kernel size
+ * @param buffers Scratch images reused across calls
+ */
+    void gaussianBlur(const cv::Mat& src, cv::Mat& dst, int kernelSize, BlurBuffers& buffers);
+
+/**
+ * @brief Approximate Gaussian blur by three box filters per axis (running sums, BORDER_REFLECT_101)
+ */
+    void boxCascadeBlur(const cv::Mat& src, cv::Mat& dst, double sigma, BlurBuffers& buffers);
+
+/**
+ * @brief Young-van Vliet recursive Gaussian blur, forward and backward along each axis (replicated border)
+ */
+    void recursiveGaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, BlurBuffers& buffers);
+
+} // namespace EdgeDetection
+
+#endif // BLUR_FILTERS_H
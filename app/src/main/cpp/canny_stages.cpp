@@ -0,0 +1,227 @@
+//
+// Canny with per-stage caching for interactive parameter tuning
+//
+#include "canny_stages.h"
+#include "gradient_filters.h"
+#include "log.h"
+#include "processing_stats.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#define LOG_TAG "CannyStages"
+
+namespace EdgeDetection {
+
+    // Fixed-point direction test of OpenCV's Canny: tan(22.5 deg) in Q15
+    static constexpr int kCannyShift = 15;
+    static constexpr int kTan22 = static_cast<int>(0.4142135623730950488016887242097 * (1 << kCannyShift) + 0.5);
+
+    void suppressNonMaximaRow(const short* dxRow, const short* dyRow, const uint16_t* magPrev,
+                              const uint16_t* mag, const uint16_t* magNext, uint16_t* out, int width) {
+        auto at = [width](const uint16_t* row, int x) -> int {
+            return row && x >= 0 && x < width ? row[x] : 0;
+        };
+
+        for (int x = 0; x < width; x++) {
+            int m = mag[x];
+            bool isMaximum = false;
+            if (m > 0) {
+                int xs = dxRow[x];
+                int ys = dyRow[x];
+                int ax = std::abs(xs);
+                int ay = std::abs(ys) << kCannyShift;
+                int tg22x = ax * kTan22;
+
+                if (ay < tg22x) {
+                    isMaximum = m > at(mag, x - 1) && m >= at(mag, x + 1);
+                } else {
+                    int tg67x = tg22x + (ax << (kCannyShift + 1));
+                    if (ay > tg67x) {
+                        isMaximum = m > at(magPrev, x) && m >= at(magNext, x);
+                    } else {
+                        int s = (xs ^ ys) < 0 ? -1 : 1;
+                        isMaximum = m > at(magPrev, x - s) && m > at(magNext, x + s);
+                    }
+                }
+            }
+            out[x] = isMaximum ? static_cast<uint16_t>(m) : 0;
+        }
+    }
+
+    void suppressNonMaxima(const cv::Mat& dx, const cv::Mat& dy, const cv::Mat& magnitude,
+                           cv::Mat& suppressed, int rowStart, int rowEnd) {
+        int height = magnitude.rows;
+        for (int y = rowStart; y < rowEnd; y++) {
+            suppressNonMaximaRow(dx.ptr<short>(y), dy.ptr<short>(y),
+                                 y > 0 ? magnitude.ptr<uint16_t>(y - 1) : nullptr,
+                                 magnitude.ptr<uint16_t>(y),
+                                 y + 1 < height ? magnitude.ptr<uint16_t>(y + 1) : nullptr,
+                                 suppressed.ptr<uint16_t>(y), magnitude.cols);
+        }
+    }
+
+    void gradientMagnitude(const cv::Mat& dx, const cv::Mat& dy, cv::Mat& magnitude,
+                           int rowStart, int rowEnd) {
+        for (int y = rowStart; y < rowEnd; y++) {
+            const short* dxRow = dx.ptr<short>(y);
+            const short* dyRow = dy.ptr<short>(y);
+            uint16_t* mag = magnitude.ptr<uint16_t>(y);
+            for (int x = 0; x < dx.cols; x++) {
+                mag[x] = static_cast<uint16_t>(std::abs(dxRow[x]) + std::abs(dyRow[x]));
+            }
+        }
+    }
+
+    void cannyThresholds(double lowThreshold, double highThreshold, int& low, int& high) {
+        if (lowThreshold > highThreshold) {
+            std::swap(lowThreshold, highThreshold);
+        }
+        low = static_cast<int>(std::floor(lowThreshold));
+        high = static_cast<int>(std::floor(highThreshold));
+    }
+
+    void convertToGray(const cv::Mat& inputMat, cv::Mat& grayMat) {
+        if (inputMat.channels() == 4) {
+            cv::cvtColor(inputMat, grayMat, cv::COLOR_RGBA2GRAY);
+        } else if (inputMat.channels() == 3) {
+            cv::cvtColor(inputMat, grayMat, cv::COLOR_BGR2GRAY);
+        } else {
+            inputMat.copyTo(grayMat);
+        }
+    }
+
+    void cannyGradients(const cv::Mat& grayMat, int kernelSize, cv::Mat& blurredMat, BlurBuffers& blurBuffers,
+                        cv::Mat& dxMat, cv::Mat& dyMat) {
+        const GradientKernel* kernel = cannyGradientKernel(kernelSize);
+        if (kernel) {
+            // Blur and Sobel as one derivative-of-Gaussian pass over the gray image
+            gradientFilter(grayMat, *kernel, dxMat, dyMat, blurBuffers.row);
+            return;
+        }
+
+        gaussianBlur(grayMat, blurredMat, kernelSize, blurBuffers);
+
+        // Same 3x3 aperture and replicated border cv::Canny uses on an image
+        cv::Sobel(blurredMat, dxMat, CV_16S, 1, 0, 3, 1, 0, cv::BORDER_REPLICATE);
+        cv::Sobel(blurredMat, dyMat, CV_16S, 0, 1, 3, 1, 0, cv::BORDER_REPLICATE);
+    }
+
+    CannyStageCache::CannyStageCache()
+            : imageId_(0),
+              width_(0),
+              height_(0),
+              type_(-1),
+              kernelSize_(0),
+              lowThreshold_(0.0),
+              highThreshold_(0.0),
+              grayValid_(false),
+              gradientsValid_(false),
+              edgesValid_(false),
+              lastRecomputed_(CannyStage::Gray),
+              stats_(nullptr) {
+    }
+
+    void CannyStageCache::invalidate() {
+        grayValid_ = false;
+        gradientsValid_ = false;
+        edgesValid_ = false;
+    }
+
+    bool CannyStageCache::run(const cv::Mat& inputMat, uint64_t imageId,
+                              double lowThreshold, double highThreshold, int kernelSize,
+                              cv::Mat& outputMat) {
+        try {
+            if (inputMat.empty()) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Input matrix is empty");
+                return false;
+            }
+
+            computeGradients(inputMat, imageId, kernelSize);
+            if (!edgesValid_ || lowThreshold != lowThreshold_ || highThreshold != highThreshold_) {
+                edgesValid_ = false;
+                if (lastRecomputed_ == CannyStage::None) {
+                    lastRecomputed_ = CannyStage::Edges;
+                }
+            }
+
+            if (!edgesValid_) {
+                TRACE_SCOPE("canny");
+                ScopedStageTimer timer(stats_, ProcessingStage::Canny);
+                cv::Canny(dxMat_, dyMat_, edgeMat_, lowThreshold, highThreshold, false);
+                lowThreshold_ = lowThreshold;
+                highThreshold_ = highThreshold;
+                edgesValid_ = true;
+            }
+
+            outputMat = edgeMat_;
+            return true;
+
+        } catch (const cv::Exception& e) {
+            invalidate();
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in CannyStageCache::run: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            invalidate();
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "Standard exception in CannyStageCache::run: %s", e.what());
+            return false;
+        }
+    }
+
+    bool CannyStageCache::updateGradients(const cv::Mat& inputMat, uint64_t imageId, int kernelSize) {
+        try {
+            if (inputMat.empty()) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Input matrix is empty");
+                return false;
+            }
+
+            computeGradients(inputMat, imageId, kernelSize);
+            return true;
+
+        } catch (const cv::Exception& e) {
+            invalidate();
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in CannyStageCache::updateGradients: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            invalidate();
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "Standard exception in CannyStageCache::updateGradients: %s", e.what());
+            return false;
+        }
+    }
+
+    void CannyStageCache::computeGradients(const cv::Mat& inputMat, uint64_t imageId, int kernelSize) {
+        // Each check only narrows what the previous one left valid
+        if (imageId == 0 || imageId != imageId_ || inputMat.cols != width_ ||
+            inputMat.rows != height_ || inputMat.type() != type_) {
+            grayValid_ = false;
+        }
+        if (!grayValid_ || kernelSize != kernelSize_) {
+            gradientsValid_ = false;
+            edgesValid_ = false;
+        }
+        lastRecomputed_ = !grayValid_ ? CannyStage::Gray
+                        : !gradientsValid_ ? CannyStage::Blur
+                        : CannyStage::None;
+
+        if (!grayValid_) {
+            TRACE_SCOPE("gray");
+            ScopedStageTimer timer(stats_, ProcessingStage::Gray);
+            convertToGray(inputMat, grayMat_);
+            imageId_ = imageId;
+            width_ = inputMat.cols;
+            height_ = inputMat.rows;
+            type_ = inputMat.type();
+            grayValid_ = true;
+        }
+
+        if (!gradientsValid_) {
+            TRACE_SCOPE("blur");
+            ScopedStageTimer timer(stats_, ProcessingStage::Blur);
+            cannyGradients(grayMat_, kernelSize, blurredMat_, blurBuffers_, dxMat_, dyMat_);
+            kernelSize_ = kernelSize;
+            gradientsValid_ = true;
+        }
+    }
+
+} // namespace EdgeDetection
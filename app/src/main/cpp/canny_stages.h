@@ -0,0 +1,160 @@
+#ifndef CANNY_STAGES_H
+#define CANNY_STAGES_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+#include "blur_filters.h"
+
+namespace EdgeDetection {
+
+    class StatsRecorder;
+
+/**
+ * @brief Canny pipeline stages, in the order they depend on each other
+ */
+    enum class CannyStage {
+        Gray,       // Grayscale conversion; depends on the image only
+        Blur,       // Gaussian blur and Sobel gradients; + blur kernel
+        Edges,      // Non-maximum suppression and hysteresis; + thresholds
+        None        // Nothing recomputed, cached edges returned
+    };
+
+/**
+ * @brief Grayscale version of an RGBA, BGR or already single-channel image
+ */
+    void convertToGray(const cv::Mat& inputMat, cv::Mat& grayMat);
+
+/**
+ * @brief CV_16S Sobel gradients of the Gaussian-blurred image, the gradient stage of applyCanny
+ *
+ * Exact blur kernels take the fused derivative-of-Gaussian filter of
+ * cannyGradientKernel() straight from the gray image; larger ones blur with
+ * gaussianBlur() first and run cv::Canny's 3x3 Sobel on the result.
+ * @param blurredMat Blurred image, only written for kernels without a fused filter
+ * @param blurBuffers Scratch of the blur backends and the fused filter
+ */
+    void cannyGradients(const cv::Mat& grayMat, int kernelSize, cv::Mat& blurredMat, BlurBuffers& blurBuffers,
+                        cv::Mat& dxMat, cv::Mat& dyMat);
+
+/**
+ * @brief L1 gradient magnitude |dx| + |dy| of rows [rowStart, rowEnd)
+ * @param magnitude Preallocated CV_16U output the size of dx
+ */
+    void gradientMagnitude(const cv::Mat& dx, const cv::Mat& dy, cv::Mat& magnitude,
+                           int rowStart, int rowEnd);
+
+/**
+ * @brief Keep the magnitude of rows [rowStart, rowEnd) where it is a local maximum, else 0
+ *
+ * Same fixed-point direction test and tie-breaking as cv::Canny, with zero
+ * magnitude outside the matrices, so the candidates are exactly OpenCV's.
+ * @param suppressed Preallocated CV_16U output the size of magnitude
+ */
+    void suppressNonMaxima(const cv::Mat& dx, const cv::Mat& dy, const cv::Mat& magnitude,
+                           cv::Mat& suppressed, int rowStart, int rowEnd);
+
+/**
+ * @brief suppressNonMaxima for one row given its neighbours' magnitudes (null outside the image)
+ */
+    void suppressNonMaximaRow(const short* dxRow, const short* dyRow, const uint16_t* magPrev,
+                              const uint16_t* mag, const uint16_t* magNext, uint16_t* out, int width);
+
+/**
+ * @brief Integer thresholds as cv::Canny applies them to L1 magnitudes (floored, ordered)
+ */
+    void cannyThresholds(double lowThreshold, double highThreshold, int& low, int& high);
+
+/**
+ * @brief Canny edge detection that keeps every intermediate stage between calls
+ *
+ * Each stage is keyed by the identity of the input image plus only the
+ * parameters that stage depends on, so re-running the same image after a
+ * threshold change redoes just non-maximum suppression and hysteresis, and a
+ * blur kernel change redoes blur onward. Meant for interactive tuning on
+ * paused frames and large still images; live frames change every time and are
+ * better served by Workspace. Holds about 7 bytes per pixel. Not thread safe.
+ */
+    class CannyStageCache {
+    public:
+        CannyStageCache();
+
+        CannyStageCache(const CannyStageCache&) = delete;
+        CannyStageCache& operator=(const CannyStageCache&) = delete;
+
+        /**
+         * @brief Edge map of an image, recomputing only the stages whose inputs changed
+         * @param inputMat Input image (RGBA, BGR or grayscale)
+         * @param imageId Caller-chosen identity of the image content; must change whenever
+         *                the pixels do. 0 never matches, so every stage is recomputed.
+         * @param lowThreshold Lower threshold for edge detection
+         * @param highThreshold Upper threshold for edge detection
+         * @param kernelSize Gaussian blur kernel size
+         * @param outputMat Receives the edge map (shares the cached buffer)
+         * @return true if successful, false otherwise
+         */
+        bool run(const cv::Mat& inputMat, uint64_t imageId,
+                 double lowThreshold, double highThreshold, int kernelSize,
+                 cv::Mat& outputMat);
+
+        /**
+         * @brief Bring only the gray, blur and gradient stages up to date
+         *
+         * For callers that run their own edge stage on the gradients, such as
+         * threshold sweeps.
+         * @return true if gradientX()/gradientY() are valid for the image
+         */
+        bool updateGradients(const cv::Mat& inputMat, uint64_t imageId, int kernelSize);
+
+        /**
+         * @brief Horizontal and vertical gradients (CV_16S), exactly as applyCanny computes them
+         */
+        const cv::Mat& gradientX() const { return dxMat_; }
+        const cv::Mat& gradientY() const { return dyMat_; }
+
+        /**
+         * @brief Forget all cached stages (buffers are kept for reuse)
+         */
+        void invalidate();
+
+        /**
+         * @brief First stage the last run() recomputed
+         */
+        CannyStage lastRecomputed() const { return lastRecomputed_; }
+
+        /**
+         * @brief Send stage timings to a stats recorder (null = none)
+         */
+        void setStats(StatsRecorder* stats) { stats_ = stats; }
+
+    private:
+        void computeGradients(const cv::Mat& inputMat, uint64_t imageId, int kernelSize);
+
+        // Stage keys
+        uint64_t imageId_;
+        int width_;
+        int height_;
+        int type_;
+        int kernelSize_;
+        double lowThreshold_;
+        double highThreshold_;
+
+        // A stage is only valid while every earlier stage is
+        bool grayValid_;
+        bool gradientsValid_;
+        bool edgesValid_;
+
+        CannyStage lastRecomputed_;
+        StatsRecorder* stats_;
+
+        cv::Mat grayMat_;
+        cv::Mat blurredMat_;        // Only for kernels without a fused gradient filter
+        BlurBuffers blurBuffers_;
+        cv::Mat dxMat_;             // Horizontal Sobel gradient (CV_16S)
+        cv::Mat dyMat_;             // Vertical Sobel gradient (CV_16S)
+        cv::Mat edgeMat_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // CANNY_STAGES_H
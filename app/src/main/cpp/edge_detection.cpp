@@ -5,16 +5,31 @@
 // Created by my lapi on 08-10-2025.
 //
 #include "image_processor.h"
+#include "canny_stages.h"
+#include "gradient_filters.h"
+#include "processing_stats.h"
+#include "log.h"
+#include "trace.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
-#include <android/log.h>
+#include <algorithm>
+#include <cmath>
 
 #define LOG_TAG "EdgeDetection"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 namespace EdgeDetection {
 
+/**
+ * @brief Buffers for the overloads without a Workspace parameter
+ *
+ * Per thread, so repeated calls reuse their intermediates instead of
+ * allocating them on every frame.
+ */
+    static Workspace& threadWorkspace() {
+        static thread_local Workspace workspace;
+        return workspace;
+    }
+
 /**
  * @brief Apply Canny edge detection to input image
  * @param inputMat Input image matrix (BGR or RGBA format)
@@ -27,38 +42,60 @@ namespace EdgeDetection {
     bool applyCanny(const cv::Mat& inputMat, cv::Mat& outputMat,
                     double lowThreshold = 100.0, double highThreshold = 200.0,
                     int kernelSize = 3) {
+        return applyCanny(inputMat, outputMat, lowThreshold, highThreshold, kernelSize,
+                          threadWorkspace());
+    }
+
+/**
+ * @brief Apply Canny edge detection reusing the caller's intermediate buffers
+ * @param inputMat Input image matrix (BGR or RGBA format)
+ * @param outputMat Output edge image (single channel)
+ * @param lowThreshold Lower threshold for edge detection
+ * @param highThreshold Upper threshold for edge detection
+ * @param kernelSize Gaussian blur kernel size
+ * @param workspace Buffers for the grayscale and gradient intermediates
+ * @return true if successful, false otherwise
+ */
+    bool applyCanny(const cv::Mat& inputMat, cv::Mat& outputMat,
+                    double lowThreshold, double highThreshold,
+                    int kernelSize, Workspace& workspace) {
         try {
             if (inputMat.empty()) {
-                LOGE("Input matrix is empty");
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Input matrix is empty");
                 return false;
             }
 
-            cv::Mat grayMat;
+            cv::Mat& grayMat = workspace.grayMat;
 
             // Convert to grayscale if needed
-            if (inputMat.channels() == 4) {
-                cv::cvtColor(inputMat, grayMat, cv::COLOR_RGBA2GRAY);
-            } else if (inputMat.channels() == 3) {
-                cv::cvtColor(inputMat, grayMat, cv::COLOR_BGR2GRAY);
-            } else {
-                grayMat = inputMat.clone();
+            {
+                TRACE_SCOPE("gray");
+                ScopedStageTimer timer(workspace.stats, ProcessingStage::Gray);
+                convertToGray(inputMat, grayMat);
             }
 
-            // Apply Gaussian blur for noise reduction
-            cv::Mat blurredMat;
-            cv::GaussianBlur(grayMat, blurredMat, cv::Size(kernelSize, kernelSize), 1.4);
+            // Gradients of the blurred image; small kernels fuse blur and Sobel into one pass
+            {
+                TRACE_SCOPE("blur");
+                ScopedStageTimer timer(workspace.stats, ProcessingStage::Blur);
+                cannyGradients(grayMat, kernelSize, workspace.blurredMat, workspace.blurBuffers,
+                               workspace.dxMat, workspace.dyMat);
+            }
 
-            // Apply Canny edge detection
-            cv::Canny(blurredMat, outputMat, lowThreshold, highThreshold, 3, false);
+            // Non-maximum suppression and hysteresis on those gradients
+            {
+                TRACE_SCOPE("canny");
+                ScopedStageTimer timer(workspace.stats, ProcessingStage::Canny);
+                cv::Canny(workspace.dxMat, workspace.dyMat, outputMat, lowThreshold, highThreshold, false);
+            }
 
-            LOGI("Canny edge detection completed successfully");
             return true;
 
         } catch (const cv::Exception& e) {
-            LOGE("OpenCV exception in applyCanny: %s", e.what());
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in applyCanny: %s", e.what());
             return false;
         } catch (const std::exception& e) {
-            LOGE("Standard exception in applyCanny: %s", e.what());
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "Standard exception in applyCanny: %s", e.what());
             return false;
         }
     }
@@ -73,45 +110,45 @@ namespace EdgeDetection {
     bool applySobel(const cv::Mat& inputMat, cv::Mat& outputMat, int kernelSize = 3) {
         try {
             if (inputMat.empty()) {
-                LOGE("Input matrix is empty for Sobel");
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Input matrix is empty for Sobel");
                 return false;
             }
 
-            cv::Mat grayMat;
-
-            // Convert to grayscale if needed
-            if (inputMat.channels() == 4) {
-                cv::cvtColor(inputMat, grayMat, cv::COLOR_RGBA2GRAY);
-            } else if (inputMat.channels() == 3) {
-                cv::cvtColor(inputMat, grayMat, cv::COLOR_BGR2GRAY);
-            } else {
-                grayMat = inputMat.clone();
+            const GradientKernel* kernel = sobelGradientKernel(kernelSize);
+            if (!kernel) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Invalid Sobel kernel size: %d", kernelSize);
+                return false;
             }
 
-            // Apply Gaussian blur
-            cv::Mat blurredMat;
-            cv::GaussianBlur(grayMat, blurredMat, cv::Size(3, 3), 0);
+            Workspace& workspace = threadWorkspace();
+            cv::Mat& grayMat = workspace.grayMat;
+            convertToGray(inputMat, grayMat);
 
-            // Compute Sobel derivatives
-            cv::Mat sobelX, sobelY;
-            cv::Sobel(blurredMat, sobelX, CV_64F, 1, 0, kernelSize);
-            cv::Sobel(blurredMat, sobelY, CV_64F, 0, 1, kernelSize);
+            // 3x3 blur and Sobel derivatives in one pass; saturating at 16 bits
+            // only affects magnitudes far above 255
+            cv::Mat& sobelX = workspace.dxMat;
+            cv::Mat& sobelY = workspace.dyMat;
+            gradientFilter(grayMat, *kernel, sobelX, sobelY, workspace.blurBuffers.row);
 
-            // Compute magnitude
-            cv::Mat magnitude;
-            cv::magnitude(sobelX, sobelY, magnitude);
-
-            // Convert to 8-bit
-            magnitude.convertTo(outputMat, CV_8UC1);
+            // Magnitude, rounded and saturated to 8 bits
+            outputMat.create(grayMat.rows, grayMat.cols, CV_8UC1);
+            for (int y = 0; y < outputMat.rows; y++) {
+                const short* dx = sobelX.ptr<short>(y);
+                const short* dy = sobelY.ptr<short>(y);
+                uchar* out = outputMat.ptr<uchar>(y);
+                for (int x = 0; x < outputMat.cols; x++) {
+                    float magnitude = std::sqrt(static_cast<float>(dx[x]) * dx[x] + static_cast<float>(dy[x]) * dy[x]);
+                    out[x] = static_cast<uchar>(std::min(magnitude + 0.5f, 255.0f));
+                }
+            }
 
-            LOGI("Sobel edge detection completed successfully");
             return true;
 
         } catch (const cv::Exception& e) {
-            LOGE("OpenCV exception in applySobel: %s", e.what());
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in applySobel: %s", e.what());
             return false;
         } catch (const std::exception& e) {
-            LOGE("Standard exception in applySobel: %s", e.what());
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "Standard exception in applySobel: %s", e.what());
             return false;
         }
     }
@@ -123,30 +160,129 @@ namespace EdgeDetection {
  * @return true if successful, false otherwise
  */
     bool edgeToRGBA(const cv::Mat& edgeMat, cv::Mat& rgbaMat) {
+        TRACE_SCOPE("edgeToRGBA");
         try {
             if (edgeMat.empty()) {
-                LOGE("Edge matrix is empty");
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Edge matrix is empty");
                 return false;
             }
 
             // Convert single channel edge image to RGBA
             // White edges on transparent background
-            std::vector<cv::Mat> channels(4);
-            channels[0] = edgeMat; // Blue channel
-            channels[1] = edgeMat; // Green channel
-            channels[2] = edgeMat; // Red channel
-            channels[3] = edgeMat; // Alpha channel
+            // Headers in a plain array, not a std::vector, so nothing is heap-allocated per frame
+            const cv::Mat channels[4] = {
+                    edgeMat,    // Blue channel
+                    edgeMat,    // Green channel
+                    edgeMat,    // Red channel
+                    edgeMat     // Alpha channel
+            };
 
-            cv::merge(channels, rgbaMat);
+            cv::merge(channels, 4, rgbaMat);
 
             return true;
 
         } catch (const cv::Exception& e) {
-            LOGE("OpenCV exception in edgeToRGBA: %s", e.what());
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in edgeToRGBA: %s", e.what());
             return false;
         }
     }
 
+    // Gradient direction steps per eighth of a turn (256 per turn)
+    static constexpr int kOctantSteps = 32;
+
+    // Second-order term of the arctangent approximation, 0.273 rad in direction steps
+    static constexpr float kAtanCorrection = 11.12f;
+
+/**
+ * @brief Direction of the gradient (dx, dy) in 256 steps per turn, from +x towards +y
+ *
+ * atan(t) ~ t * pi / 4 + 0.273 t (1 - t) on the first octant (error under
+ * 0.004 rad, a sixth of a step before rounding), unfolded to the full turn
+ * by symmetry.
+ */
+    static uchar directionStep(int dx, int dy) {
+        int ax = std::abs(dx);
+        int ay = std::abs(dy);
+        if (ax == 0 && ay == 0) {
+            return 0;
+        }
+        float t = static_cast<float>(std::min(ax, ay)) / static_cast<float>(std::max(ax, ay));
+        float angle = t * (kOctantSteps + kAtanCorrection * (1.0f - t));
+        if (ay > ax) {
+            angle = 2 * kOctantSteps - angle;
+        }
+        if (dx < 0) {
+            angle = 4 * kOctantSteps - angle;
+        }
+        if (dy < 0) {
+            angle = 8 * kOctantSteps - angle;
+        }
+        return static_cast<uchar>(static_cast<int>(angle + 0.5f) & 0xFF);
+    }
+
+/**
+ * @brief Pack edges with their gradient magnitude, direction and strength into RGBA
+ * @param edgeMat Input edge image (single channel)
+ * @param dxMat Horizontal gradient (CV_16S) of the same pixels
+ * @param dyMat Vertical gradient (CV_16S) of the same pixels
+ * @param lowThreshold Lower threshold the edges were detected with
+ * @param highThreshold Upper threshold the edges were detected with
+ * @param rgbaMat Output RGBA image
+ * @return true if successful, false otherwise
+ */
+    bool edgeToPackedRGBA(const cv::Mat& edgeMat, const cv::Mat& dxMat, const cv::Mat& dyMat,
+                          double lowThreshold, double highThreshold, cv::Mat& rgbaMat) {
+        TRACE_SCOPE("edgeToPackedRGBA");
+        try {
+            if (edgeMat.empty() || dxMat.size() != edgeMat.size() || dyMat.size() != edgeMat.size()) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Edge or gradient matrix is empty or mismatched");
+                return false;
+            }
+
+            // Strength is relative to the threshold cv::Canny compared the magnitudes with
+            int low;
+            int high;
+            cannyThresholds(lowThreshold, highThreshold, low, high);
+
+            rgbaMat.create(edgeMat.rows, edgeMat.cols, CV_8UC4);
+            for (int y = 0; y < edgeMat.rows; y++) {
+                const uchar* edges = edgeMat.ptr<uchar>(y);
+                const short* dx = dxMat.ptr<short>(y);
+                const short* dy = dyMat.ptr<short>(y);
+                uchar* out = rgbaMat.ptr<uchar>(y);
+                for (int x = 0; x < edgeMat.cols; x++) {
+                    int magnitude = std::abs(dx[x]) + std::abs(dy[x]);
+                    int strength = 0;
+                    if (edges[x]) {
+                        strength = magnitude > high || high <= 0 ? 255 : magnitude * 255 / high;
+                    }
+                    out[4 * x + 0] = edges[x];
+                    out[4 * x + 1] = static_cast<uchar>(std::min(magnitude >> 2, 255));
+                    out[4 * x + 2] = directionStep(dx[x], dy[x]);
+                    out[4 * x + 3] = static_cast<uchar>(strength);
+                }
+            }
+
+            return true;
+
+        } catch (const cv::Exception& e) {
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in edgeToPackedRGBA: %s", e.what());
+            return false;
+        }
+    }
+
+/**
+ * @brief Expand edges and the workspace's gradients of the same pixels into its output format
+ */
+    static bool expandEdges(const cv::Mat& edgeMat, const cv::Mat& dxMat, const cv::Mat& dyMat,
+                            double lowThreshold, double highThreshold, OutputFormat format,
+                            cv::Mat& rgbaMat) {
+        if (format == OutputFormat::Packed) {
+            return edgeToPackedRGBA(edgeMat, dxMat, dyMat, lowThreshold, highThreshold, rgbaMat);
+        }
+        return edgeToRGBA(edgeMat, rgbaMat);
+    }
+
 /**
  * @brief Process camera frame with optimized parameters for real-time performance
  * @param inputData Input frame data (RGBA format)
@@ -156,30 +292,56 @@ namespace EdgeDetection {
  * @return true if successful, false otherwise
  */
     bool processFrame(const uint8_t* inputData, int width, int height, uint8_t* outputData) {
+        // Optimized parameters for real-time
+        return processFrame(inputData, width, height, outputData, 50.0, 150.0, 3, threadWorkspace());
+    }
+
+/**
+ * @brief Process camera frame with explicit parameters and reusable buffers
+ * @param inputData Input frame data (RGBA format)
+ * @param width Frame width
+ * @param height Frame height
+ * @param outputData Output processed frame data
+ * @param lowThreshold Lower threshold for edge detection
+ * @param highThreshold Upper threshold for edge detection
+ * @param blurKernel Gaussian blur kernel size
+ * @param workspace Intermediate buffers owned by the caller
+ * @return true if successful, false otherwise
+ */
+    bool processFrame(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                      double lowThreshold, double highThreshold, int blurKernel,
+                      Workspace& workspace) {
+        TRACE_SCOPE("processFrame");
         try {
             if (!inputData || !outputData) {
-                LOGE("Invalid input or output data pointers");
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Invalid input or output data pointers");
                 return false;
             }
 
             // Create OpenCV Mat from input data
             cv::Mat inputMat(height, width, CV_8UC4, (void*)inputData);
 
-            // Apply Canny edge detection with optimized parameters for real-time
-            cv::Mat edgeMat;
-            if (!applyCanny(inputMat, edgeMat, 50.0, 150.0, 3)) {
-                LOGE("Failed to apply Canny edge detection");
+            // Apply Canny edge detection
+            cv::Mat& edgeMat = workspace.edgeMat;
+            if (!applyCanny(inputMat, edgeMat, lowThreshold, highThreshold, blurKernel, workspace)) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Failed to apply Canny edge detection");
                 return false;
             }
 
             // Convert edges to RGBA format
-            cv::Mat outputMat;
-            if (!edgeToRGBA(edgeMat, outputMat)) {
-                LOGE("Failed to convert edges to RGBA");
-                return false;
+            cv::Mat& outputMat = workspace.rgbaMat;
+            {
+                ScopedStageTimer timer(workspace.stats, ProcessingStage::Rgba);
+                if (!expandEdges(edgeMat, workspace.dxMat, workspace.dyMat, lowThreshold, highThreshold,
+                                 workspace.outputFormat, outputMat)) {
+                    LOGE_EVERY_MS(kFrameLogIntervalMs, "Failed to convert edges to RGBA");
+                    return false;
+                }
             }
 
             // Copy processed data to output buffer
+            TRACE_SCOPE("copyOutput");
+            ScopedStageTimer copyTimer(workspace.stats, ProcessingStage::Copy);
             if (outputMat.isContinuous()) {
                 memcpy(outputData, outputMat.data, width * height * 4);
             } else {
@@ -194,10 +356,103 @@ namespace EdgeDetection {
             return true;
 
         } catch (const cv::Exception& e) {
-            LOGE("OpenCV exception in processFrame: %s", e.what());
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in processFrame: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "Standard exception in processFrame: %s", e.what());
+            return false;
+        }
+    }
+
+/**
+ * @brief Rows of context a band needs above and below its output rows
+ *
+ * Blur support plus one row each for the Sobel and non-maximum suppression
+ * neighbourhoods makes the gradients exact at the band edge. The extra margin
+ * lets hysteresis follow weak edges across the cut; a weak chain that only
+ * reaches a strong pixel beyond the margin is lost in this band, so banded
+ * output can miss edges whole-frame processing keeps (edge_bench --check-bands
+ * bounds how many).
+ * @param blurKernel Gaussian blur kernel size
+ * @return Halo height in rows
+ */
+    int tileHaloRows(int blurKernel) {
+        const int hysteresisMargin = 8;
+        return blurSupportRadius(blurKernel) + 2 + hysteresisMargin;
+    }
+
+/**
+ * @brief Number of row bands to split a frame into for parallel processing
+ *
+ * Several bands per worker keep every core busy when band costs differ;
+ * the minimum band height bounds the halo rows processed twice.
+ * @param height Frame height in pixels
+ * @param workers Worker threads available
+ * @return Band count, at least 1
+ */
+    int frameBandCount(int height, int workers) {
+        return std::max(1, std::min(workers * kBandsPerWorker, height / kMinBandRows));
+    }
+
+/**
+ * @brief Process one horizontal band of a frame
+ * @param inputData Full input frame data (RGBA format)
+ * @param width Frame width
+ * @param height Frame height
+ * @param outputData Full output frame data; only rows [rowStart, rowEnd) are written
+ * @param rowStart First output row of the band
+ * @param rowEnd One past the last output row of the band
+ * @param lowThreshold Lower threshold for edge detection
+ * @param highThreshold Upper threshold for edge detection
+ * @param blurKernel Gaussian blur kernel size
+ * @param workspace Intermediate buffers owned by the calling worker
+ * @return true if successful, false otherwise
+ */
+    bool processFrameRows(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                          int rowStart, int rowEnd,
+                          double lowThreshold, double highThreshold, int blurKernel,
+                          Workspace& workspace) {
+        TRACE_SCOPE("band");
+        try {
+            if (!inputData || !outputData || rowStart < 0 || rowEnd > height || rowStart >= rowEnd) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Invalid band [%d, %d) for frame height %d",
+                              rowStart, rowEnd, height);
+                return false;
+            }
+
+            // Input band including halo rows, clipped to the frame
+            int halo = tileHaloRows(blurKernel);
+            int top = std::max(0, rowStart - halo);
+            int bottom = std::min(height, rowEnd + halo);
+            size_t rowBytes = static_cast<size_t>(width) * 4;
+            cv::Mat inputBand(bottom - top, width, CV_8UC4,
+                              (void*)(inputData + top * rowBytes));
+
+            cv::Mat& edgeMat = workspace.edgeMat;
+            if (!applyCanny(inputBand, edgeMat, lowThreshold, highThreshold, blurKernel, workspace)) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Failed to apply Canny edge detection to band");
+                return false;
+            }
+
+            // Expand only the band's own rows straight into the output frame
+            cv::Mat edgeRows = edgeMat.rowRange(rowStart - top, rowEnd - top);
+            cv::Mat dxRows = workspace.dxMat.rowRange(rowStart - top, rowEnd - top);
+            cv::Mat dyRows = workspace.dyMat.rowRange(rowStart - top, rowEnd - top);
+            cv::Mat outputRows(rowEnd - rowStart, width, CV_8UC4, outputData + rowStart * rowBytes);
+            ScopedStageTimer timer(workspace.stats, ProcessingStage::Rgba);
+            if (!expandEdges(edgeRows, dxRows, dyRows, lowThreshold, highThreshold, workspace.outputFormat,
+                             outputRows)) {
+                LOGE_EVERY_MS(kFrameLogIntervalMs, "Failed to convert band edges to RGBA");
+                return false;
+            }
+
+            return true;
+
+        } catch (const cv::Exception& e) {
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in processFrameRows: %s", e.what());
             return false;
         } catch (const std::exception& e) {
-            LOGE("Standard exception in processFrame: %s", e.what());
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "Standard exception in processFrameRows: %s", e.what());
             return false;
         }
     }
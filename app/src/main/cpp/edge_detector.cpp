@@ -0,0 +1,479 @@
+//
+// Per-instance edge detection pipeline (replaces the process-wide JNI globals)
+//
+#include "edge_detector.h"
+#include "log.h"
+#include "mat_allocator.h"
+#include "tiled_canny.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#define LOG_TAG "EdgeDetector"
+
+namespace EdgeDetection {
+
+    EdgeDetector::EdgeDetector()
+            : referenceProgressive_(false),
+              staticFrames_(0),
+              frameFormat_(OutputFormat::Mask),
+              interlacePhase_(0),
+              compositeInterlace_(0),
+              compositeBands_(0),
+              compositeVersion_(0),
+              uploadedNs_(0),
+              uploadPending_(false),
+              interlace_(1),
+              outputFormat_(OutputFormat::Mask),
+              droppedBaseline_(0),
+              warmUpMs_(0.0),
+              scheduler_(mailbox_, &stats_, [this](const FrameSlot& frame) {
+                  if (!processFrameProgressive(frame.data.data(), frame.width, frame.height,
+                                               frame.timestampNs)) {
+                      LOGE_EVERY_MS(kFrameLogIntervalMs, "Frame processing failed");
+                  }
+              }) {
+        workspace_.stats = &stats_;
+        DetectorParameters params = parameters_.snapshot();
+        stats_.setParameters(params.lowThreshold, params.highThreshold, params.blurKernel);
+    }
+
+    bool EdgeDetector::processFrame(const uint8_t* inputData, int width, int height,
+                                    uint8_t* outputData) {
+        return runFrame(inputData, width, height, outputData, nullptr, true, 0);
+    }
+
+    bool EdgeDetector::processFrameProgressive(const uint8_t* inputData, int width, int height,
+                                               int64_t captureNs) {
+        return runFrame(inputData, width, height, nullptr, &progressive_, true, captureNs);
+    }
+
+    bool EdgeDetector::runFrame(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                                ProgressiveFrame* progressive, bool liveFrame, int64_t captureNs) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        // One consistent parameter set per frame, however often the UI publishes
+        DetectorParameters params = parameters_.snapshot();
+
+        // Reduced-cost modes apply to live frames only; warm-up runs the full pipeline
+        int interlace = liveFrame && inputData ? interlace_.load(std::memory_order_relaxed) : 1;
+
+        // Outputs kept in the previous format must not be published or composited again
+        OutputFormat outputFormat = outputFormat_.load(std::memory_order_relaxed);
+        if (outputFormat != frameFormat_) {
+            motionGate_.reset();
+            compositeInterlace_ = 0;
+            frameFormat_ = outputFormat;
+        }
+        workspace_.outputFormat = outputFormat;
+
+        bool gateActive = liveFrame && inputData && motionGate_.enabled();
+        bool unchanged = false;
+        if (gateActive) {
+            {
+                ScopedStageTimer timer(&stats_, ProcessingStage::Gate);
+                unchanged = motionGate_.isStatic(inputData, width, height, params.version);
+            }
+            // Interlaced output is only whole once every band was refreshed since the scene settled
+            if (unchanged && staticFrames_ >= interlace - 1 &&
+                referenceProgressive_ == (progressive != nullptr)) {
+                // Static scene: publish the previous output again instead of recomputing it
+                if (progressive) {
+                    progressive->repeatFrame();
+                } else if (outputData) {
+                    ScopedStageTimer timer(&stats_, ProcessingStage::Copy);
+                    std::memcpy(outputData, lastOutput_.data, static_cast<size_t>(width) * height * 4);
+                } else {
+                    return false;
+                }
+                stats_.recordSkipped();
+                return true;
+            }
+        } else {
+            // Frames processed without the gate leave its reference behind
+            motionGate_.reset();
+        }
+
+        bool success;
+        int bandCount = pool_ ? frameBandCount(height, pool_->size()) : 1;
+        if (progressive) {
+            bandCount = std::min(bandCount, ProgressiveFrame::kMaxBands);
+        }
+        if (interlace > 1) {
+            // Whole interleave groups, so every band is refreshed equally often
+            bandCount = std::max(bandCount - bandCount % interlace, interlace);
+        }
+        if (progressive) {
+            outputData = progressive->beginFrame(width, height, bandCount, captureNs);
+        }
+        // Shifting needs one coherent previous frame, which an interlaced composite is not,
+        // and only carries edge masks
+        bool compensate = liveFrame && inputData && interlace == 1 && outputFormat == OutputFormat::Mask &&
+                          motionCompensator_.enabled();
+        bool reused = compensate &&
+                      motionCompensator_.reuse(inputData, width, height, params, outputData, &stats_);
+        if (reused) {
+            success = true;
+            if (progressive) {
+                for (int band = 0; band < bandCount; band++) {
+                    progressive->markBandReady(band);
+                }
+            }
+        } else if (interlace > 1 && inputData && outputData) {
+            success = processInterlaced(inputData, width, height, outputData, params, bandCount, interlace,
+                                        progressive);
+        } else if (bandCount > 1 && inputData && outputData) {
+            std::atomic<bool> bandFailed(false);
+            uint64_t traceFrame = TRACE_CURRENT_FRAME();
+            if (bandWorkspaces_.size() != static_cast<size_t>(bandCount)) {
+                bandWorkspaces_.resize(bandCount);
+            }
+            pool_->parallelFor(bandCount, [&](int band) {
+                TRACE_FRAME(traceFrame);
+                Workspace& workspace = bandWorkspaces_[band];
+                workspace.stats = &stats_;
+                workspace.outputFormat = outputFormat;
+                if (!processFrameRows(inputData, width, height, outputData,
+                                      height * band / bandCount, height * (band + 1) / bandCount,
+                                      params.lowThreshold, params.highThreshold, params.blurKernel,
+                                      workspace)) {
+                    bandFailed.store(true, std::memory_order_relaxed);
+                } else if (progressive) {
+                    // The GL thread may upload these rows while the other bands still run
+                    progressive->markBandReady(band);
+                }
+            });
+            success = !bandFailed.load(std::memory_order_relaxed);
+        } else {
+            success = EdgeDetection::processFrame(inputData, width, height, outputData,
+                                                  params.lowThreshold, params.highThreshold,
+                                                  params.blurKernel, workspace_);
+            if (success && progressive) {
+                progressive->markBandReady(0);
+            }
+        }
+        if (progressive) {
+            progressive->endFrame(success);
+        }
+        if (!success) {
+            motionGate_.reset();
+            motionCompensator_.reset();
+            staticFrames_ = 0;
+            return false;
+        }
+
+        if (reused) {
+            stats_.recordReused();
+        } else if (compensate) {
+            motionCompensator_.update(outputData);
+        } else {
+            motionCompensator_.reset();
+        }
+
+        if (gateActive) {
+            if (!progressive) {
+                ScopedStageTimer timer(&stats_, ProcessingStage::Copy);
+                lastOutput_.create(height, width, CV_8UC4);
+                std::memcpy(lastOutput_.data, outputData, static_cast<size_t>(width) * height * 4);
+            }
+            referenceProgressive_ = progressive != nullptr;
+            motionGate_.accept();
+            staticFrames_ = unchanged ? staticFrames_ + 1 : 0;
+        }
+
+        auto frameEnd = std::chrono::steady_clock::now();
+        int64_t frameNs = std::chrono::duration_cast<std::chrono::nanoseconds>(frameEnd - frameStart).count();
+        int frames = stats_.recordFrame(frameNs, static_cast<uint64_t>(width) * height * 4, bandCount);
+
+        if (frames % 30 == 0) {  // Log every 30 frames
+            LOGD("Frame %d processed in %.2f ms, Average FPS: %.2f",
+                 frames, frameNs / 1e6, stats_.snapshot().averageFps);
+        }
+
+        return true;
+    }
+
+    bool EdgeDetector::processInterlaced(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                                         const DetectorParameters& params, int bandCount, int interlace,
+                                         ProgressiveFrame* progressive) {
+        // Bands skipped this frame come from the composite, so it must hold a whole
+        // earlier frame of this size, parameter set and band layout
+        bool complete = composite_.cols == width && composite_.rows == height &&
+                        compositeInterlace_ == interlace && compositeBands_ == bandCount &&
+                        compositeVersion_ == params.version;
+        composite_.create(height, width, CV_8UC4);
+        int phase = static_cast<int>(interlacePhase_++ % interlace);
+
+        std::atomic<bool> bandFailed(false);
+        uint64_t traceFrame = TRACE_CURRENT_FRAME();
+        if (bandWorkspaces_.size() != static_cast<size_t>(bandCount)) {
+            bandWorkspaces_.resize(bandCount);
+        }
+        size_t rowBytes = static_cast<size_t>(width) * 4;
+        auto runBand = [&](int band) {
+            TRACE_FRAME(traceFrame);
+            int rowStart = height * band / bandCount;
+            int rowEnd = height * (band + 1) / bandCount;
+            if (!complete || band % interlace == phase) {
+                // Halo rows are read from the current input, so a refreshed band matches
+                // the full-quality banded output whatever age the neighbouring bands of the
+                // composite are (itself approximate at band borders, see tileHaloRows)
+                Workspace& workspace = bandWorkspaces_[band];
+                workspace.stats = &stats_;
+                workspace.outputFormat = frameFormat_;
+                if (!processFrameRows(inputData, width, height, composite_.data, rowStart, rowEnd,
+                                      params.lowThreshold, params.highThreshold, params.blurKernel,
+                                      workspace)) {
+                    bandFailed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            {
+                ScopedStageTimer timer(&stats_, ProcessingStage::Copy);
+                std::memcpy(outputData + rowStart * rowBytes, composite_.data + rowStart * rowBytes,
+                            (rowEnd - rowStart) * rowBytes);
+            }
+            if (progressive) {
+                progressive->markBandReady(band);
+            }
+        };
+        if (pool_) {
+            pool_->parallelFor(bandCount, runBand);
+        } else {
+            for (int band = 0; band < bandCount; band++) {
+                runBand(band);
+            }
+        }
+
+        bool success = !bandFailed.load(std::memory_order_relaxed);
+        compositeInterlace_ = success ? interlace : 0;
+        compositeBands_ = bandCount;
+        compositeVersion_ = params.version;
+        return success;
+    }
+
+    void EdgeDetector::setWorkerPool(std::shared_ptr<WorkerPool> pool) {
+        pool_ = std::move(pool);
+
+        if (pool_) {
+            // Bands are the unit of parallelism; OpenCV's own threads would oversubscribe the cores
+            cv::setNumThreads(0);
+        }
+    }
+
+    void EdgeDetector::setMotionGate(bool enabled, double threshold) {
+        motionGate_.configure(enabled, threshold);
+        LOGI("Motion gate %s (threshold %.1f)", enabled ? "enabled" : "disabled", threshold);
+    }
+
+    void EdgeDetector::setInterlace(int factor) {
+        factor = factor >= 4 ? 4 : (factor >= 2 ? 2 : 1);
+        interlace_.store(factor, std::memory_order_relaxed);
+        LOGI("Interlace factor %d", factor);
+    }
+
+    void EdgeDetector::setOutputFormat(OutputFormat format) {
+        outputFormat_.store(format, std::memory_order_relaxed);
+        LOGI("Output format %s", format == OutputFormat::Packed ? "packed" : "mask");
+    }
+
+    void EdgeDetector::setMotionCompensation(bool enabled) {
+        motionCompensator_.setEnabled(enabled);
+        LOGI("Motion compensation %s", enabled ? "enabled" : "disabled");
+    }
+
+    void EdgeDetector::startScheduler(const SchedulerConfig& config) {
+        scheduler_.start(config);
+    }
+
+    void EdgeDetector::stopScheduler() {
+        scheduler_.stop();
+    }
+
+    void EdgeDetector::frameUploaded() {
+        uploadedNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        uploadPending_ = true;
+    }
+
+    void EdgeDetector::framePresented() {
+        if (!uploadPending_) {
+            return;
+        }
+        uploadPending_ = false;
+
+        // Read now rather than at upload: the frame is closed just after its last band
+        FrameTimes times;
+        if (!progressive_.frameTimes(times)) {
+            return;
+        }
+        times.uploadNs = uploadedNs_;
+        times.presentNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        stats_.recordPresented(times);
+    }
+
+    bool EdgeDetector::processImage(const uint8_t* inputData, int width, int height,
+                                    uint8_t* outputData, uint64_t imageId) {
+        if (!inputData || !outputData || width <= 0 || height <= 0) {
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "Invalid input parameters for processImage");
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        DetectorParameters params = parameters_.snapshot();
+
+        cv::Mat inputMat(height, width, CV_8UC4, const_cast<uint8_t*>(inputData));
+        cv::Mat edgeMat;
+        stillStages_.setStats(&stats_);
+        if (!stillStages_.run(inputMat, imageId, params.lowThreshold, params.highThreshold,
+                              params.blurKernel, edgeMat)) {
+            return false;
+        }
+
+        // Unchanged edges already sit expanded in stillRgba_
+        if (stillStages_.lastRecomputed() != CannyStage::None || stillRgba_.empty()) {
+            ScopedStageTimer timer(&stats_, ProcessingStage::Rgba);
+            if (!edgeToRGBA(edgeMat, stillRgba_)) {
+                return false;
+            }
+        }
+        {
+            ScopedStageTimer timer(&stats_, ProcessingStage::Copy);
+            std::memcpy(outputData, stillRgba_.data, static_cast<size_t>(width) * height * 4);
+        }
+
+        LOGD("Image %llu (%dx%d) processed from stage %d in %.2f ms",
+             static_cast<unsigned long long>(imageId), width, height,
+             static_cast<int>(stillStages_.lastRecomputed()),
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return true;
+    }
+
+    bool EdgeDetector::processLargeImage(const uint8_t* inputData, int width, int height,
+                                         uint8_t* outputData) {
+        if (!inputData || !outputData || width <= 0 || height <= 0) {
+            LOGE("Invalid input parameters for processLargeImage");
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        DetectorParameters params = parameters_.snapshot();
+
+        cv::Mat inputMat(height, width, CV_8UC4, const_cast<uint8_t*>(inputData));
+        cv::Mat outputMat(height, width, CV_8UC4, outputData);
+        std::atomic<bool> expandFailed(false);
+        bool success = applyCannyTiled(
+                inputMat, params.lowThreshold, params.highThreshold, params.blurKernel,
+                [&](const cv::Rect& tile, const cv::Mat& edges) {
+                    // Tiles are disjoint, so workers expand straight into the output
+                    cv::Mat outputTile = outputMat(tile);
+                    if (!edgeToRGBA(edges, outputTile)) {
+                        expandFailed.store(true, std::memory_order_relaxed);
+                    }
+                },
+                pool_.get());
+
+        LOGI("Large image %dx%d processed in tiles in %.1f ms", width, height,
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return success && !expandFailed.load(std::memory_order_relaxed);
+    }
+
+    double EdgeDetector::warmUp(int width, int height, int frames) {
+        if (width <= 0 || height <= 0 || frames <= 0) {
+            return 0.0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        mailbox_.reserve(width, height);
+        progressive_.reserve(width, height);
+
+        // Gradient overlaid with a block grid: every Canny stage, hysteresis included,
+        // sees real edges, and the dense rows exercise the pool's stealing too
+        size_t bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+        std::vector<uint8_t> input(bytes);
+        std::vector<uint8_t> output(bytes);
+        for (int y = 0; y < height; y++) {
+            uint8_t* row = input.data() + static_cast<size_t>(y) * width * 4;
+            for (int x = 0; x < width; x++) {
+                bool block = ((x >> 5) ^ (y >> 5)) & 1;
+                uint8_t value = static_cast<uint8_t>(((x + y) >> 2) ^ (block ? 0xC0 : 0));
+                row[x * 4 + 0] = value;
+                row[x * 4 + 1] = value;
+                row[x * 4 + 2] = value;
+                row[x * 4 + 3] = 255;
+            }
+        }
+
+        double firstMs = 0.0;
+        double lastMs = 0.0;
+        for (int i = 0; i < frames; i++) {
+            auto frameStart = std::chrono::steady_clock::now();
+            // The gate would skip all but the first of these identical frames
+            if (!runFrame(input.data(), width, height, output.data(), nullptr, false, 0)) {
+                LOGE("Warm-up frame %d at %dx%d failed", i, width, height);
+                resetStats();
+                return -1.0;
+            }
+            lastMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - frameStart).count();
+            if (i == 0) {
+                firstMs = lastMs;
+            }
+        }
+
+        // Synthetic frames must not show up in the real frame statistics
+        resetStats();
+
+        double totalMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        warmUpMs_.store(totalMs, std::memory_order_relaxed);
+        LOGI("Warmed up for %dx%d in %.1f ms (%d frames, first %.2f ms, last %.2f ms)",
+             width, height, totalMs, frames, firstMs, lastMs);
+        return totalMs;
+    }
+
+    ProcessingStats EdgeDetector::getStats() const {
+        ProcessingStats stats = stats_.snapshot();
+        stats.warmUpMs = warmUpMs_.load(std::memory_order_relaxed);
+
+        // Frames replaced in the mailbox before the processing thread got to them
+        uint64_t mailboxDropped = mailbox_.droppedFrames() - droppedBaseline_.load(std::memory_order_relaxed);
+        stats.framesDropped += static_cast<int>(mailboxDropped);
+
+        if (pool_) {
+            PoolStats poolStats = pool_->stats();
+            stats.tasksStolen = poolStats.tasksStolen;
+            stats.failedSteals = poolStats.failedSteals;
+            stats.workerIdleMs = poolStats.idleTimeMs;
+        }
+        if (const PooledMatAllocator* allocator = PooledMatAllocator::installed()) {
+            allocator->reportTo(stats);
+        }
+        return stats;
+    }
+
+    void EdgeDetector::resetStats() {
+        stats_.reset();
+        droppedBaseline_.store(mailbox_.droppedFrames(), std::memory_order_relaxed);
+    }
+
+    DetectorParameters EdgeDetector::updateParameters(double lowThreshold, double highThreshold,
+                                                      int blurKernel) {
+        DetectorParameters requested;
+        requested.lowThreshold = lowThreshold;
+        requested.highThreshold = highThreshold;
+        requested.blurKernel = blurKernel;
+
+        DetectorParameters applied = parameters_.publish(requested);
+        stats_.setParameters(applied.lowThreshold, applied.highThreshold, applied.blurKernel);
+        return applied;
+    }
+
+    DetectorParameters EdgeDetector::getParameters() const {
+        return parameters_.snapshot();
+    }
+
+} // namespace EdgeDetection
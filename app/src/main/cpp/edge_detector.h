@@ -0,0 +1,299 @@
+#ifndef EDGE_DETECTOR_H
+#define EDGE_DETECTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "image_processor.h"
+#include "canny_stages.h"
+#include "frame_mailbox.h"
+#include "frame_scheduler.h"
+#include "motion_compensator.h"
+#include "motion_gate.h"
+#include "parameter_store.h"
+#include "processing_stats.h"
+#include "progressive_frame.h"
+#include "worker_pool.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief One independent edge detection pipeline
+ *
+ * Owns everything a stream needs: parameters, reusable workspace, the frame
+ * mailbox feeding it, its statistics and its GL buffer objects, plus a handle
+ * to the (possibly shared) worker pool its bands run on. Separate
+ * instances share no mutable state, so front/back cameras or batch workers
+ * can run side by side in one process. Java holds it as a `long nativePtr`.
+ */
+    class EdgeDetector {
+    public:
+        // Enough for OpenCV's lazy init and the pool's first steals to settle
+        static constexpr int kWarmUpFrames = 5;
+
+        EdgeDetector();
+
+        EdgeDetector(const EdgeDetector&) = delete;
+        EdgeDetector& operator=(const EdgeDetector&) = delete;
+
+        /**
+         * @brief Process camera frame with this detector's parameters
+         *
+         * With a worker pool the frame runs as parallel row bands, and the
+         * result is not exactly whole-frame applyCanny: each band runs
+         * hysteresis over its rows plus an 8-row margin (see tileHaloRows), so
+         * a weak edge chain whose strong pixels lie further away in another
+         * band is dropped on this side of the border. edge_bench --check-bands
+         * bounds the share of edge pixels that differ. processLargeImage keeps
+         * hysteresis exact across its tiles.
+         * @param inputData Input frame data (RGBA format)
+         * @param width Frame width in pixels
+         * @param height Frame height in pixels
+         * @param outputData Output processed frame data (RGBA format)
+         * @return true if successful, false otherwise
+         */
+        bool processFrame(const uint8_t* inputData, int width, int height, uint8_t* outputData);
+
+        /**
+         * @brief Process camera frame into progressiveFrame(), publishing each row band as it finishes
+         *
+         * Same pipeline as processFrame, but the GL thread can upload finished
+         * bands with takeBand() while the remaining bands are still computed.
+         * A frame the motion gate skips is announced with repeatFrame() instead,
+         * so the texture keeps the previous output without another upload.
+         * @param inputData Input frame data (RGBA format)
+         * @param width Frame width in pixels
+         * @param height Frame height in pixels
+         * @param captureNs Capture timestamp of the frame (steady clock); 0 = now
+         * @return true if successful, false otherwise
+         */
+        bool processFrameProgressive(const uint8_t* inputData, int width, int height, int64_t captureNs = 0);
+
+        /**
+         * @brief Process a paused frame or still image, reusing stages cached for it
+         *
+         * Runs with the current parameters like processFrame, but keeps every
+         * intermediate: calling again with the same imageId after a threshold
+         * change reruns only non-maximum suppression and hysteresis, after a
+         * blur kernel change only blur onward. Call from one thread at a time.
+         * @param inputData Input image data (RGBA format)
+         * @param width Image width in pixels
+         * @param height Image height in pixels
+         * @param outputData Output processed image data (RGBA format)
+         * @param imageId Identity of the image content; change it whenever the pixels change
+         * @return true if successful, false otherwise
+         */
+        bool processImage(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                          uint64_t imageId);
+
+        /**
+         * @brief Process a large still (12-48 MP) in tiles with bounded memory
+         *
+         * Uses the current parameters and this detector's worker pool. Unlike
+         * processFrame, no full-size intermediate is allocated: scratch memory
+         * is proportional to tile size times worker count, and hysteresis is
+         * still exact across tile borders.
+         * @param inputData Input image data (RGBA format)
+         * @param width Image width in pixels
+         * @param height Image height in pixels
+         * @param outputData Output processed image data (RGBA format)
+         * @return true if successful, false otherwise
+         */
+        bool processLargeImage(const uint8_t* inputData, int width, int height, uint8_t* outputData);
+
+        /**
+         * @brief Get everything ready for frames of the given size before the first real one
+         *
+         * Sizes and touches the mailbox, the progressive output and all workspaces,
+         * wakes the worker pool and runs synthetic frames through the current pipeline, so lazy OpenCV
+         * initialization, page faults and cold caches are paid here instead of as a
+         * stutter on camera start. Statistics are reset afterwards. Call before
+         * frames start flowing.
+         * @param width Expected frame width in pixels
+         * @param height Expected frame height in pixels
+         * @param frames Synthetic frames to run
+         * @return Time spent in milliseconds, or a negative value on failure
+         */
+        double warmUp(int width, int height, int frames = kWarmUpFrames);
+
+        /**
+         * @brief Get current processing statistics
+         * @return ProcessingStats structure with current metrics
+         */
+        ProcessingStats getStats() const;
+
+        /**
+         * @brief Reset processing statistics
+         */
+        void resetStats();
+
+        /**
+         * @brief Update edge detection parameters; applies from the next frame
+         *
+         * Safe from any thread and never blocks frame processing.
+         * @param lowThreshold New lower threshold
+         * @param highThreshold New upper threshold
+         * @param blurKernel New Gaussian blur kernel size
+         * @return Parameters as applied (sanitized, with their version)
+         */
+        DetectorParameters updateParameters(double lowThreshold, double highThreshold, int blurKernel);
+
+        /**
+         * @brief Get the parameters the next frame will use
+         */
+        DetectorParameters getParameters() const;
+
+        /**
+         * @brief Run frames as parallel row bands on the given pool (null = single-threaded)
+         */
+        void setWorkerPool(std::shared_ptr<WorkerPool> pool);
+
+        /**
+         * @brief Skip processFrame / processFrameProgressive calls while the scene is static
+         *
+         * A skipped frame costs only the motion gate's thumbnail and comparison;
+         * the previous output is published again. Safe from any thread and
+         * applies from the next frame. Off by default.
+         * @param enabled Whether static frames are skipped
+         * @param threshold Largest luma change (0-255) of a 1/16-scale thumbnail pixel below which a frame is static
+         */
+        void setMotionGate(bool enabled, double threshold = kDefaultMotionThreshold);
+
+        /**
+         * @brief Build frames of a panning camera from the previous edge map shifted by the global motion
+         *
+         * Applies to processFrame and processFrameProgressive; see
+         * MotionCompensator. Safe from any thread and applies from the next
+         * frame. Off by default.
+         */
+        void setMotionCompensation(bool enabled);
+
+        /**
+         * @brief Preview quality mode: refresh only every factor-th row band per frame
+         *
+         * With factor 2, even bands are recomputed on even frames and odd bands
+         * on odd ones (factor 4 cycles through four groups). The rest is
+         * composited from the previous frames, so per-frame cost drops by about
+         * the factor while the output still updates every frame. Each refreshed
+         * band reads its halo rows from the current input, so it equals what
+         * factor 1 computes for that band whatever the age of its neighbours.
+         * That is the banded result, not whole-frame applyCanny: hysteresis runs
+         * per band with an 8-row margin, so a weak chain crossing a band border
+         * may be cut there (see tileHaloRows). Applies to processFrame and
+         * processFrameProgressive. Safe from any thread and applies from the next
+         * frame.
+         * @param factor 1 (full quality, the default), 2 or 4; other values take the next lower of these, at least 1
+         */
+        void setInterlace(int factor);
+
+        /**
+         * @brief Layout of processFrame and processFrameProgressive output
+         *
+         * OutputFormat::Packed fills the three channels that otherwise repeat
+         * the edge mask with the gradient magnitude, direction and edge
+         * strength of every pixel (see edgeToPackedRGBA), taken from gradients
+         * the Canny stage computed anyway; the mask stays in R, which is all
+         * the renderer draws. Motion compensation only shifts edge masks, so
+         * it pauses while packed. Safe from any thread and applies from the
+         * next frame. OutputFormat::Mask by default.
+         */
+        void setOutputFormat(OutputFormat format);
+
+        /**
+         * @brief Process the mailbox's frames into progressiveFrame() on a native thread at a fixed rate
+         *
+         * See FrameScheduler. The scheduler is then the mailbox's only consumer,
+         * so nothing else may call processFrameProgressive until stopScheduler().
+         * Calling again while running only changes the pacing.
+         */
+        void startScheduler(const SchedulerConfig& config);
+
+        /**
+         * @brief Stop the scheduler thread, waiting for the frame in progress
+         */
+        void stopScheduler();
+
+        /**
+         * @brief Note that the last band of the consumer's progressive frame is in the texture (GL thread)
+         */
+        void frameUploaded();
+
+        /**
+         * @brief Note that a draw showing the last uploaded frame was submitted (GL thread)
+         *
+         * Completes that frame's timeline (capture, processing, upload, present)
+         * for the end-to-end latency statistics; draws repeating it count once.
+         */
+        void framePresented();
+
+        FrameMailbox& mailbox() { return mailbox_; }
+        ProgressiveFrame& progressiveFrame() { return progressive_; }
+        GLRenderer::RenderContext& renderContext() { return renderContext_; }
+
+    private:
+        bool runFrame(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                      ProgressiveFrame* progressive, bool liveFrame, int64_t captureNs);
+        bool processInterlaced(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                               const DetectorParameters& params, int bandCount, int interlace,
+                               ProgressiveFrame* progressive);
+
+        // Frame-loop state (processing thread only)
+        Workspace workspace_;
+        FrameMailbox mailbox_;
+        std::shared_ptr<WorkerPool> pool_;
+        // One per band index rather than per worker: a band's intermediates then
+        // keep their size whichever worker runs it, so steady-state frames never reallocate
+        std::vector<Workspace> bandWorkspaces_;
+
+        // Frame-level skipping of static scenes; lastOutput_ keeps processFrame's
+        // output to publish again, progressive frames keep theirs in progressive_
+        MotionGate motionGate_;
+        cv::Mat lastOutput_;
+        bool referenceProgressive_;     // Which of the two holds the gate reference's output
+        int staticFrames_;              // Frames processed since the scene settled
+
+        // Shifted edge reuse while the camera pans
+        MotionCompensator motionCompensator_;
+
+        // Format of the outputs kept above and in composite_, for reuse
+        OutputFormat frameFormat_;
+
+        // Interlaced mode: the latest result of every band
+        cv::Mat composite_;
+        uint64_t interlacePhase_;
+        int compositeInterlace_;        // Interlace factor and band layout composite_ holds; 0 = invalid
+        int compositeBands_;
+        uint64_t compositeVersion_;
+
+        // Still-image tuning state (processImage caller only)
+        CannyStageCache stillStages_;
+        cv::Mat stillRgba_;
+
+        // Processing thread to GL thread, band by band
+        ProgressiveFrame progressive_;
+
+        // GL-thread state
+        GLRenderer::RenderContext renderContext_;
+        int64_t uploadedNs_;            // When the frame awaiting its first present finished uploading
+        bool uploadPending_;
+
+        // Published by the UI thread, read once per frame
+        ParameterStore parameters_;
+        std::atomic<int> interlace_;
+        std::atomic<OutputFormat> outputFormat_;
+
+        // Updated lock-free from the processing thread and pool workers
+        StatsRecorder stats_;
+        std::atomic<uint64_t> droppedBaseline_;
+        std::atomic<double> warmUpMs_;
+
+        // Last, so its thread is stopped before anything it uses is destroyed
+        FrameScheduler scheduler_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // EDGE_DETECTOR_H
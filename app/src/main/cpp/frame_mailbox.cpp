@@ -0,0 +1,101 @@
+//
+// Latest-frame-wins mailbox between the camera producer and the processing consumer
+//
+#include "frame_mailbox.h"
+#include <chrono>
+
+namespace EdgeDetection {
+
+    FrameMailbox::FrameMailbox()
+            : writeIndex_(0),
+              nextSequence_(1),
+              readIndex_(1),
+              middle_(2),
+              published_(0),
+              dropped_(0),
+              consumerWaiting_(false),
+              interrupted_(false) {
+    }
+
+    uint8_t* FrameMailbox::beginWrite(int width, int height) {
+        FrameSlot& slot = slots_[writeIndex_];
+        size_t bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+
+        // Resized whenever the resolution changes (growing past the capacity reallocates,
+        // and new bytes are zero-filled); steady state reuses the buffer as is
+        if (slot.data.size() != bytes) {
+            slot.data.resize(bytes);
+        }
+        slot.width = width;
+        slot.height = height;
+        return slot.data.data();
+    }
+
+    void FrameMailbox::reserve(int width, int height) {
+        size_t bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+        for (FrameSlot& slot : slots_) {
+            // resize() zero-fills, which also takes the page faults now rather than on the first frames
+            slot.data.resize(bytes);
+        }
+    }
+
+    void FrameMailbox::publish(int64_t timestampNs) {
+        FrameSlot& slot = slots_[writeIndex_];
+        slot.sequence = nextSequence_++;
+        slot.timestampNs = timestampNs;
+
+        // Hand the back buffer over and take whatever sat in the middle
+        uint8_t previous = middle_.exchange(static_cast<uint8_t>(writeIndex_) | kFreshBit,
+                                            std::memory_order_seq_cst);
+        writeIndex_ = previous & kIndexMask;
+
+        published_.fetch_add(1, std::memory_order_relaxed);
+        if (previous & kFreshBit) {
+            // The consumer never saw the frame we just reclaimed
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (consumerWaiting_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            waitCondition_.notify_one();
+        }
+    }
+
+    const FrameSlot* FrameMailbox::acquireLatest() {
+        if (!(middle_.load(std::memory_order_acquire) & kFreshBit)) {
+            return nullptr;
+        }
+
+        uint8_t previous = middle_.exchange(static_cast<uint8_t>(readIndex_),
+                                            std::memory_order_acq_rel);
+        readIndex_ = previous & kIndexMask;
+        return &slots_[readIndex_];
+    }
+
+    const FrameSlot* FrameMailbox::waitForLatest(int timeoutMs) {
+        const FrameSlot* frame = acquireLatest();
+        if (frame || timeoutMs <= 0) {
+            return frame;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(waitMutex_);
+            consumerWaiting_.store(true, std::memory_order_seq_cst);
+            waitCondition_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+                return (middle_.load(std::memory_order_seq_cst) & kFreshBit) ||
+                       interrupted_.load(std::memory_order_relaxed);
+            });
+            consumerWaiting_.store(false, std::memory_order_relaxed);
+            interrupted_.store(false, std::memory_order_relaxed);
+        }
+
+        return acquireLatest();
+    }
+
+    void FrameMailbox::interrupt() {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        interrupted_.store(true, std::memory_order_relaxed);
+        waitCondition_.notify_one();
+    }
+
+} // namespace EdgeDetection
@@ -0,0 +1,110 @@
+#ifndef FRAME_MAILBOX_H
+#define FRAME_MAILBOX_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Frame buffer owned by a mailbox slot
+ */
+    struct FrameSlot {
+        std::vector<uint8_t> data;  // Pixel data (RGBA format)
+        int width = 0;              // Frame width in pixels
+        int height = 0;             // Frame height in pixels
+        uint64_t sequence = 0;      // Producer sequence number (1-based)
+        int64_t timestampNs = 0;    // Capture timestamp (steady clock, nanoseconds)
+    };
+
+/**
+ * @brief Latest-frame-wins mailbox between one producer and one consumer
+ *
+ * Lock-free triple buffer: the producer always writes into its private back
+ * slot and publishes it by swapping it with the shared middle slot; the
+ * consumer swaps its front slot with the middle slot only when a newer frame
+ * is available. A published frame that is overwritten before the consumer
+ * picked it up is counted as dropped, so the consumer never works on more
+ * than one stale frame.
+ */
+    class FrameMailbox {
+    public:
+        FrameMailbox();
+
+        FrameMailbox(const FrameMailbox&) = delete;
+        FrameMailbox& operator=(const FrameMailbox&) = delete;
+
+        /**
+         * @brief Get the producer's back buffer, resized for the given frame
+         * @param width Frame width in pixels
+         * @param height Frame height in pixels
+         * @return Pointer to width * height * 4 writable bytes
+         */
+        uint8_t* beginWrite(int width, int height);
+
+        /**
+         * @brief Size and pre-fault every slot for the given frame size
+         *
+         * Call before the producer and consumer start; not thread safe.
+         */
+        void reserve(int width, int height);
+
+        /**
+         * @brief Publish the frame written since the last beginWrite()
+         * @param timestampNs Capture timestamp of the frame
+         */
+        void publish(int64_t timestampNs);
+
+        /**
+         * @brief Take the freshest published frame (non-blocking)
+         * @return Frame owned by the consumer until the next acquire, or nullptr if nothing new
+         */
+        const FrameSlot* acquireLatest();
+
+        /**
+         * @brief Take the freshest published frame, waiting if none is pending
+         * @param timeoutMs Maximum time to wait in milliseconds
+         * @return Frame owned by the consumer until the next acquire, or nullptr on timeout
+         */
+        const FrameSlot* waitForLatest(int timeoutMs);
+
+        /**
+         * @brief Wake a consumer blocked in waitForLatest() without publishing
+         */
+        void interrupt();
+
+        uint64_t publishedFrames() const { return published_.load(std::memory_order_relaxed); }
+        uint64_t droppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr uint8_t kIndexMask = 0x3;
+        static constexpr uint8_t kFreshBit = 0x4;
+
+        FrameSlot slots_[3];
+
+        // Producer-owned state
+        alignas(64) int writeIndex_;
+        uint64_t nextSequence_;
+
+        // Consumer-owned state
+        alignas(64) int readIndex_;
+
+        // Shared middle slot index, tagged with kFreshBit while unconsumed
+        alignas(64) std::atomic<uint8_t> middle_;
+
+        alignas(64) std::atomic<uint64_t> published_;
+        std::atomic<uint64_t> dropped_;
+
+        // Slow path only: used when the consumer has nothing to do and sleeps
+        alignas(64) std::atomic<bool> consumerWaiting_;
+        std::atomic<bool> interrupted_;
+        std::mutex waitMutex_;
+        std::condition_variable waitCondition_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // FRAME_MAILBOX_H
@@ -0,0 +1,108 @@
+//
+// Fixed-rate native processing thread with deadline-based frame dropping
+//
+#include "frame_scheduler.h"
+#include "log.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#define LOG_TAG "FrameScheduler"
+
+namespace EdgeDetection {
+
+    // Longest single wait for a frame, so stop() is noticed even without interrupt()
+    static const int kFrameWaitTimeoutMs = 100;
+
+    FrameScheduler::FrameScheduler(FrameMailbox& mailbox, StatsRecorder* stats, FrameTask task)
+            : mailbox_(mailbox),
+              stats_(stats),
+              task_(std::move(task)),
+              running_(false),
+              intervalNs_(0),
+              deadlineNs_(0) {
+    }
+
+    FrameScheduler::~FrameScheduler() {
+        stop();
+    }
+
+    int64_t FrameScheduler::nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void FrameScheduler::start(const SchedulerConfig& config) {
+        int64_t intervalNs = config.targetHz > 0.0 ? static_cast<int64_t>(1e9 / config.targetHz) : 0;
+        int64_t deadlineNs = config.deadlineMs > 0.0 ? static_cast<int64_t>(config.deadlineMs * 1e6)
+                                                     : 2 * intervalNs;
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        intervalNs_.store(intervalNs, std::memory_order_relaxed);
+        deadlineNs_.store(deadlineNs, std::memory_order_relaxed);
+
+        if (running_.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        thread_ = std::thread(&FrameScheduler::run, this);
+        LOGI("Frame scheduler started at %.1f Hz, deadline %.1f ms", config.targetHz, deadlineNs / 1e6);
+    }
+
+    void FrameScheduler::stop() {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            if (!running_.exchange(false, std::memory_order_acq_rel)) {
+                return;
+            }
+            waitCondition_.notify_one();
+        }
+        mailbox_.interrupt();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        LOGI("Frame scheduler stopped");
+    }
+
+    void FrameScheduler::run() {
+        TRACE_THREAD_NAME("edge-scheduler");
+        int64_t nextSlotNs = nowNs();
+
+        while (running_.load(std::memory_order_acquire)) {
+            // Pace: nothing is taken from the mailbox before the slot, so the
+            // frame processed is the freshest one at that moment
+            {
+                std::unique_lock<std::mutex> lock(waitMutex_);
+                waitCondition_.wait_until(
+                        lock, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(nextSlotNs)),
+                        [this] { return !running_.load(std::memory_order_acquire); });
+            }
+
+            const FrameSlot* frame;
+            {
+                TRACE_SCOPE("mailbox.wait");
+                frame = mailbox_.waitForLatest(kFrameWaitTimeoutMs);
+            }
+            if (!frame) {
+                continue;
+            }
+
+            int64_t startNs = nowNs();
+            int64_t deadlineNs = deadlineNs_.load(std::memory_order_relaxed);
+            if (deadlineNs > 0 && startNs - frame->timestampNs > deadlineNs) {
+                // Too old to be worth showing; keep the slot for the next frame
+                if (stats_) {
+                    stats_->recordDropped();
+                }
+                continue;
+            }
+
+            TRACE_FRAME(frame->sequence);
+            task_(*frame);
+
+            // Continue from now rather than bursting to catch up when the frame overran its slot
+            nextSlotNs = std::max(nextSlotNs + intervalNs_.load(std::memory_order_relaxed), nowNs());
+        }
+    }
+
+} // namespace EdgeDetection
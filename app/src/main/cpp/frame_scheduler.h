@@ -0,0 +1,90 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "frame_mailbox.h"
+#include "processing_stats.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Pacing of a detector's processing thread
+ */
+    struct SchedulerConfig {
+        double targetHz = 30.0;         // Processing rate; 0 = as fast as frames arrive
+        double deadlineMs = 0.0;        // Oldest capture age a frame may start at; 0 = two intervals
+    };
+
+/**
+ * @brief Processes one frame; called on the scheduler thread
+ */
+    using FrameTask = std::function<void(const FrameSlot& frame)>;
+
+/**
+ * @brief Native processing thread running a mailbox's frames at a fixed rate
+ *
+ * Decouples processing from both ends of the pipeline: the camera callback
+ * only publishes into the mailbox, and whoever displays the results reads
+ * the newest finished one at its own refresh rate. Every 1/targetHz the
+ * thread takes the freshest frame (waiting if none arrived since the last
+ * one) and runs the task on it. A frame whose capture is already older than
+ * the deadline when its turn comes is dropped instead, since it would only
+ * show later than the next one could; the thread then waits for a newer
+ * frame without giving up its slot. Processing slower than the target rate
+ * simply runs back to back, without bursts to catch up.
+ */
+    class FrameScheduler {
+    public:
+        /**
+         * @param mailbox Mailbox to consume; the scheduler is its only consumer while running
+         * @param stats Receives dropped frames, may be null
+         * @param task Processes each scheduled frame
+         */
+        FrameScheduler(FrameMailbox& mailbox, StatsRecorder* stats, FrameTask task);
+        ~FrameScheduler();
+
+        FrameScheduler(const FrameScheduler&) = delete;
+        FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+        /**
+         * @brief Start the thread, or apply the new pacing from the next frame if it already runs
+         */
+        void start(const SchedulerConfig& config);
+
+        /**
+         * @brief Stop the thread and wait until the frame in progress has finished
+         */
+        void stop();
+
+        bool running() const { return running_.load(std::memory_order_acquire); }
+
+    private:
+        void run();
+
+        static int64_t nowNs();
+
+        FrameMailbox& mailbox_;
+        StatsRecorder* stats_;
+        FrameTask task_;
+
+        // Held by start() and stop() throughout, so running_ and thread_ always change together
+        std::mutex lifecycleMutex_;
+        std::thread thread_;
+        std::atomic<bool> running_;
+        std::atomic<int64_t> intervalNs_;
+        std::atomic<int64_t> deadlineNs_;
+
+        // Sleep between slots, cut short by stop()
+        std::mutex waitMutex_;
+        std::condition_variable waitCondition_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // FRAME_SCHEDULER_H
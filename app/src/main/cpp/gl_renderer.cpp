@@ -2,15 +2,13 @@
 // Created by my lapi on 08-10-2025.
 //
 #include "image_processor.h"
+#include "log.h"
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 #include <EGL/egl.h>
-#include <android/log.h>
 #include <cstring>
 
 #define LOG_TAG "GLRenderer"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 namespace GLRenderer {
 
@@ -28,11 +26,6 @@ namespace GLRenderer {
             0, 2, 3     // Second triangle
     };
 
-// OpenGL objects
-    static unsigned int VAO = 0;
-    static unsigned int VBO = 0;
-    static unsigned int EBO = 0;
-
 /**
  * @brief Check OpenGL errors and log them
  * @param operation Description of the operation that was performed
@@ -44,6 +37,32 @@ namespace GLRenderer {
         }
     }
 
+#ifdef NDEBUG
+    // Release builds poll glGetError (a driver round-trip) once per this many frames
+    static const unsigned int kGLErrorSampleInterval = 120;
+#else
+    static const unsigned int kGLErrorSampleInterval = 1;
+#endif
+
+/**
+ * @brief Per-frame variant of checkGLError: every call in debug, sampled in release
+ *
+ * GL error flags stay set until read, so a sampled check still reports every
+ * error class that occurred; it only loses which frame raised it.
+ * @param operation Description of the operation that was performed
+ * @param counter Calls since the last check, kept in the caller's RenderContext
+ */
+    static void checkGLErrorSampled(const char* operation, unsigned int& counter) {
+        if (++counter < kGLErrorSampleInterval) {
+            return;
+        }
+        counter = 0;
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "OpenGL error during %s: 0x%x", operation, error);
+        }
+    }
+
 /**
  * @brief Compile a shader from source code
  * @param type Shader type (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)
@@ -74,7 +93,7 @@ namespace GLRenderer {
         return shader;
     }
 
-    bool initializeGL(int width, int height) {
+    bool initializeGL(RenderContext& context, int width, int height) {
         try {
             LOGI("Initializing OpenGL ES renderer (%dx%d)", width, height);
 
@@ -88,14 +107,14 @@ namespace GLRenderer {
             checkGLError("glBlendFunc");
 
             // Generate and bind vertex array object
-            glGenBuffers(1, &VAO);
-            glGenBuffers(1, &VBO);
-            glGenBuffers(1, &EBO);
+            glGenBuffers(1, &context.VAO);
+            glGenBuffers(1, &context.VBO);
+            glGenBuffers(1, &context.EBO);
 
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBindBuffer(GL_ARRAY_BUFFER, context.VBO);
             glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, context.EBO);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), quadIndices, GL_STATIC_DRAW);
 
             checkGLError("Buffer setup");
@@ -209,10 +228,10 @@ namespace GLRenderer {
         return texInfo;
     }
 
-    void updateTexture(const TextureInfo& textureInfo, const uint8_t* pixelData) {
+    void updateTexture(RenderContext& context, const TextureInfo& textureInfo, const uint8_t* pixelData) {
         try {
             if (textureInfo.textureId == 0 || !pixelData) {
-                LOGE("Invalid texture or pixel data");
+                LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Invalid texture or pixel data");
                 return;
             }
 
@@ -221,17 +240,40 @@ namespace GLRenderer {
                             textureInfo.width, textureInfo.height,
                             textureInfo.format, GL_UNSIGNED_BYTE, pixelData);
 
-            checkGLError("updateTexture");
+            checkGLErrorSampled("updateTexture", context.uploadChecks);
+
+        } catch (const std::exception& e) {
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in updateTexture: %s", e.what());
+        }
+    }
+
+    void updateTextureRows(RenderContext& context, const TextureInfo& textureInfo, const uint8_t* rowData,
+                           int rowStart, int rowEnd) {
+        try {
+            if (textureInfo.textureId == 0 || !rowData || rowStart < 0 ||
+                rowEnd > textureInfo.height || rowStart >= rowEnd) {
+                LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Invalid texture rows [%d, %d)",
+                              rowStart, rowEnd);
+                return;
+            }
+
+            glBindTexture(GL_TEXTURE_2D, textureInfo.textureId);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rowStart,
+                            textureInfo.width, rowEnd - rowStart,
+                            textureInfo.format, GL_UNSIGNED_BYTE, rowData);
+
+            checkGLErrorSampled("updateTextureRows", context.uploadChecks);
 
         } catch (const std::exception& e) {
-            LOGE("Exception in updateTexture: %s", e.what());
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in updateTextureRows: %s", e.what());
         }
     }
 
-    void renderTexture(const ShaderProgram& shaderProgram, const TextureInfo& textureInfo) {
+    void renderTexture(RenderContext& context, const ShaderProgram& shaderProgram,
+                       const TextureInfo& textureInfo) {
         try {
             if (shaderProgram.programId == 0 || textureInfo.textureId == 0) {
-                LOGE("Invalid shader program or texture");
+                LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Invalid shader program or texture");
                 return;
             }
 
@@ -247,7 +289,7 @@ namespace GLRenderer {
             glUniform1i(shaderProgram.textureUniform, 0);
 
             // Set up vertex attributes
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBindBuffer(GL_ARRAY_BUFFER, context.VBO);
 
             // Position attribute
             glVertexAttribPointer(shaderProgram.positionAttrib, 2, GL_FLOAT, GL_FALSE,
@@ -260,17 +302,17 @@ namespace GLRenderer {
             glEnableVertexAttribArray(shaderProgram.texCoordAttrib);
 
             // Draw quad
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, context.EBO);
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
             // Disable vertex attributes
             glDisableVertexAttribArray(shaderProgram.positionAttrib);
             glDisableVertexAttribArray(shaderProgram.texCoordAttrib);
 
-            checkGLError("renderTexture");
+            checkGLErrorSampled("renderTexture", context.renderChecks);
 
         } catch (const std::exception& e) {
-            LOGE("Exception in renderTexture: %s", e.what());
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in renderTexture: %s", e.what());
         }
     }
 
@@ -279,7 +321,8 @@ namespace GLRenderer {
         LOGI("Surface changed to %dx%d", newWidth, newHeight);
     }
 
-    void cleanupGL(const ShaderProgram& shaderProgram, const TextureInfo& textureInfo) {
+    void cleanupGL(RenderContext& context, const ShaderProgram& shaderProgram,
+                   const TextureInfo& textureInfo) {
         if (shaderProgram.programId != 0) {
             glDeleteProgram(shaderProgram.programId);
             LOGI("Deleted shader program: %d", shaderProgram.programId);
@@ -290,9 +333,10 @@ namespace GLRenderer {
             LOGI("Deleted texture: %d", textureInfo.textureId);
         }
 
-        if (VAO != 0) glDeleteBuffers(1, &VAO);
-        if (VBO != 0) glDeleteBuffers(1, &VBO);
-        if (EBO != 0) glDeleteBuffers(1, &EBO);
+        if (context.VAO != 0) glDeleteBuffers(1, &context.VAO);
+        if (context.VBO != 0) glDeleteBuffers(1, &context.VBO);
+        if (context.EBO != 0) glDeleteBuffers(1, &context.EBO);
+        context = RenderContext();
 
         LOGI("OpenGL cleanup completed");
     }
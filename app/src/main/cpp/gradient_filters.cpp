@@ -0,0 +1,188 @@
+//
+// Derivative-of-Gaussian gradients: blur and Sobel fused into one separable fixed-point pass
+//
+#include "gradient_filters.h"
+#include "blur_filters.h"
+#include "log.h"
+#include <algorithm>
+#include <climits>
+
+#define LOG_TAG "GradientFilters"
+
+namespace EdgeDetection {
+
+    // 3x3 Sobel, as separable smoothing and derivative taps
+    static constexpr int kSobel3Smooth[] = {1, 2, 1};
+    static constexpr int kSobel3Derive[] = {-1, 0, 1};
+
+    // cv::Sobel's other apertures (aperture 1 does not smooth)
+    static constexpr int kSobel1Smooth[] = {0, 1, 0};
+    static constexpr int kSobel5Smooth[] = {1, 4, 6, 4, 1};
+    static constexpr int kSobel5Derive[] = {-1, -2, 0, 2, 1};
+    static constexpr int kSobel7Smooth[] = {1, 6, 15, 20, 15, 6, 1};
+    static constexpr int kSobel7Derive[] = {-1, -4, -5, 0, 5, 4, 1};
+
+    // Sigma 1.4 Gaussians of the exact blur kernel sizes: cv::getGaussianKernel
+    // rounded to Q8 with the rounding error folded into the centre tap, as
+    // StreamingCanny builds them
+    static constexpr int kGaussianBits = 8;
+    static constexpr int kGaussian3[] = {78, 100, 78};
+    static constexpr int kGaussian5[] = {28, 61, 78, 61, 28};
+    static constexpr int kGaussian7[] = {7, 27, 57, 74, 57, 27, 7};
+
+    static constexpr int tapSum(const int* taps, int count) {
+        int sum = 0;
+        for (int i = 0; i < count; i++) {
+            sum += taps[i];
+        }
+        return sum;
+    }
+
+    // Unit gain, so the gradients keep Sobel's scale and cv::Canny's thresholds their meaning
+    static_assert(tapSum(kGaussian3, 3) == 1 << kGaussianBits && tapSum(kGaussian5, 5) == 1 << kGaussianBits &&
+                  tapSum(kGaussian7, 7) == 1 << kGaussianBits, "Gaussian taps must sum to one");
+
+    // applySobel's 3x3 blur (sigma 0 selects OpenCV's fixed 1/4 1/2 1/4 taps), in Q2
+    static constexpr int kBinomialBits = 2;
+    static constexpr int kBinomial3[] = {1, 2, 1};
+
+/**
+ * @brief Kernel of a symmetric blur followed by a Sobel operator, both along each axis
+ */
+    template <int BlurTaps, int SobelTaps>
+    static constexpr GradientKernel composeKernel(const int (&blur)[BlurTaps], int blurBits,
+                                                  const int (&smooth)[SobelTaps],
+                                                  const int (&derive)[SobelTaps]) {
+        static_assert(BlurTaps + SobelTaps - 1 <= GradientKernel::kMaxTaps, "Gradient kernel too long");
+        GradientKernel kernel{};
+        kernel.taps = BlurTaps + SobelTaps - 1;
+        kernel.shift = 2 * blurBits;
+        for (int i = 0; i < BlurTaps; i++) {
+            for (int j = 0; j < SobelTaps; j++) {
+                kernel.smooth[i + j] += blur[i] * smooth[j];
+                kernel.derive[i + j] += blur[i] * derive[j];
+            }
+        }
+        return kernel;
+    }
+
+    static constexpr GradientKernel kCannyKernel3 = composeKernel(kGaussian3, kGaussianBits, kSobel3Smooth, kSobel3Derive);
+    static constexpr GradientKernel kCannyKernel5 = composeKernel(kGaussian5, kGaussianBits, kSobel3Smooth, kSobel3Derive);
+    static constexpr GradientKernel kCannyKernel7 = composeKernel(kGaussian7, kGaussianBits, kSobel3Smooth, kSobel3Derive);
+
+    static constexpr GradientKernel kSobelKernel1 = composeKernel(kBinomial3, kBinomialBits, kSobel1Smooth, kSobel3Derive);
+    static constexpr GradientKernel kSobelKernel3 = composeKernel(kBinomial3, kBinomialBits, kSobel3Smooth, kSobel3Derive);
+    static constexpr GradientKernel kSobelKernel5 = composeKernel(kBinomial3, kBinomialBits, kSobel5Smooth, kSobel5Derive);
+    static constexpr GradientKernel kSobelKernel7 = composeKernel(kBinomial3, kBinomialBits, kSobel7Smooth, kSobel7Derive);
+
+/**
+ * @brief Index of position i in n pixels under BORDER_REFLECT_101
+ */
+    static int reflect101(int i, int n) {
+        if (n == 1) {
+            return 0;
+        }
+        while (i < 0 || i >= n) {
+            i = i < 0 ? -i : 2 * n - 2 - i;
+        }
+        return i;
+    }
+
+    static short saturateShort(int value) {
+        return static_cast<short>(std::min(std::max(value, SHRT_MIN), SHRT_MAX));
+    }
+
+    const GradientKernel* cannyGradientKernel(int blurKernelSize) {
+        if (blurBackend(blurKernelSize) != BlurBackend::Exact) {
+            return nullptr;
+        }
+        switch (blurKernelSize) {
+            case 3:
+                return &kCannyKernel3;
+            case 5:
+                return &kCannyKernel5;
+            case 7:
+                return &kCannyKernel7;
+            default:
+                return nullptr;
+        }
+    }
+
+    const GradientKernel* sobelGradientKernel(int apertureSize) {
+        switch (apertureSize) {
+            case 1:
+                return &kSobelKernel1;
+            case 3:
+                return &kSobelKernel3;
+            case 5:
+                return &kSobelKernel5;
+            case 7:
+                return &kSobelKernel7;
+            default:
+                return nullptr;
+        }
+    }
+
+    void gradientFilter(const cv::Mat& grayMat, const GradientKernel& kernel,
+                        cv::Mat& dxMat, cv::Mat& dyMat, cv::Mat& rowBuffer) {
+        const int rows = grayMat.rows;
+        const int cols = grayMat.cols;
+        const int radius = kernel.taps / 2;
+        const int padded = cols + 2 * radius;
+        const int rounding = 1 << (kernel.shift - 1);
+        dxMat.create(rows, cols, CV_16SC1);
+        dyMat.create(rows, cols, CV_16SC1);
+
+        // Column-smoothed and column-differentiated rows with reflected margins,
+        // then the row sums of each gradient
+        rowBuffer.create(1, 2 * padded + 2 * cols, CV_32S);
+        int* smoothed = rowBuffer.ptr<int>(0);
+        int* derived = smoothed + padded;
+        int* sumX = derived + padded;
+        int* sumY = sumX + cols;
+
+        for (int y = 0; y < rows; y++) {
+            int* smoothedRow = smoothed + radius;
+            int* derivedRow = derived + radius;
+            std::fill(smoothedRow, smoothedRow + cols, 0);
+            std::fill(derivedRow, derivedRow + cols, 0);
+            for (int k = 0; k < kernel.taps; k++) {
+                const uchar* in = grayMat.ptr<uchar>(reflect101(y - radius + k, rows));
+                const int smoothTap = kernel.smooth[k];
+                const int deriveTap = kernel.derive[k];
+                for (int x = 0; x < cols; x++) {
+                    smoothedRow[x] += smoothTap * in[x];
+                    derivedRow[x] += deriveTap * in[x];
+                }
+            }
+            for (int i = 1; i <= radius; i++) {
+                smoothedRow[-i] = smoothedRow[reflect101(-i, cols)];
+                derivedRow[-i] = derivedRow[reflect101(-i, cols)];
+                smoothedRow[cols - 1 + i] = smoothedRow[reflect101(cols - 1 + i, cols)];
+                derivedRow[cols - 1 + i] = derivedRow[reflect101(cols - 1 + i, cols)];
+            }
+
+            // dx differentiates the smoothed columns along the row, dy smooths the differentiated ones
+            std::fill(sumX, sumX + cols, 0);
+            std::fill(sumY, sumY + cols, 0);
+            for (int k = 0; k < kernel.taps; k++) {
+                const int* smoothedIn = smoothed + k;
+                const int* derivedIn = derived + k;
+                const int smoothTap = kernel.smooth[k];
+                const int deriveTap = kernel.derive[k];
+                for (int x = 0; x < cols; x++) {
+                    sumX[x] += deriveTap * smoothedIn[x];
+                    sumY[x] += smoothTap * derivedIn[x];
+                }
+            }
+
+            short* dx = dxMat.ptr<short>(y);
+            short* dy = dyMat.ptr<short>(y);
+            for (int x = 0; x < cols; x++) {
+                dx[x] = saturateShort((sumX[x] + rounding) >> kernel.shift);
+                dy[x] = saturateShort((sumY[x] + rounding) >> kernel.shift);
+            }
+        }
+    }
+
+} // namespace EdgeDetection
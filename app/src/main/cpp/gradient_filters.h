@@ -0,0 +1,57 @@
+#ifndef GRADIENT_FILTERS_H
+#define GRADIENT_FILTERS_H
+
+#include <opencv2/opencv.hpp>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Separable derivative-of-Gaussian kernel pair in fixed point
+ *
+ * A blur followed by a Sobel operator is one separable filter per gradient:
+ * dx smooths down the columns with smooth[] and differentiates along the rows
+ * with derive[], dy the other way round. Both taps are the blur taps convolved
+ * with the Sobel ones, so they are integers and the gradient comes out in the
+ * units Sobel gives on the blurred image, without rounding the blur to 8 bits
+ * in between.
+ */
+    struct GradientKernel {
+        static constexpr int kMaxTaps = 9;
+
+        int taps;                   // Odd tap count of both arrays
+        int shift;                  // Fractional bits of smooth x derive
+        int smooth[kMaxTaps];
+        int derive[kMaxTaps];
+    };
+
+/**
+ * @brief Kernel equal to the exact Gaussian blur of a kernel size followed by cv::Canny's 3x3 Sobel
+ * @return null for kernels the exact blur does not handle (see blurBackend)
+ */
+    const GradientKernel* cannyGradientKernel(int blurKernelSize);
+
+/**
+ * @brief Kernel equal to applySobel's 3x3 binomial blur followed by cv::Sobel of an aperture
+ * @return null unless apertureSize is 1, 3, 5 or 7
+ */
+    const GradientKernel* sobelGradientKernel(int apertureSize);
+
+/**
+ * @brief Horizontal and vertical gradients of a single-channel 8-bit image in one pass
+ *
+ * Works a row at a time: the column pass over kernel.taps input rows goes
+ * into two row buffers, and the row pass turns those into one row of each
+ * gradient, so no full-size intermediate is written. Both inner loops run
+ * across columns and vectorize. The border is BORDER_REFLECT_101 on the input,
+ * which differs from blurring and then applying cv::Canny's replicated-border
+ * Sobel only within kernel.taps / 2 pixels of the image border.
+ * @param dxMat Output CV_16S horizontal gradient, saturated
+ * @param dyMat Output CV_16S vertical gradient, saturated
+ * @param rowBuffer Scratch reused across calls
+ */
+    void gradientFilter(const cv::Mat& grayMat, const GradientKernel& kernel,
+                        cv::Mat& dxMat, cv::Mat& dyMat, cv::Mat& rowBuffer);
+
+} // namespace EdgeDetection
+
+#endif // GRADIENT_FILTERS_H
@@ -4,8 +4,55 @@
 #include <opencv2/opencv.hpp>
 #include <cstdint>
 
+#include "blur_filters.h"
+
 namespace EdgeDetection {
 
+    class StatsRecorder;
+
+/**
+ * @brief Pipeline stages timed individually by the statistics
+ */
+    enum class ProcessingStage {
+        Gray,           // Color to grayscale conversion
+        Blur,           // Gaussian blur and gradients
+        Canny,          // Non-maximum suppression and hysteresis
+        Rgba,           // Edge map to RGBA expansion
+        Copy,           // Copy into the caller's output buffer
+        Gate,           // Motion gate thumbnail and comparison
+        Motion,         // Global motion profiles and shift estimation
+    };
+
+    constexpr int kProcessingStageCount = 7;
+
+/**
+ * @brief Short display name of a stage
+ */
+    const char* processingStageName(ProcessingStage stage);
+
+/**
+ * @brief Layout of the RGBA frames processFrame writes
+ */
+    enum class OutputFormat {
+        Mask,           // Edge mask (0 or 255) in all four channels
+        Packed,         // Edge mask, gradient magnitude, direction and edge strength; see edgeToPackedRGBA
+    };
+
+/**
+ * @brief Intermediate buffers reused across frames to avoid per-frame allocation
+ */
+    struct Workspace {
+        cv::Mat grayMat;            // Grayscale input
+        cv::Mat blurredMat;         // Gaussian-blurred grayscale (large blur kernels only)
+        BlurBuffers blurBuffers;    // Scratch of the blur backends and gradient filters
+        cv::Mat dxMat;              // Horizontal gradient (CV_16S)
+        cv::Mat dyMat;              // Vertical gradient (CV_16S)
+        cv::Mat edgeMat;            // Single channel edge map
+        cv::Mat rgbaMat;            // RGBA expansion of the edge map
+        StatsRecorder* stats = nullptr;  // Receives stage timings when set
+        OutputFormat outputFormat = OutputFormat::Mask;  // What processFrame and processFrameRows write
+    };
+
 /**
  * @brief Apply Canny edge detection algorithm
  * @param inputMat Input image matrix (BGR/RGBA format)
@@ -19,6 +66,14 @@ namespace EdgeDetection {
                     double lowThreshold, double highThreshold,
                     int kernelSize);
 
+/**
+ * @brief Apply Canny edge detection reusing caller-owned intermediate buffers
+ * @param workspace Buffers for the grayscale and gradient intermediates
+ */
+    bool applyCanny(const cv::Mat& inputMat, cv::Mat& outputMat,
+                    double lowThreshold, double highThreshold,
+                    int kernelSize, Workspace& workspace);
+
 /**
  * @brief Apply Sobel edge detection algorithm
  * @param inputMat Input image matrix
@@ -36,6 +91,28 @@ namespace EdgeDetection {
  */
     bool edgeToRGBA(const cv::Mat& edgeMat, cv::Mat& rgbaMat);
 
+/**
+ * @brief Pack an edge map and the Canny gradients it came from into RGBA, one quantity per channel
+ *
+ * R: edge mask (0 or 255), as edgeToRGBA writes to every channel.
+ * G: L1 gradient magnitude |dx| + |dy| divided by 4, saturated; Canny
+ *    thresholds divided by 4 apply to it.
+ * B: gradient direction, 256 steps per turn from +x towards +y (image rows
+ *    grow downwards); 0 where there is no gradient.
+ * A: edge strength, 0 off edges: 255 above the high threshold, where
+ *    hysteresis starts, else 255 * magnitude / high for weak pixels kept
+ *    only through a strong neighbour.
+ * @param edgeMat Input edge image (single channel)
+ * @param dxMat Horizontal gradient (CV_16S) of the same pixels
+ * @param dyMat Vertical gradient (CV_16S) of the same pixels
+ * @param lowThreshold Lower threshold the edges were detected with
+ * @param highThreshold Upper threshold the edges were detected with
+ * @param rgbaMat Output RGBA image
+ * @return true if successful, false otherwise
+ */
+    bool edgeToPackedRGBA(const cv::Mat& edgeMat, const cv::Mat& dxMat, const cv::Mat& dyMat,
+                          double lowThreshold, double highThreshold, cv::Mat& rgbaMat);
+
 /**
  * @brief Process camera frame with edge detection (optimized for real-time)
  * @param inputData Input frame data (RGBA format)
@@ -47,34 +124,102 @@ namespace EdgeDetection {
     bool processFrame(const uint8_t* inputData, int width, int height, uint8_t* outputData);
 
 /**
- * @brief Structure to hold processing statistics
+ * @brief Process camera frame with explicit parameters and reusable buffers
+ * @param lowThreshold Lower threshold for edge detection
+ * @param highThreshold Upper threshold for edge detection
+ * @param blurKernel Gaussian blur kernel size
+ * @param workspace Intermediate buffers owned by the caller
  */
-    struct ProcessingStats {
-        double processingTime;      // Processing time in milliseconds
-        int framesProcessed;        // Total frames processed
-        double averageFps;          // Average FPS
-        int currentThreshold1;      // Current lower threshold
-        int currentThreshold2;      // Current upper threshold
-    };
+    bool processFrame(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                      double lowThreshold, double highThreshold, int blurKernel,
+                      Workspace& workspace);
+
+/**
+ * @brief Minimum band height; thinner bands cost more in halo rows than they gain in balance
+ */
+    constexpr int kMinBandRows = 48;
+
+/**
+ * @brief Bands per worker; more bands than workers lets stealing even out edge-dense regions
+ */
+    constexpr int kBandsPerWorker = 3;
 
 /**
- * @brief Get current processing statistics
- * @return ProcessingStats structure with current metrics
+ * @brief Number of row bands to split a frame into for parallel processing
+ * @param height Frame height in pixels
+ * @param workers Worker threads available
+ * @return Band count, at least 1
  */
-    ProcessingStats getProcessingStats();
+    int frameBandCount(int height, int workers);
 
 /**
- * @brief Reset processing statistics
+ * @brief Rows of context a band needs above and below its output rows
+ * @param blurKernel Gaussian blur kernel size
+ * @return Halo height in rows
  */
-    void resetProcessingStats();
+    int tileHaloRows(int blurKernel);
 
 /**
- * @brief Update edge detection parameters dynamically
- * @param lowThreshold New lower threshold
- * @param highThreshold New upper threshold
- * @param blurKernel New Gaussian blur kernel size
+ * @brief Process one horizontal band of a frame (unit of work for parallel processing)
+ * @param inputData Full input frame data (RGBA format)
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels
+ * @param outputData Full output frame data; only rows [rowStart, rowEnd) are written
+ * @param rowStart First output row of the band
+ * @param rowEnd One past the last output row of the band
+ * @param lowThreshold Lower threshold for edge detection
+ * @param highThreshold Upper threshold for edge detection
+ * @param blurKernel Gaussian blur kernel size
+ * @param workspace Intermediate buffers owned by the calling worker
+ * @return true if successful, false otherwise
  */
-    void updateProcessingParameters(double lowThreshold, double highThreshold, int blurKernel);
+    bool processFrameRows(const uint8_t* inputData, int width, int height, uint8_t* outputData,
+                          int rowStart, int rowEnd,
+                          double lowThreshold, double highThreshold, int blurKernel,
+                          Workspace& workspace);
+
+/**
+ * @brief Structure to hold processing statistics
+ */
+    struct ProcessingStats {
+        double processingTime;      // Processing time in milliseconds
+        int framesProcessed;        // Total frames processed
+        double averageFps;          // Average FPS
+        int currentThreshold1;      // Current lower threshold
+        int currentThreshold2;      // Current upper threshold
+        int framesDropped;          // Frames skipped before processing (stale or late)
+        int framesSkipped;          // Frames the motion gate found static and did not process
+        int framesReused;           // Frames built from the previous edge map shifted by global motion
+        int queueCapacity;          // Frame queue capacity in slots
+        int queueHighWaterMark;     // Highest observed frame queue occupancy
+        uint64_t queueDroppedOldest;  // Frames evicted by the drop-oldest policy
+        uint64_t queueDroppedNewest;  // Frames rejected by the drop-newest policy
+        uint64_t queueBlockedPushes;  // Frame pushes that waited for space
+        int bandsPerFrame;          // Row bands the last frame was split into
+        uint64_t tasksStolen;       // Worker pool tasks rebalanced by stealing
+        uint64_t failedSteals;      // Worker pool steal sweeps that found no work
+        double workerIdleMs;        // Total time worker pool threads spent idle
+        double latencyP50Ms;        // Median frame processing time
+        double latencyP90Ms;        // 90th percentile frame processing time
+        double latencyP99Ms;        // 99th percentile frame processing time
+        double latencyMaxMs;        // Slowest frame since the last reset
+        int framesPresented;        // Processed frames shown on screen with a complete timeline
+        double endToEndP50Ms;       // Median capture-to-present time of presented frames
+        double endToEndP99Ms;       // 99th percentile capture-to-present time
+        double queueDelayMs;        // Mean capture to processing start of presented frames
+        double processDelayMs;      // ... processing start to end
+        double uploadDelayMs;       // ... processing end to last band uploaded
+        double presentDelayMs;      // ... upload to draw submitted
+        uint64_t bytesProcessed;    // Input bytes of all processed frames
+        double warmUpMs;            // Time spent warming the pipeline up before the first frame
+        int blurKernel;             // Current Gaussian blur kernel size
+        uint64_t matAllocations;    // Mat buffers allocated (pooled allocator only)
+        uint64_t matPoolHits;       // ... of which were reused from the pool
+        int64_t matBytesInUse;      // Bytes held by live Mats
+        int64_t matBytesCached;     // Bytes kept warm on the pool's free lists
+        double stageAverageMs[kProcessingStageCount];  // Mean time per stage call
+        double stageMaxMs[kProcessingStageCount];      // Slowest call per stage
+    };
 
 } // namespace EdgeDetection
 
@@ -102,13 +247,25 @@ namespace GLRenderer {
         int mvpMatrixUniform;       // MVP matrix uniform location
     };
 
+/**
+ * @brief GL buffer objects and per-frame state owned by one renderer instance (its GL thread only)
+ */
+    struct RenderContext {
+        unsigned int VAO = 0;       // Vertex array object
+        unsigned int VBO = 0;       // Quad vertex buffer
+        unsigned int EBO = 0;       // Quad index buffer
+        unsigned int uploadChecks = 0;  // Texture uploads since the last sampled glGetError
+        unsigned int renderChecks = 0;  // Draws since the last sampled glGetError
+    };
+
 /**
  * @brief Initialize OpenGL ES context and resources
+ * @param context Renderer instance receiving the created buffer objects
  * @param width Surface width
  * @param height Surface height
  * @return true if successful, false otherwise
  */
-    bool initializeGL(int width, int height);
+    bool initializeGL(RenderContext& context, int width, int height);
 
 /**
  * @brief Create and compile shader program
@@ -128,24 +285,40 @@ namespace GLRenderer {
 
 /**
  * @brief Update texture with processed frame data
+ * @param context Renderer instance the texture belongs to
  * @param textureInfo Texture to update
  * @param pixelData New pixel data (RGBA format)
  */
-    void updateTexture(const TextureInfo& textureInfo, const uint8_t* pixelData);
+    void updateTexture(RenderContext& context, const TextureInfo& textureInfo, const uint8_t* pixelData);
+
+/**
+ * @brief Update rows [rowStart, rowEnd) of a texture, e.g. one finished band of a frame
+ * @param context Renderer instance the texture belongs to
+ * @param textureInfo Texture to update
+ * @param rowData First row to upload (RGBA format, tightly packed)
+ * @param rowStart First texture row to update
+ * @param rowEnd One past the last texture row to update
+ */
+    void updateTextureRows(RenderContext& context, const TextureInfo& textureInfo, const uint8_t* rowData,
+                           int rowStart, int rowEnd);
 
 /**
  * @brief Render texture to screen
+ * @param context Renderer instance owning the quad buffers
  * @param shaderProgram Shader program to use
  * @param textureInfo Texture to render
  */
-    void renderTexture(const ShaderProgram& shaderProgram, const TextureInfo& textureInfo);
+    void renderTexture(RenderContext& context, const ShaderProgram& shaderProgram,
+                       const TextureInfo& textureInfo);
 
 /**
  * @brief Cleanup OpenGL resources
+ * @param context Renderer instance whose buffers are released
  * @param shaderProgram Shader program to cleanup
  * @param textureInfo Texture to cleanup
  */
-    void cleanupGL(const ShaderProgram& shaderProgram, const TextureInfo& textureInfo);
+    void cleanupGL(RenderContext& context, const ShaderProgram& shaderProgram,
+                   const TextureInfo& textureInfo);
 
 /**
  * @brief Handle surface size change
@@ -3,22 +3,18 @@
 //
 #include <jni.h>
 #include <android/bitmap.h>
-#include <android/log.h>
 #include <android/native_window_jni.h>
 #include <string>
 #include <memory>
 #include <chrono>
 
 #include "image_processor.h"
+#include "edge_detector.h"
+#include "log.h"
+#include "mat_allocator.h"
+#include "trace.h"
 
 #define LOG_TAG "EdgeDetectionJNI"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-
-// Global variables for performance tracking
-static std::chrono::high_resolution_clock::time_point lastFrameTime;
-static int frameCount = 0;
-static double averageFps = 0.0;
 
 // Shader source code (embedded as strings)
 const char* vertexShaderSource = R"(
@@ -41,32 +37,230 @@ varying vec2 vTexCoord;
 uniform sampler2D uTexture;
 
 void main() {
-    vec4 textureColor = texture2D(uTexture, vTexCoord);
-    gl_FragColor = textureColor;
+    // Only the edge mask in R is drawn, so packed output looks the same
+    float edge = texture2D(uTexture, vTexCoord).r;
+    gl_FragColor = vec4(edge);
 }
 )";
 
+/**
+ * @brief Resolve a Java-held native handle
+ * @param nativePtr Handle returned by nativeCreate
+ * @return Detector instance, or nullptr if the handle is invalid
+ */
+static EdgeDetection::EdgeDetector* fromHandle(jlong nativePtr) {
+    auto* detector = reinterpret_cast<EdgeDetection::EdgeDetector*>(nativePtr);
+    if (!detector) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Invalid native detector handle");
+    }
+    return detector;
+}
+
+/**
+ * @brief Run edge detection on a frame and return the result as a new Java array
+ * @param env JNI environment
+ * @param detector Detector instance processing the frame
+ * @param inputBytes Input image data (RGBA)
+ * @param width Image width
+ * @param height Image height
+ * @param imageId Nonzero routes a still image through the detector's stage cache
+ * @return Processed image as byte array (RGBA), or nullptr on failure
+ */
+static jbyteArray processIntoNewArray(JNIEnv* env, EdgeDetection::EdgeDetector& detector,
+                                      const uint8_t* inputBytes, jint width, jint height,
+                                      jlong imageId = 0) {
+    TRACE_SCOPE("jni.processIntoNewArray");
+
+    // Create output array
+    jbyteArray outputArray = env->NewByteArray(width * height * 4);
+    if (!outputArray) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Failed to create output byte array");
+        return nullptr;
+    }
+
+    jbyte* outputBytes = env->GetByteArrayElements(outputArray, nullptr);
+    if (!outputBytes) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Failed to get output byte array elements");
+        return nullptr;
+    }
+
+    // Process frame with edge detection
+    bool success = imageId != 0
+            ? detector.processImage(inputBytes, width, height,
+                                    reinterpret_cast<uint8_t*>(outputBytes),
+                                    static_cast<uint64_t>(imageId))
+            : detector.processFrame(inputBytes, width, height,
+                                    reinterpret_cast<uint8_t*>(outputBytes));
+
+    if (!success) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Frame processing failed");
+        env->ReleaseByteArrayElements(outputArray, outputBytes, JNI_ABORT);
+        return nullptr;
+    }
+
+    // Commit output array (copies back on VMs that handed out a copy)
+    TRACE_SCOPE("jni.commitOutput");
+    env->ReleaseByteArrayElements(outputArray, outputBytes, 0);
+    return outputArray;
+}
+
+/**
+ * @brief Copy a native stats snapshot into a new Java ProcessingStats object
+ * @param env JNI environment
+ * @param stats Snapshot to convert
+ * @return Local reference to the Java object, or nullptr (with a pending exception) on failure
+ */
+static jobject newJavaStats(JNIEnv* env, const EdgeDetection::ProcessingStats& stats) {
+    jclass statsClass = env->FindClass("com/example/edgedetectionviewer/ProcessingStats");
+    if (!statsClass) {
+        LOGE("ProcessingStats class not found");
+        return nullptr;
+    }
+
+    jmethodID constructor = env->GetMethodID(statsClass, "<init>", "()V");
+    jobject result = constructor ? env->NewObject(statsClass, constructor) : nullptr;
+    if (!result) {
+        LOGE("Failed to create ProcessingStats");
+        env->DeleteLocalRef(statsClass);
+        return nullptr;
+    }
+
+    auto setInt = [&](const char* name, jint value) {
+        jfieldID field = env->GetFieldID(statsClass, name, "I");
+        if (field) env->SetIntField(result, field, value);
+    };
+    auto setLong = [&](const char* name, jlong value) {
+        jfieldID field = env->GetFieldID(statsClass, name, "J");
+        if (field) env->SetLongField(result, field, value);
+    };
+    auto setDouble = [&](const char* name, jdouble value) {
+        jfieldID field = env->GetFieldID(statsClass, name, "D");
+        if (field) env->SetDoubleField(result, field, value);
+    };
+    auto setDoubles = [&](const char* name, const double* values, jsize count) {
+        jfieldID field = env->GetFieldID(statsClass, name, "[D");
+        jdoubleArray array = field ? env->NewDoubleArray(count) : nullptr;
+        if (array) {
+            env->SetDoubleArrayRegion(array, 0, count, values);
+            env->SetObjectField(result, field, array);
+            env->DeleteLocalRef(array);
+        }
+    };
+
+    setInt("framesProcessed", stats.framesProcessed);
+    setInt("framesDropped", stats.framesDropped);
+    setInt("framesSkipped", stats.framesSkipped);
+    setInt("framesReused", stats.framesReused);
+    setDouble("averageFps", stats.averageFps);
+    setDouble("lastFrameMs", stats.processingTime);
+    setDouble("latencyP50Ms", stats.latencyP50Ms);
+    setDouble("latencyP90Ms", stats.latencyP90Ms);
+    setDouble("latencyP99Ms", stats.latencyP99Ms);
+    setDouble("latencyMaxMs", stats.latencyMaxMs);
+    setInt("framesPresented", stats.framesPresented);
+    setDouble("endToEndP50Ms", stats.endToEndP50Ms);
+    setDouble("endToEndP99Ms", stats.endToEndP99Ms);
+    setDouble("queueDelayMs", stats.queueDelayMs);
+    setDouble("processDelayMs", stats.processDelayMs);
+    setDouble("uploadDelayMs", stats.uploadDelayMs);
+    setDouble("presentDelayMs", stats.presentDelayMs);
+    setLong("bytesProcessed", static_cast<jlong>(stats.bytesProcessed));
+    setDouble("warmUpMs", stats.warmUpMs);
+    setInt("lowThreshold", stats.currentThreshold1);
+    setInt("highThreshold", stats.currentThreshold2);
+    setInt("blurKernel", stats.blurKernel);
+    setInt("bandsPerFrame", stats.bandsPerFrame);
+    setLong("tasksStolen", static_cast<jlong>(stats.tasksStolen));
+    setDouble("workerIdleMs", stats.workerIdleMs);
+    setLong("matAllocations", static_cast<jlong>(stats.matAllocations));
+    setLong("matPoolHits", static_cast<jlong>(stats.matPoolHits));
+    setLong("matBytesInUse", static_cast<jlong>(stats.matBytesInUse));
+    setLong("matBytesCached", static_cast<jlong>(stats.matBytesCached));
+    setDoubles("stageAverageMs", stats.stageAverageMs, EdgeDetection::kProcessingStageCount);
+    setDoubles("stageMaxMs", stats.stageMaxMs, EdgeDetection::kProcessingStageCount);
+
+    env->DeleteLocalRef(statsClass);
+    if (env->ExceptionCheck()) {
+        LOGE("Failed to fill ProcessingStats");
+        env->DeleteLocalRef(result);
+        return nullptr;
+    }
+    return result;
+}
+
 extern "C" {
 
 /**
- * @brief Initialize the native edge detection system
+ * @brief Create an independent edge detection pipeline
  * @param env JNI environment
  * @param thiz Java object instance
+ * @return Native handle, or 0 on failure
+ */
+JNIEXPORT jlong JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_nativeCreate(
+        JNIEnv* env, jobject thiz) {
+
+    try {
+        auto* detector = new EdgeDetection::EdgeDetector();
+        detector->setWorkerPool(EdgeDetection::WorkerPool::shared());
+        LOGI("Created native edge detector %p", detector);
+        return reinterpret_cast<jlong>(detector);
+
+    } catch (const std::exception& e) {
+        LOGE("Exception creating native edge detector: %s", e.what());
+        return 0;
+    }
+}
+
+/**
+ * @brief Destroy a pipeline created by nativeCreate
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_nativeDestroy(
+        JNIEnv* env, jobject thiz, jlong nativePtr) {
+
+    auto* detector = reinterpret_cast<EdgeDetection::EdgeDetector*>(nativePtr);
+    if (detector) {
+        LOGI("Destroying native edge detector %p", detector);
+        delete detector;
+    }
+}
+
+/**
+ * @brief Initialize the native edge detection system and warm it up
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param width Expected frame width, or 0 to skip the warm-up
+ * @param height Expected frame height
  * @return true if initialization successful
  */
 JNIEXPORT jboolean JNICALL
 Java_com_example_edgedetectionviewer_EdgeDetectionJNI_nativeInit(
-        JNIEnv* env, jobject thiz) {
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint width, jint height) {
 
-    LOGI("Initializing native edge detection system");
+    LOGI("Initializing native edge detection system for %dx%d frames", width, height);
 
     try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return JNI_FALSE;
+        }
+
+        // Serve OpenCV's internal temporaries from warm, pooled memory
+        EdgeDetection::PooledMatAllocator::install();
+
         // Reset performance counters
-        frameCount = 0;
-        averageFps = 0.0;
-        lastFrameTime = std::chrono::high_resolution_clock::now();
+        detector->resetStats();
+
+        // Pay for lazy initialization and cold buffers now, not on the first camera frames
+        if (detector->warmUp(width, height) < 0.0) {
+            return JNI_FALSE;
+        }
 
-        // Initialize OpenCV (if needed)
         LOGI("Native initialization completed successfully");
         return JNI_TRUE;
 
@@ -80,6 +274,7 @@ Java_com_example_edgedetectionviewer_EdgeDetectionJNI_nativeInit(
  * @brief Process camera frame with edge detection
  * @param env JNI environment
  * @param thiz Java object instance
+ * @param nativePtr Native handle
  * @param inputArray Input image data as byte array (RGBA)
  * @param width Image width
  * @param height Image height
@@ -87,105 +282,462 @@ Java_com_example_edgedetectionviewer_EdgeDetectionJNI_nativeInit(
  */
 JNIEXPORT jbyteArray JNICALL
 Java_com_example_edgedetectionviewer_EdgeDetectionJNI_processFrame(
-        JNIEnv* env, jobject thiz, jbyteArray inputArray, jint width, jint height) {
-
-    auto frameStart = std::chrono::high_resolution_clock::now();
+        JNIEnv* env, jobject thiz, jlong nativePtr, jbyteArray inputArray, jint width, jint height) {
 
     try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return nullptr;
+        }
+
         if (!inputArray) {
-            LOGE("Input array is null");
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Input array is null");
             return nullptr;
         }
 
         // Get input data
         jbyte* inputBytes = env->GetByteArrayElements(inputArray, nullptr);
         if (!inputBytes) {
-            LOGE("Failed to get input byte array elements");
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Failed to get input byte array elements");
             return nullptr;
         }
 
         jsize inputLength = env->GetArrayLength(inputArray);
         if (inputLength != width * height * 4) {
-            LOGE("Input array size mismatch: expected %d, got %d",
-                 width * height * 4, inputLength);
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Input array size mismatch: expected %d, got %d",
+                          width * height * 4, inputLength);
             env->ReleaseByteArrayElements(inputArray, inputBytes, JNI_ABORT);
             return nullptr;
         }
 
-        // Create output array
-        jbyteArray outputArray = env->NewByteArray(inputLength);
-        if (!outputArray) {
-            LOGE("Failed to create output byte array");
-            env->ReleaseByteArrayElements(inputArray, inputBytes, JNI_ABORT);
+        jbyteArray outputArray = processIntoNewArray(
+                env, *detector, reinterpret_cast<const uint8_t*>(inputBytes), width, height);
+
+        // Release input array
+        env->ReleaseByteArrayElements(inputArray, inputBytes, JNI_ABORT);
+
+        return outputArray;
+
+    } catch (const std::exception& e) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in processFrame: %s", e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Process a paused frame or still image, reusing stages cached for it
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param inputArray Input image data as byte array (RGBA)
+ * @param width Image width
+ * @param height Image height
+ * @param imageId Identity of the image content (nonzero); change it when the pixels change
+ * @return Processed image as byte array (RGBA)
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_processImage(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jbyteArray inputArray, jint width, jint height,
+        jlong imageId) {
+
+    try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return nullptr;
+        }
+
+        if (!inputArray || imageId == 0) {
+            LOGE("processImage needs an input array and a nonzero image id");
+            return nullptr;
+        }
+
+        jsize inputLength = env->GetArrayLength(inputArray);
+        if (inputLength != width * height * 4) {
+            LOGE("Input array size mismatch: expected %d, got %d", width * height * 4, inputLength);
             return nullptr;
         }
 
+        jbyte* inputBytes = env->GetByteArrayElements(inputArray, nullptr);
+        if (!inputBytes) {
+            LOGE("Failed to get input byte array elements");
+            return nullptr;
+        }
+
+        jbyteArray outputArray = processIntoNewArray(
+                env, *detector, reinterpret_cast<const uint8_t*>(inputBytes), width, height, imageId);
+
+        env->ReleaseByteArrayElements(inputArray, inputBytes, JNI_ABORT);
+        return outputArray;
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in processImage: %s", e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Process a large still (12-48 MP) in tiles without full-size intermediates
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param inputArray Input image data as byte array (RGBA)
+ * @param width Image width
+ * @param height Image height
+ * @param outputArray Caller-allocated output (RGBA, same size as the input)
+ * @return true if successful
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_processLargeImage(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jbyteArray inputArray, jint width, jint height,
+        jbyteArray outputArray) {
+
+    try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return JNI_FALSE;
+        }
+
+        if (!inputArray || !outputArray || width <= 0 || height <= 0) {
+            LOGE("processLargeImage needs input and output arrays");
+            return JNI_FALSE;
+        }
+
+        int64_t expected = static_cast<int64_t>(width) * height * 4;
+        if (env->GetArrayLength(inputArray) != expected || env->GetArrayLength(outputArray) != expected) {
+            LOGE("processLargeImage array size mismatch: expected %lld bytes",
+                 static_cast<long long>(expected));
+            return JNI_FALSE;
+        }
+
+        jbyte* inputBytes = env->GetByteArrayElements(inputArray, nullptr);
+        if (!inputBytes) {
+            LOGE("Failed to get input byte array elements");
+            return JNI_FALSE;
+        }
         jbyte* outputBytes = env->GetByteArrayElements(outputArray, nullptr);
         if (!outputBytes) {
             LOGE("Failed to get output byte array elements");
             env->ReleaseByteArrayElements(inputArray, inputBytes, JNI_ABORT);
-            return nullptr;
+            return JNI_FALSE;
         }
 
-        // Process frame with edge detection
-        bool success = EdgeDetection::processFrame(
-                reinterpret_cast<const uint8_t*>(inputBytes),
-                width, height,
-                reinterpret_cast<uint8_t*>(outputBytes)
-        );
+        bool success = detector->processLargeImage(reinterpret_cast<const uint8_t*>(inputBytes), width, height,
+                                                   reinterpret_cast<uint8_t*>(outputBytes));
 
-        // Release input array
+        env->ReleaseByteArrayElements(outputArray, outputBytes, success ? 0 : JNI_ABORT);
         env->ReleaseByteArrayElements(inputArray, inputBytes, JNI_ABORT);
+        return success ? JNI_TRUE : JNI_FALSE;
 
-        if (!success) {
-            LOGE("Frame processing failed");
-            env->ReleaseByteArrayElements(outputArray, outputBytes, JNI_ABORT);
-            return nullptr;
+    } catch (const std::exception& e) {
+        LOGE("Exception in processLargeImage: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * @brief Hand a camera frame to the processing thread (latest frame wins)
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param inputArray Input image data as byte array (RGBA)
+ * @param width Image width
+ * @param height Image height
+ * @return true if the frame was queued
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_submitFrame(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jbyteArray inputArray, jint width, jint height) {
+
+    try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return JNI_FALSE;
+        }
+
+        if (!inputArray) {
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Input array is null");
+            return JNI_FALSE;
+        }
+
+        jsize inputLength = env->GetArrayLength(inputArray);
+        if (inputLength != width * height * 4) {
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Input array size mismatch: expected %d, got %d",
+                          width * height * 4, inputLength);
+            return JNI_FALSE;
         }
 
-        // Commit output array
-        env->ReleaseByteArrayElements(outputArray, outputBytes, 0);
+        auto captureTime = std::chrono::steady_clock::now().time_since_epoch();
 
-        // Update performance metrics
-        frameCount++;
-        auto frameEnd = std::chrono::high_resolution_clock::now();
-        auto frameDuration = std::chrono::duration_cast<std::chrono::milliseconds>
-                (frameEnd - frameStart).count();
+        // Single copy straight into the mailbox back buffer
+        TRACE_SCOPE("jni.submitFrame");
+        EdgeDetection::FrameMailbox& mailbox = detector->mailbox();
+        uint8_t* slot = mailbox.beginWrite(width, height);
+        env->GetByteArrayRegion(inputArray, 0, inputLength, reinterpret_cast<jbyte*>(slot));
+        mailbox.publish(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(captureTime).count());
+
+        return JNI_TRUE;
+
+    } catch (const std::exception& e) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in submitFrame: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * @brief Process the freshest submitted frame, waiting for one if necessary
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param timeoutMs Maximum time to wait for a new frame
+ * @return Processed image as byte array (RGBA), or null on timeout/failure
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_processLatestFrame(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint timeoutMs) {
 
-        if (frameCount % 30 == 0) {  // Log every 30 frames
-            auto totalDuration = std::chrono::duration_cast<std::chrono::milliseconds>
-                    (frameEnd - lastFrameTime).count();
-            averageFps = 30000.0 / totalDuration;  // 30 frames / duration in ms * 1000
-            lastFrameTime = frameEnd;
+    try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return nullptr;
+        }
 
-            LOGI("Frame %d processed in %ld ms, Average FPS: %.2f",
-                 frameCount, frameDuration, averageFps);
+        const EdgeDetection::FrameSlot* frame;
+        {
+            TRACE_SCOPE("mailbox.wait");
+            frame = detector->mailbox().waitForLatest(timeoutMs);
+        }
+        if (!frame) {
+            return nullptr;
         }
+        TRACE_FRAME(frame->sequence);
 
-        return outputArray;
+        return processIntoNewArray(env, *detector, frame->data.data(), frame->width, frame->height);
 
     } catch (const std::exception& e) {
-        LOGE("Exception in processFrame: %s", e.what());
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in processLatestFrame: %s", e.what());
         return nullptr;
     }
 }
 
+/**
+ * @brief Process the freshest submitted frame into the detector's progressive output
+ *
+ * Bands are published to the GL thread as they finish (see uploadFrameBands),
+ * so no output array is created.
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param timeoutMs Maximum time to wait for a new frame
+ * @return true if a frame was processed
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_processLatestFrameProgressive(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint timeoutMs) {
+
+    try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return JNI_FALSE;
+        }
+
+        const EdgeDetection::FrameSlot* frame;
+        {
+            TRACE_SCOPE("mailbox.wait");
+            frame = detector->mailbox().waitForLatest(timeoutMs);
+        }
+        if (!frame) {
+            return JNI_FALSE;
+        }
+        TRACE_FRAME(frame->sequence);
+
+        TRACE_SCOPE("jni.processProgressive");
+        if (!detector->processFrameProgressive(frame->data.data(), frame->width, frame->height,
+                                               frame->timestampNs)) {
+            LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Frame processing failed");
+            return JNI_FALSE;
+        }
+        return JNI_TRUE;
+
+    } catch (const std::exception& e) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in processLatestFrameProgressive: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * @brief Upload the newest progressive frame into a texture band by band as its bands finish
+ *
+ * Call on the GL thread. Returns once every band of the frame is in the
+ * texture, so only the last band's upload is left on the critical path. With
+ * a zero timeout it uploads only the bands already finished and returns, so a
+ * draw per vsync never waits for processing; keep passing the same texture
+ * until a complete frame was reported.
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param textureId OpenGL texture ID
+ * @param width Texture width
+ * @param height Texture height
+ * @param timeoutMs Maximum time to wait for each band
+ * @return true if a complete frame was uploaded
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_uploadFrameBands(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint textureId, jint width, jint height,
+        jint timeoutMs) {
+
+    try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return JNI_FALSE;
+        }
+
+        GLRenderer::TextureInfo textureInfo;
+        textureInfo.textureId = static_cast<unsigned int>(textureId);
+        textureInfo.width = width;
+        textureInfo.height = height;
+        textureInfo.format = 0x1908; // GL_RGBA
+
+        EdgeDetection::ProgressiveFrame& progressive = detector->progressiveFrame();
+        EdgeDetection::FrameBand band;
+        int uploaded = 0;
+        while (progressive.takeBand(band, timeoutMs)) {
+            if (band.width == width && band.height == height) {
+                TRACE_SCOPE("gl.bandUpload");
+                GLRenderer::updateTextureRows(detector->renderContext(), textureInfo, band.data,
+                                              band.rowStart, band.rowEnd);
+                uploaded++;
+            } else {
+                LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Frame %dx%d does not match texture %dx%d",
+                              band.width, band.height, width, height);
+            }
+            progressive.releaseBand();
+            if (progressive.frameTaken()) {
+                break;
+            }
+        }
+        if (uploaded == 0 || !progressive.frameTaken()) {
+            return JNI_FALSE;
+        }
+        detector->frameUploaded();
+        return JNI_TRUE;
+
+    } catch (const std::exception& e) {
+        LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in uploadFrameBands: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * @brief Report that a draw showing the last completely uploaded frame was submitted
+ *
+ * Call on the GL thread after drawing; completes the frame's timeline for the
+ * end-to-end latency statistics.
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_framePresented(
+        JNIEnv* env, jobject thiz, jlong nativePtr) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (detector) {
+        detector->framePresented();
+    }
+}
+
+/**
+ * @brief Start processing submitted frames on a native thread at a fixed rate
+ *
+ * Replaces a Java loop around processLatestFrameProgressive: frames are taken
+ * from the mailbox every 1/targetHz, frames older than the deadline are dropped,
+ * and results go to the progressive output for uploadFrameBands. Calling again
+ * while running only changes the pacing.
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param targetHz Processing rate; 0 = as fast as frames arrive
+ * @param deadlineMs Oldest capture age a frame may start processing at; 0 = two intervals
+ * @return true if the scheduler is running
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_startScheduler(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jdouble targetHz, jdouble deadlineMs) {
+
+    try {
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return JNI_FALSE;
+        }
+
+        EdgeDetection::SchedulerConfig config;
+        config.targetHz = targetHz;
+        config.deadlineMs = deadlineMs;
+        detector->startScheduler(config);
+        return JNI_TRUE;
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in startScheduler: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * @brief Stop the native processing thread, waiting for the frame in progress
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_stopScheduler(
+        JNIEnv* env, jobject thiz, jlong nativePtr) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (detector) {
+        detector->stopScheduler();
+    }
+}
+
+/**
+ * @brief Wake the processing thread if it is blocked in processLatestFrame
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_interruptFrameWait(
+        JNIEnv* env, jobject thiz, jlong nativePtr) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (detector) {
+        detector->mailbox().interrupt();
+    }
+}
+
 /**
  * @brief Initialize OpenGL ES renderer
  * @param env JNI environment
  * @param thiz Java object instance
+ * @param nativePtr Native handle
  * @param width Surface width
  * @param height Surface height
  * @return true if successful
  */
 JNIEXPORT jboolean JNICALL
 Java_com_example_edgedetectionviewer_EdgeDetectionJNI_initGL(
-        JNIEnv* env, jobject thiz, jint width, jint height) {
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint width, jint height) {
 
     LOGI("Initializing OpenGL ES renderer (%dx%d)", width, height);
 
     try {
-        bool success = GLRenderer::initializeGL(width, height);
+        EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+        if (!detector) {
+            return JNI_FALSE;
+        }
+
+        bool success = GLRenderer::initializeGL(detector->renderContext(), width, height);
         return success ? JNI_TRUE : JNI_FALSE;
 
     } catch (const std::exception& e) {
@@ -242,6 +794,7 @@ Java_com_example_edgedetectionviewer_EdgeDetectionJNI_createTexture(
  * @brief Update texture with processed frame data
  * @param env JNI environment
  * @param thiz Java object instance
+ * @param nativePtr Native handle
  * @param textureId OpenGL texture ID
  * @param pixelData Processed image data
  * @param width Image width
@@ -249,18 +802,23 @@ Java_com_example_edgedetectionviewer_EdgeDetectionJNI_createTexture(
  */
 JNIEXPORT void JNICALL
 Java_com_example_edgedetectionviewer_EdgeDetectionJNI_updateTexture(
-        JNIEnv* env, jobject thiz, jint textureId, jbyteArray pixelData,
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint textureId, jbyteArray pixelData,
         jint width, jint height) {
 
 try {
+EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+if (!detector) {
+return;
+}
+
 if (!pixelData) {
-LOGE("Pixel data is null");
+LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Pixel data is null");
 return;
 }
 
 jbyte* pixels = env->GetByteArrayElements(pixelData, nullptr);
 if (!pixels) {
-LOGE("Failed to get pixel data elements");
+LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Failed to get pixel data elements");
 return;
 }
 
@@ -270,13 +828,16 @@ textureInfo.width = width;
 textureInfo.height = height;
 textureInfo.format = 0x1908; // GL_RGBA
 
-GLRenderer::updateTexture(textureInfo,
+{
+TRACE_SCOPE("gl.textureUpload");
+GLRenderer::updateTexture(detector->renderContext(), textureInfo,
 reinterpret_cast<const uint8_t*>(pixels));
+}
 
 env->ReleaseByteArrayElements(pixelData, pixels, JNI_ABORT);
 
 } catch (const std::exception& e) {
-LOGE("Exception in updateTexture: %s", e.what());
+LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in updateTexture: %s", e.what());
 }
 }
 
@@ -284,14 +845,20 @@ LOGE("Exception in updateTexture: %s", e.what());
  * @brief Render texture to screen
  * @param env JNI environment
  * @param thiz Java object instance
+ * @param nativePtr Native handle
  * @param programId Shader program ID
  * @param textureId Texture ID
  */
 JNIEXPORT void JNICALL
 Java_com_example_edgedetectionviewer_EdgeDetectionJNI_renderFrame(
-        JNIEnv* env, jobject thiz, jint programId, jint textureId) {
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint programId, jint textureId) {
 
 try {
+EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+if (!detector) {
+return;
+}
+
 GLRenderer::ShaderProgram program;
 program.programId = static_cast<unsigned int>(programId);
 // Note: In a real implementation, you'd store these attribute/uniform locations
@@ -303,10 +870,11 @@ program.mvpMatrixUniform = -1;
 GLRenderer::TextureInfo textureInfo;
 textureInfo.textureId = static_cast<unsigned int>(textureId);
 
-GLRenderer::renderTexture(program, textureInfo);
+TRACE_SCOPE("gl.render");
+GLRenderer::renderTexture(detector->renderContext(), program, textureInfo);
 
 } catch (const std::exception& e) {
-LOGE("Exception in renderFrame: %s", e.what());
+LOGE_EVERY_MS(EdgeDetection::kFrameLogIntervalMs, "Exception in renderFrame: %s", e.what());
 }
 }
 
@@ -314,39 +882,182 @@ LOGE("Exception in renderFrame: %s", e.what());
  * @brief Get current performance statistics
  * @param env JNI environment
  * @param thiz Java object instance
- * @return String containing performance metrics
+ * @param nativePtr Native handle
+ * @return ProcessingStats snapshot, or null on failure
  */
-JNIEXPORT jstring JNICALL
+JNIEXPORT jobject JNICALL
         Java_com_example_edgedetectionviewer_EdgeDetectionJNI_getPerformanceStats(
-        JNIEnv* env, jobject thiz) {
+        JNIEnv* env, jobject thiz, jlong nativePtr) {
 
 try {
-std::string stats = "Frames: " + std::to_string(frameCount) +
-                    ", FPS: " + std::to_string(averageFps);
+EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+if (!detector) {
+return nullptr;
+}
 
-return env->NewStringUTF(stats.c_str());
+return newJavaStats(env, detector->getStats());
 
 } catch (const std::exception& e) {
 LOGE("Exception in getPerformanceStats: %s", e.what());
-return env->NewStringUTF("Error getting stats");
+return nullptr;
+}
+}
+
+/**
+ * @brief Update edge detection parameters; the next frame picks them up
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param lowThreshold Lower Canny threshold
+ * @param highThreshold Upper Canny threshold
+ * @param blurKernel Gaussian blur kernel size (odd, up to 31; see gaussianBlur for the backends)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_updateParameters(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jdouble lowThreshold, jdouble highThreshold,
+        jint blurKernel) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (!detector) {
+        return;
+    }
+
+    EdgeDetection::DetectorParameters applied =
+            detector->updateParameters(lowThreshold, highThreshold, blurKernel);
+    LOGI("Parameters v%llu: thresholds %.1f/%.1f, blur %d",
+         static_cast<unsigned long long>(applied.version),
+         applied.lowThreshold, applied.highThreshold, applied.blurKernel);
+}
+
+/**
+ * @brief Skip frames of a static scene, showing the previous output again
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param enabled true to skip static frames
+ * @param threshold Largest thumbnail luma change (0-255) below which a frame is static
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_setMotionGate(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jboolean enabled, jdouble threshold) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (detector) {
+        detector->setMotionGate(enabled == JNI_TRUE, threshold);
+    }
+}
+
+/**
+ * @brief Build frames of a panning camera from the previous edge map shifted by the global motion
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param enabled true to reuse shifted edges where verification allows
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_setMotionCompensation(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jboolean enabled) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (detector) {
+        detector->setMotionCompensation(enabled == JNI_TRUE);
+    }
+}
+
+/**
+ * @brief Select preview quality: recompute every factor-th row band per frame, composite the rest
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param factor 1 for full quality, 2 or 4 for interlaced preview
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_setInterlace(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint factor) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (detector) {
+        detector->setInterlace(factor);
+    }
+}
+
+/**
+ * @brief Select the output layout: edge mask only, or mask packed with gradient magnitude, direction and strength
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param nativePtr Native handle
+ * @param format 0 for the mask in every channel, 1 for packed channels
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_setOutputFormat(
+        JNIEnv* env, jobject thiz, jlong nativePtr, jint format) {
+
+    EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+    if (detector) {
+        detector->setOutputFormat(format == 1 ? EdgeDetection::OutputFormat::Packed
+                                              : EdgeDetection::OutputFormat::Mask);
+    }
+}
+
+/**
+ * @brief Start or stop recording pipeline trace events (needs EDGE_ENABLE_TRACING builds)
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param enabled true to record
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_setTracingEnabled(
+        JNIEnv* env, jobject thiz, jboolean enabled) {
+
+    EdgeDetection::Trace::setEnabled(enabled == JNI_TRUE);
 }
+
+/**
+ * @brief Write buffered trace events as Chrome trace_event JSON
+ * @param env JNI environment
+ * @param thiz Java object instance
+ * @param path Output file (e.g. in the app's files directory)
+ * @return true if the file was written
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionviewer_EdgeDetectionJNI_dumpTrace(
+        JNIEnv* env, jobject thiz, jstring path) {
+
+    if (!path) {
+        LOGE("Trace path is null");
+        return JNI_FALSE;
+    }
+
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (!pathChars) {
+        return JNI_FALSE;
+    }
+
+    bool written = EdgeDetection::Trace::dumpChromeTrace(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return written ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
  * @brief Cleanup native resources
  * @param env JNI environment
  * @param thiz Java object instance
+ * @param nativePtr Native handle
  */
 JNIEXPORT void JNICALL
 Java_com_example_edgedetectionviewer_EdgeDetectionJNI_cleanup(
-        JNIEnv* env, jobject thiz) {
+        JNIEnv* env, jobject thiz, jlong nativePtr) {
 
 LOGI("Cleaning up native resources");
 
 try {
+EdgeDetection::EdgeDetector* detector = fromHandle(nativePtr);
+if (!detector) {
+return;
+}
+
 // Reset performance counters
-frameCount = 0;
-averageFps = 0.0;
+detector->resetStats();
 
 LOGI("Native cleanup completed");
 
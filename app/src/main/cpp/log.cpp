@@ -0,0 +1,183 @@
+//
+// Asynchronous logging: lock-free line queue drained by a writer thread
+//
+#include "log.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+
+namespace EdgeDetection {
+
+    // Queue capacity (power of two) and the longest line kept (longer lines are truncated)
+    static const size_t kLogQueueSize = 256;
+    static const size_t kLogLineSize = 480;
+
+    // How long the writer sleeps when idle; warnings and errors wake it at once
+    static const int kWriterIdleMs = 20;
+
+    struct LogRecord {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        const char* tag;
+        char text[kLogLineSize];
+    };
+
+    /**
+     * Bounded multi-producer queue (Vyukov): each slot's sequence tells
+     * producers and the single consumer whose turn it is, so enqueueing is one
+     * CAS on the tail plus a release store, with no locks.
+     */
+    struct LogQueue {
+        LogQueue() {
+            for (size_t i = 0; i < kLogQueueSize; i++) {
+                records[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        LogRecord records[kLogQueueSize];
+        alignas(64) std::atomic<size_t> tail{0};   // Next slot producers claim
+        alignas(64) std::atomic<size_t> head{0};   // Next slot the writer reads (writer only)
+        std::atomic<size_t> written{0};            // Lines handed to the platform so far
+        std::atomic<uint32_t> dropped{0};          // Lines lost to a full queue since last report
+
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::condition_variable drained;
+    };
+
+    // Intentionally leaked (and the writer detached): threads may log while statics are destroyed
+    static LogQueue& logQueue();
+
+    static void writeLine(LogLevel level, const char* tag, const char* text) {
+#ifdef __ANDROID__
+        int priority = ANDROID_LOG_INFO;
+        switch (level) {
+            case LogLevel::Debug: priority = ANDROID_LOG_DEBUG; break;
+            case LogLevel::Info:  priority = ANDROID_LOG_INFO;  break;
+            case LogLevel::Warn:  priority = ANDROID_LOG_WARN;  break;
+            case LogLevel::Error: priority = ANDROID_LOG_ERROR; break;
+        }
+        __android_log_write(priority, tag, text);
+#else
+        static const char levelChars[] = {'D', 'I', 'W', 'E'};
+        fprintf(stderr, "%c/%s: %s\n", levelChars[static_cast<int>(level)], tag, text);
+#endif
+    }
+
+    static void writerLoop(LogQueue& queue) {
+        size_t head = queue.head.load(std::memory_order_relaxed);
+        for (;;) {
+            LogRecord& record = queue.records[head % kLogQueueSize];
+            if (record.sequence.load(std::memory_order_acquire) == head + 1) {
+                writeLine(record.level, record.tag, record.text);
+                // Hand the slot back to producers one lap later
+                record.sequence.store(head + kLogQueueSize, std::memory_order_release);
+                head++;
+                queue.head.store(head, std::memory_order_relaxed);
+                queue.written.store(head, std::memory_order_release);
+                continue;
+            }
+
+            uint32_t dropped = queue.dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                char text[64];
+                snprintf(text, sizeof(text), "%u log lines dropped (queue full)", dropped);
+                writeLine(LogLevel::Warn, "Log", text);
+            }
+
+            std::unique_lock<std::mutex> lock(queue.wakeMutex);
+            queue.drained.notify_all();
+            queue.wake.wait_for(lock, std::chrono::milliseconds(kWriterIdleMs));
+        }
+    }
+
+    static LogQueue& logQueue() {
+        static LogQueue* instance = [] {
+            LogQueue* queue = new LogQueue();
+            std::thread(writerLoop, std::ref(*queue)).detach();
+            // Host tools exit right after their last line; give the writer a chance to finish
+            atexit([] { logFlush(); });
+            return queue;
+        }();
+        return *instance;
+    }
+
+    static void enqueue(LogLevel level, const char* tag, uint32_t suppressed,
+                        const char* format, va_list args) {
+        LogQueue& queue = logQueue();
+
+        size_t position = queue.tail.load(std::memory_order_relaxed);
+        LogRecord* record;
+        for (;;) {
+            record = &queue.records[position % kLogQueueSize];
+            size_t sequence = record->sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0) {
+                if (queue.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // Writer is a full lap behind: drop rather than block the caller,
+                // except for errors, which are rare and worth a synchronous write
+                if (level == LogLevel::Error) {
+                    char text[kLogLineSize];
+                    vsnprintf(text, sizeof(text), format, args);
+                    writeLine(level, tag, text);
+                } else {
+                    queue.dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                return;
+            } else {
+                position = queue.tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        record->level = level;
+        record->tag = tag;
+        int length = vsnprintf(record->text, kLogLineSize, format, args);
+        if (suppressed > 0 && length >= 0 && static_cast<size_t>(length) < kLogLineSize) {
+            snprintf(record->text + length, kLogLineSize - length, " (%u similar suppressed)", suppressed);
+        }
+        record->sequence.store(position + 1, std::memory_order_release);
+
+        if (level >= LogLevel::Warn) {
+            queue.wake.notify_one();
+        }
+    }
+
+    void logPrint(LogLevel level, const char* tag, const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        enqueue(level, tag, 0, format, args);
+        va_end(args);
+    }
+
+    void logPrintSuppressed(LogLevel level, const char* tag, uint32_t suppressed,
+                            const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        enqueue(level, tag, suppressed, format, args);
+        va_end(args);
+    }
+
+    void logFlush(int timeoutMs) {
+        LogQueue& queue = logQueue();
+        size_t target = queue.tail.load(std::memory_order_acquire);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        std::unique_lock<std::mutex> lock(queue.wakeMutex);
+        queue.wake.notify_one();
+        queue.drained.wait_until(lock, deadline, [&] {
+            return queue.written.load(std::memory_order_acquire) >= target;
+        });
+    }
+
+} // namespace EdgeDetection
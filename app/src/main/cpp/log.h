@@ -0,0 +1,140 @@
+#ifndef EDGE_LOG_H
+#define EDGE_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Logging
+ *
+ * LOGD/LOGI/LOGW/LOGE format the message into a preallocated slot of a
+ * lock-free queue and return; a background thread writes the lines to logcat
+ * (stderr on host builds), so a log call on the frame path costs a vsnprintf
+ * and never blocks on logd. If the queue is full the line is dropped and
+ * counted rather than stalling the caller.
+ *
+ * Levels below EDGE_LOG_MIN_LEVEL (0 debug .. 3 error; default: info when
+ * NDEBUG is defined, debug otherwise) are removed at compile time. Call sites
+ * that can fire every frame use the *_EVERY_MS variants, which let through at
+ * most one line per interval and report how many were suppressed.
+ */
+
+#define EDGE_LOG_LEVEL_DEBUG 0
+#define EDGE_LOG_LEVEL_INFO  1
+#define EDGE_LOG_LEVEL_WARN  2
+#define EDGE_LOG_LEVEL_ERROR 3
+
+#ifndef EDGE_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define EDGE_LOG_MIN_LEVEL EDGE_LOG_LEVEL_INFO
+#else
+#define EDGE_LOG_MIN_LEVEL EDGE_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EDGE_LOG_PRINTF(formatIndex, firstArg) __attribute__((format(printf, formatIndex, firstArg)))
+#else
+#define EDGE_LOG_PRINTF(formatIndex, firstArg)
+#endif
+
+namespace EdgeDetection {
+
+/**
+ * @brief Log severity, mapped to the platform's priorities
+ */
+    enum class LogLevel {
+        Debug = EDGE_LOG_LEVEL_DEBUG,
+        Info = EDGE_LOG_LEVEL_INFO,
+        Warn = EDGE_LOG_LEVEL_WARN,
+        Error = EDGE_LOG_LEVEL_ERROR
+    };
+
+    // Interval for rate-limited messages on the per-frame path
+    constexpr int64_t kFrameLogIntervalMs = 1000;
+
+/**
+ * @brief Queue one printf-style log line for the background writer
+ * @param level Severity
+ * @param tag Component tag (LOG_TAG of the calling file); must be a string literal
+ * @param format printf format string
+ */
+    void logPrint(LogLevel level, const char* tag, const char* format, ...) EDGE_LOG_PRINTF(3, 4);
+
+/**
+ * @brief Like logPrint, noting how many earlier lines of the call site were suppressed
+ */
+    void logPrintSuppressed(LogLevel level, const char* tag, uint32_t suppressed,
+                            const char* format, ...) EDGE_LOG_PRINTF(4, 5);
+
+/**
+ * @brief Wait until every line queued so far has been written
+ * @param timeoutMs Give up after this long (the writer may be stuck on logd)
+ */
+    void logFlush(int timeoutMs = 500);
+
+/**
+ * @brief Per-call-site limiter: admits at most one line per interval
+ *
+ * Lives in a function-local static created by the *_EVERY_MS macros. The check
+ * is a clock read (vDSO, no syscall) and one relaxed load when suppressed.
+ */
+    class LogRateLimiter {
+    public:
+        /**
+         * @brief Decide whether the current line may be written
+         * @param intervalMs Minimum time between admitted lines
+         * @param suppressed Receives the number of lines dropped since the last admitted one
+         */
+        bool admit(int64_t intervalMs, uint32_t& suppressed) {
+            int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+            int64_t next = nextMs_.load(std::memory_order_relaxed);
+            if (now < next ||
+                !nextMs_.compare_exchange_strong(next, now + intervalMs, std::memory_order_relaxed)) {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+    private:
+        std::atomic<int64_t> nextMs_{0};
+        std::atomic<uint32_t> suppressed_{0};
+    };
+
+} // namespace EdgeDetection
+
+// Each translation unit defines LOG_TAG before using these. Disabled levels
+// still type-check their arguments but generate no code.
+#define EDGE_LOG(level, ...) \
+    do { \
+        if (static_cast<int>(level) >= EDGE_LOG_MIN_LEVEL) { \
+            ::EdgeDetection::logPrint(level, LOG_TAG, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define EDGE_LOG_EVERY_MS(level, intervalMs, ...) \
+    do { \
+        if (static_cast<int>(level) >= EDGE_LOG_MIN_LEVEL) { \
+            static ::EdgeDetection::LogRateLimiter edgeLogLimiter_; \
+            uint32_t edgeLogSuppressed_ = 0; \
+            if (edgeLogLimiter_.admit(intervalMs, edgeLogSuppressed_)) { \
+                ::EdgeDetection::logPrintSuppressed(level, LOG_TAG, edgeLogSuppressed_, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOGD(...) EDGE_LOG(::EdgeDetection::LogLevel::Debug, __VA_ARGS__)
+#define LOGI(...) EDGE_LOG(::EdgeDetection::LogLevel::Info, __VA_ARGS__)
+#define LOGW(...) EDGE_LOG(::EdgeDetection::LogLevel::Warn, __VA_ARGS__)
+#define LOGE(...) EDGE_LOG(::EdgeDetection::LogLevel::Error, __VA_ARGS__)
+
+#define LOGD_EVERY_MS(intervalMs, ...) EDGE_LOG_EVERY_MS(::EdgeDetection::LogLevel::Debug, intervalMs, __VA_ARGS__)
+#define LOGI_EVERY_MS(intervalMs, ...) EDGE_LOG_EVERY_MS(::EdgeDetection::LogLevel::Info, intervalMs, __VA_ARGS__)
+#define LOGW_EVERY_MS(intervalMs, ...) EDGE_LOG_EVERY_MS(::EdgeDetection::LogLevel::Warn, intervalMs, __VA_ARGS__)
+#define LOGE_EVERY_MS(intervalMs, ...) EDGE_LOG_EVERY_MS(::EdgeDetection::LogLevel::Error, intervalMs, __VA_ARGS__)
+
+#endif // EDGE_LOG_H
@@ -0,0 +1,241 @@
+//
+// Size-class pooled cv::MatAllocator with huge-page backing for frame buffers
+//
+#include "mat_allocator.h"
+#include "log.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define LOG_TAG "MatAllocator"
+
+namespace EdgeDetection {
+
+    // Same alignment OpenCV's fastMalloc guarantees
+    static const size_t kBlockAlignment = 64;
+
+    static std::atomic<PooledMatAllocator*> installedAllocator(nullptr);
+
+    PooledMatAllocator::PooledMatAllocator()
+            : allocations_(0), poolHits_(0), hugePageBlocks_(0), bytesInUse_(0), bytesCached_(0) {
+    }
+
+    PooledMatAllocator::~PooledMatAllocator() {
+        trim();
+    }
+
+    PooledMatAllocator* PooledMatAllocator::install() {
+        // Leaked on purpose: Mats in static storage may be freed after main() returns
+        static PooledMatAllocator* instance = [] {
+            auto* allocator = new PooledMatAllocator();
+            cv::Mat::setDefaultAllocator(allocator);
+            installedAllocator.store(allocator, std::memory_order_release);
+            LOGI("Pooled Mat allocator installed");
+            return allocator;
+        }();
+        return instance;
+    }
+
+    PooledMatAllocator* PooledMatAllocator::installed() {
+        return installedAllocator.load(std::memory_order_acquire);
+    }
+
+    int PooledMatAllocator::classIndex(size_t bytes, size_t* classBytes) {
+        if (bytes <= kMinBlockBytes) {
+            *classBytes = kMinBlockBytes;
+            return 0;
+        }
+        if (bytes > kMaxPooledBytes) {
+            *classBytes = bytes;
+            return -1;
+        }
+
+        // Split [2^msb, 2^(msb+1)) into quarters and round up to the next quarter
+        int msb = 63 - __builtin_clzll(static_cast<unsigned long long>(bytes - 1));
+        int shift = msb - 2;
+        size_t quarter = (bytes - 1) >> shift;      // In [4, 7]
+        *classBytes = (quarter + 1) << shift;
+        return 1 + (msb - 6) * 4 + static_cast<int>(quarter - 4);
+    }
+
+    size_t PooledMatAllocator::classSize(int index) {
+        if (index == 0) {
+            return kMinBlockBytes;
+        }
+        int msb = 6 + (index - 1) / 4;
+        size_t quarter = 4 + (index - 1) % 4;
+        return (quarter + 1) << (msb - 2);
+    }
+
+    void* PooledMatAllocator::allocateBlock(size_t bytes, bool* hugePages) {
+        *hugePages = bytes >= kHugePageBytes;
+        size_t alignment = *hugePages ? kHugePageBytes : kBlockAlignment;
+
+        void* block = nullptr;
+        if (posix_memalign(&block, alignment, bytes) != 0) {
+            return nullptr;
+        }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        // Advisory only: kernels without transparent huge pages reject it, which is fine
+        if (*hugePages && madvise(block, bytes, MADV_HUGEPAGE) != 0) {
+            *hugePages = false;
+        }
+#else
+        *hugePages = false;
+#endif
+        return block;
+    }
+
+    void PooledMatAllocator::freeBlock(void* block) {
+        free(block);
+    }
+
+    void* PooledMatAllocator::acquire(size_t bytes, bool counted) const {
+        size_t classBytes;
+        int index = classIndex(bytes, &classBytes);
+        if (counted) {
+            allocations_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (index >= 0) {
+            SizeClass& sizeClass = classes_[index];
+            std::lock_guard<std::mutex> lock(sizeClass.mutex);
+            if (FreeBlock* block = sizeClass.head) {
+                sizeClass.head = block->next;
+                if (counted) {
+                    poolHits_.fetch_add(1, std::memory_order_relaxed);
+                }
+                bytesCached_.fetch_sub(static_cast<int64_t>(classBytes), std::memory_order_relaxed);
+                bytesInUse_.fetch_add(static_cast<int64_t>(classBytes), std::memory_order_relaxed);
+                return block;
+            }
+        }
+
+        bool hugePages;
+        void* block = allocateBlock(classBytes, &hugePages);
+        if (!block) {
+            // Cached blocks of other classes may be what stands between us and success
+            trim();
+            block = allocateBlock(classBytes, &hugePages);
+            if (!block) {
+                CV_Error(cv::Error::StsNoMem, "Failed to allocate Mat buffer");
+            }
+        }
+        if (hugePages) {
+            hugePageBlocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        bytesInUse_.fetch_add(static_cast<int64_t>(classBytes), std::memory_order_relaxed);
+        return block;
+    }
+
+    void PooledMatAllocator::release(void* block, size_t bytes) const {
+        size_t classBytes;
+        int index = classIndex(bytes, &classBytes);
+        bytesInUse_.fetch_sub(static_cast<int64_t>(classBytes), std::memory_order_relaxed);
+
+        // Cap is approximate under concurrency; it only bounds how much memory idles
+        if (index < 0 ||
+            bytesCached_.load(std::memory_order_relaxed) + static_cast<int64_t>(classBytes) >
+            static_cast<int64_t>(kMaxCachedBytes)) {
+            freeBlock(block);
+            return;
+        }
+
+        SizeClass& sizeClass = classes_[index];
+        std::lock_guard<std::mutex> lock(sizeClass.mutex);
+        auto* freed = static_cast<FreeBlock*>(block);
+        freed->next = sizeClass.head;
+        sizeClass.head = freed;
+        bytesCached_.fetch_add(static_cast<int64_t>(classBytes), std::memory_order_relaxed);
+    }
+
+    cv::UMatData* PooledMatAllocator::allocate(int dims, const int* sizes, int type, void* data0,
+                                               size_t* step, cv::AccessFlag /*flags*/,
+                                               cv::UMatUsageFlags /*usageFlags*/) const {
+        // Same layout rules as OpenCV's StdMatAllocator
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) {
+                if (data0 && step[i] != CV_AUTOSTEP) {
+                    CV_Assert(total <= step[i]);
+                    total = step[i];
+                } else {
+                    step[i] = total;
+                }
+            }
+            total *= sizes[i];
+        }
+
+        uchar* data = data0 ? static_cast<uchar*>(data0) : static_cast<uchar*>(acquire(total, true));
+        // The header comes from the pool too, so steady-state Mat churn never reaches malloc
+        cv::UMatData* u = new (acquire(sizeof(cv::UMatData), false)) cv::UMatData(this);
+        u->data = u->origdata = data;
+        u->size = total;
+        if (data0) {
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+        }
+        return u;
+    }
+
+    bool PooledMatAllocator::allocate(cv::UMatData* u, cv::AccessFlag /*accessFlags*/,
+                                      cv::UMatUsageFlags /*usageFlags*/) const {
+        return u != nullptr;
+    }
+
+    void PooledMatAllocator::deallocate(cv::UMatData* u) const {
+        if (!u) {
+            return;
+        }
+
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+            release(u->origdata, u->size);
+            u->origdata = nullptr;
+        }
+        u->~UMatData();
+        release(u, sizeof(cv::UMatData));
+    }
+
+    MatAllocatorStats PooledMatAllocator::stats() const {
+        MatAllocatorStats stats;
+        stats.allocations = allocations_.load(std::memory_order_relaxed);
+        stats.poolHits = poolHits_.load(std::memory_order_relaxed);
+        stats.hugePageBlocks = hugePageBlocks_.load(std::memory_order_relaxed);
+        stats.bytesInUse = bytesInUse_.load(std::memory_order_relaxed);
+        stats.bytesCached = bytesCached_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void PooledMatAllocator::reportTo(ProcessingStats& stats) const {
+        MatAllocatorStats allocator = this->stats();
+        stats.matAllocations = allocator.allocations;
+        stats.matPoolHits = allocator.poolHits;
+        stats.matBytesInUse = allocator.bytesInUse;
+        stats.matBytesCached = allocator.bytesCached;
+    }
+
+    void PooledMatAllocator::trim() const {
+        for (int i = 0; i < kClassCount; i++) {
+            FreeBlock* block;
+            {
+                std::lock_guard<std::mutex> lock(classes_[i].mutex);
+                block = classes_[i].head;
+                classes_[i].head = nullptr;
+            }
+
+            size_t classBytes = classSize(i);
+            while (block) {
+                FreeBlock* next = block->next;
+                freeBlock(block);
+                bytesCached_.fetch_sub(static_cast<int64_t>(classBytes), std::memory_order_relaxed);
+                block = next;
+            }
+        }
+    }
+
+} // namespace EdgeDetection
@@ -0,0 +1,115 @@
+#ifndef MAT_ALLOCATOR_H
+#define MAT_ALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "image_processor.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Counters of the pooled Mat allocator
+ */
+    struct MatAllocatorStats {
+        uint64_t allocations;       // Mat buffers handed out
+        uint64_t poolHits;          // ... of which were served from a free list
+        uint64_t hugePageBlocks;    // Blocks advised for transparent huge pages
+        int64_t bytesInUse;         // Bytes held by live Mats and their headers (rounded to size classes)
+        int64_t bytesCached;        // Bytes parked on free lists
+    };
+
+/**
+ * @brief cv::MatAllocator serving Mat buffers from size-class free lists
+ *
+ * OpenCV allocates temporaries inside calls we cannot change (GaussianBlur's
+ * row buffers, Canny's gradient and map images); with the default allocator
+ * each one is a fastMalloc, and frame-sized ones also pay page faults on
+ * first touch because large allocations come back from mmap. This allocator
+ * rounds requests up to one of four classes per power of two (at most 25%
+ * slack) and keeps freed blocks on per-class lists, up to kMaxCachedBytes in
+ * total, so steady-state frames reuse warm memory. Blocks of kHugePageBytes
+ * and more are 2 MiB aligned and advised MADV_HUGEPAGE on Linux, cutting TLB
+ * misses on full-frame passes.
+ *
+ * Install once with install(); Mats allocated earlier keep their original
+ * allocator, which frees them correctly.
+ */
+    class PooledMatAllocator : public cv::MatAllocator {
+    public:
+        static const size_t kMinBlockBytes = 64;
+        static const size_t kMaxPooledBytes = size_t(64) << 20;     // Larger blocks bypass the pool
+        static const size_t kHugePageBytes = size_t(2) << 20;
+        static const size_t kMaxCachedBytes = size_t(96) << 20;
+
+        PooledMatAllocator();
+        ~PooledMatAllocator() override;
+
+        PooledMatAllocator(const PooledMatAllocator&) = delete;
+        PooledMatAllocator& operator=(const PooledMatAllocator&) = delete;
+
+        /**
+         * @brief Make the process-wide pooled allocator OpenCV's default (idempotent)
+         * @return The installed allocator (never destroyed)
+         */
+        static PooledMatAllocator* install();
+
+        /**
+         * @brief The allocator installed by install(), or nullptr
+         */
+        static PooledMatAllocator* installed();
+
+        cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                               cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+        bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                      cv::UMatUsageFlags usageFlags) const override;
+        void deallocate(cv::UMatData* data) const override;
+
+        MatAllocatorStats stats() const;
+
+        /**
+         * @brief Add this allocator's counters to a statistics snapshot
+         */
+        void reportTo(ProcessingStats& stats) const;
+
+        /**
+         * @brief Return all cached blocks to the system (e.g. on memory pressure)
+         */
+        void trim() const;
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct SizeClass {
+            std::mutex mutex;
+            FreeBlock* head = nullptr;
+        };
+
+        // Four classes per power of two from kMinBlockBytes up to kMaxPooledBytes
+        static const int kClassCount = 81;
+
+        static int classIndex(size_t bytes, size_t* classBytes);
+        static size_t classSize(int index);
+        static void* allocateBlock(size_t bytes, bool* hugePages);
+        static void freeBlock(void* block);
+
+        // counted: a Mat buffer (reported in stats) rather than a UMatData header
+        void* acquire(size_t bytes, bool counted) const;
+        void release(void* block, size_t bytes) const;
+
+        mutable SizeClass classes_[kClassCount];
+
+        mutable std::atomic<uint64_t> allocations_;
+        mutable std::atomic<uint64_t> poolHits_;
+        mutable std::atomic<uint64_t> hugePageBlocks_;
+        mutable std::atomic<int64_t> bytesInUse_;
+        mutable std::atomic<int64_t> bytesCached_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // MAT_ALLOCATOR_H
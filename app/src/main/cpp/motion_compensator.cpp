@@ -0,0 +1,310 @@
+//
+// Edge map reuse for panning cameras via projection-profile shift estimation
+//
+#include "motion_compensator.h"
+#include "log.h"
+#include "processing_stats.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#define LOG_TAG "MotionCompensator"
+
+namespace EdgeDetection {
+
+    // Mean absolute profile difference per summed pixel above which the frames are not a translation
+    static const double kMaxProfileError = 3.0;
+
+    // Fraction of the sampled edge pixels that may disagree with the shifted edge map
+    static const double kMaxVerifyMismatch = 0.25;
+
+/**
+ * @brief Shift s minimizing the mean absolute difference of current[i] and previous[i - s]
+ * @param previous Profile of the previous frame
+ * @param current Profile of the current frame, same length
+ * @param length Profile length
+ * @param maxShift Largest shift tried in either direction
+ * @param error Receives the mean absolute difference at the returned shift
+ * @return Best shift; ties go to the smaller shift
+ */
+    static int matchProfiles(const int* previous, const int* current, int length, int maxShift,
+                             double& error) {
+        int bestShift = 0;
+        double bestError = std::numeric_limits<double>::max();
+        maxShift = std::min(maxShift, length / 2);
+
+        // 0, 1, -1, 2, -2, ... so that a featureless profile reports no motion
+        for (int step = 0; step <= 2 * maxShift; step++) {
+            int shift = (step & 1) ? (step + 1) / 2 : -(step / 2);
+            int start = std::max(0, shift);
+            int end = std::min(length, length + shift);
+
+            int64_t sad = 0;
+            for (int i = start; i < end; i++) {
+                sad += std::abs(current[i] - previous[i - shift]);
+            }
+            double mean = static_cast<double>(sad) / (end - start);
+            if (mean < bestError) {
+                bestError = mean;
+                bestShift = shift;
+            }
+        }
+        error = bestError;
+        return bestShift;
+    }
+
+/**
+ * @brief Copy src into dst at the given position, row by row
+ */
+    static void copyInto(const cv::Mat& src, cv::Mat& dst, cv::Point at) {
+        for (int y = 0; y < src.rows; y++) {
+            std::memcpy(dst.ptr<uchar>(at.y + y) + at.x, src.ptr<uchar>(y), src.cols);
+        }
+    }
+
+    MotionCompensator::MotionCompensator()
+            : enabled_(false),
+              width_(0),
+              height_(0),
+              version_(0),
+              pendingWidth_(0),
+              pendingHeight_(0),
+              pendingVersion_(0),
+              reusedRun_(0),
+              verifyCursor_(0) {
+    }
+
+    void MotionCompensator::computeProfiles(const cv::Mat& frame) {
+        cv::cvtColor(frame, gray_, cv::COLOR_RGBA2GRAY);
+        cv::reduce(gray_, columnProfile_, 0, cv::REDUCE_SUM, CV_32S);
+        cv::reduce(gray_, rowProfile_, 1, cv::REDUCE_SUM, CV_32S);
+    }
+
+    GlobalShift MotionCompensator::estimateShift() {
+        GlobalShift shift;
+        int width = gray_.cols;
+        int height = gray_.rows;
+
+        // Whole-frame profiles first; each also carries the rows (columns) the other
+        // axis' motion exchanged, so a diagonal pan only gets this close
+        double error;
+        shift.dx = matchProfiles(previousColumnProfile_.ptr<int>(0), columnProfile_.ptr<int>(0),
+                                 width, kMaxGlobalShift, error);
+        shift.dy = matchProfiles(previousRowProfile_.ptr<int>(0), rowProfile_.ptr<int>(0),
+                                 height, kMaxGlobalShift, error);
+
+        // Then each axis again over the other axis' overlap only, which removes the exchanged strip
+        int overlapTop = std::max(0, shift.dy);
+        int overlapBottom = std::min(height, height + shift.dy);
+        cv::reduce(gray_.rowRange(overlapTop, overlapBottom), currentOverlap_, 0, cv::REDUCE_SUM, CV_32S);
+        cv::reduce(previousGray_.rowRange(overlapTop - shift.dy, overlapBottom - shift.dy), previousOverlap_,
+                   0, cv::REDUCE_SUM, CV_32S);
+        double errorX;
+        int dx = matchProfiles(previousOverlap_.ptr<int>(0), currentOverlap_.ptr<int>(0),
+                               width, kMaxGlobalShift, errorX);
+
+        int overlapLeft = std::max(0, shift.dx);
+        int overlapRight = std::min(width, width + shift.dx);
+        cv::reduce(gray_.colRange(overlapLeft, overlapRight), currentOverlap_, 1, cv::REDUCE_SUM, CV_32S);
+        cv::reduce(previousGray_.colRange(overlapLeft - shift.dx, overlapRight - shift.dx), previousOverlap_,
+                   1, cv::REDUCE_SUM, CV_32S);
+        double errorY;
+        int dy = matchProfiles(previousOverlap_.ptr<int>(0), currentOverlap_.ptr<int>(0),
+                               height, kMaxGlobalShift, errorY);
+
+        shift.dx = dx;
+        shift.dy = dy;
+        shift.error = std::max(errorX / (overlapBottom - overlapTop), errorY / (overlapRight - overlapLeft));
+        shift.valid = shift.error <= kMaxProfileError;
+        return shift;
+    }
+
+    bool MotionCompensator::recomputeRegion(const cv::Mat& frame, const cv::Rect& region,
+                                            const DetectorParameters& params, cv::Mat& edges) {
+        // Same context a band gets, clipped to the frame
+        int halo = tileHaloRows(params.blurKernel);
+        cv::Rect context(region.x - halo, region.y - halo, region.width + 2 * halo, region.height + 2 * halo);
+        context &= cv::Rect(0, 0, frame.cols, frame.rows);
+
+        if (!applyCanny(frame(context), regionEdges_, params.lowThreshold, params.highThreshold,
+                        params.blurKernel, workspace_)) {
+            return false;
+        }
+        edges = regionEdges_(cv::Rect(region.x - context.x, region.y - context.y, region.width, region.height));
+        return true;
+    }
+
+    bool MotionCompensator::verify(const cv::Mat& frame, const cv::Rect& reused, const DetectorParameters& params) {
+        int columns = reused.width / kVerifyTileSize;
+        int rows = reused.height / kVerifyTileSize;
+        int tiles = columns * rows;
+        if (tiles == 0) {
+            return false;
+        }
+
+        // Tiles spread over the reused area, moving on by one grid cell every frame
+        int64_t differing = 0;
+        int64_t edgePixels = 0;
+        verifyCursor_++;
+        for (int i = 0; i < kVerifyTiles; i++) {
+            int index = static_cast<int>((verifyCursor_ + static_cast<uint32_t>(i) * tiles / kVerifyTiles) % tiles);
+            cv::Rect tile(reused.x + (index % columns) * kVerifyTileSize,
+                          reused.y + (index / columns) * kVerifyTileSize,
+                          kVerifyTileSize, kVerifyTileSize);
+
+            cv::Mat fresh;
+            if (!recomputeRegion(frame, tile, params, fresh)) {
+                return false;
+            }
+            for (int y = 0; y < tile.height; y++) {
+                const uchar* expected = fresh.ptr<uchar>(y);
+                const uchar* shifted = edges_.ptr<uchar>(tile.y + y) + tile.x;
+                for (int x = 0; x < tile.width; x++) {
+                    differing += expected[x] != shifted[x];
+                    edgePixels += (expected[x] != 0) + (shifted[x] != 0);
+                }
+            }
+
+            // The recomputed tile is exact, so keep it either way
+            copyInto(fresh, edges_, tile.tl());
+        }
+
+        // Relative to the edges sampled, not the area, so sparse scenes are not waved through
+        return differing <= kMaxVerifyMismatch * std::max<int64_t>(edgePixels, kVerifyTileSize);
+    }
+
+    bool MotionCompensator::reuse(const uint8_t* rgba, int width, int height, const DetectorParameters& params,
+                                  uint8_t* outputData, StatsRecorder* stats) {
+        TRACE_SCOPE("motion.reuse");
+        lastShift_ = GlobalShift();
+        pendingWidth_ = 0;
+        if (!rgba || !outputData || width <= 0 || height <= 0) {
+            return false;
+        }
+
+        try {
+            cv::Mat frame(height, width, CV_8UC4, const_cast<uint8_t*>(rgba));
+            {
+                ScopedStageTimer timer(stats, ProcessingStage::Motion);
+                computeProfiles(frame);
+                pendingWidth_ = width;
+                pendingHeight_ = height;
+                pendingVersion_ = params.version;
+
+                if (width != width_ || height != height_ || params.version != version_ ||
+                    reusedRun_ >= kReuseRefreshFrames) {
+                    return false;
+                }
+                lastShift_ = estimateShift();
+            }
+            if (!lastShift_.valid) {
+                return false;
+            }
+
+            // Newly exposed strips plus a halo along every border: edges there saw
+            // the old frame's border, or will see the new one from closer
+            int dx = lastShift_.dx;
+            int dy = lastShift_.dy;
+            int margin = tileHaloRows(params.blurKernel);
+            int left = std::min(width, std::max(dx, 0) + margin);
+            int right = std::max(left, width - std::max(-dx, 0) - margin);
+            int top = std::min(height, std::max(dy, 0) + margin);
+            int bottom = std::max(top, height - std::max(-dy, 0) - margin);
+            cv::Rect reused(left, top, right - left, bottom - top);
+            if (reused.area() * 2 < width * height) {
+                // Mostly new content; a full pass is as cheap
+                return false;
+            }
+
+            // Shift the previous edge map; everything outside the overlap lies in a strip
+            edges_.create(height, width, CV_8UC1);
+            cv::Rect overlap(std::max(0, dx), std::max(0, dy), width - std::abs(dx), height - std::abs(dy));
+            for (int y = overlap.y; y < overlap.y + overlap.height; y++) {
+                std::memcpy(edges_.ptr<uchar>(y) + overlap.x, previousEdges_.ptr<uchar>(y - dy) + overlap.x - dx,
+                            overlap.width);
+            }
+
+            workspace_.stats = stats;
+            const cv::Rect strips[4] = {
+                    cv::Rect(0, 0, left, height),
+                    cv::Rect(right, 0, width - right, height),
+                    cv::Rect(left, 0, right - left, top),
+                    cv::Rect(left, bottom, right - left, height - bottom),
+            };
+            for (const cv::Rect& strip : strips) {
+                cv::Mat stripEdges;
+                if (strip.area() == 0) {
+                    continue;
+                }
+                if (!recomputeRegion(frame, strip, params, stripEdges)) {
+                    return false;
+                }
+                copyInto(stripEdges, edges_, strip.tl());
+            }
+
+            if (!verify(frame, reused, params)) {
+                LOGD("Shift (%d, %d) failed verification, processing in full", dx, dy);
+                return false;
+            }
+
+            {
+                ScopedStageTimer timer(stats, ProcessingStage::Rgba);
+                cv::Mat outputMat(height, width, CV_8UC4, outputData);
+                if (!edgeToRGBA(edges_, outputMat)) {
+                    return false;
+                }
+            }
+
+            // This frame becomes the one the next is shifted from
+            std::swap(edges_, previousEdges_);
+            std::swap(gray_, previousGray_);
+            std::swap(rowProfile_, previousRowProfile_);
+            std::swap(columnProfile_, previousColumnProfile_);
+            pendingWidth_ = 0;
+            reusedRun_++;
+            return true;
+
+        } catch (const cv::Exception& e) {
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in motion compensation: %s", e.what());
+            pendingWidth_ = 0;
+            return false;
+        }
+    }
+
+    void MotionCompensator::update(const uint8_t* outputData) {
+        if (!outputData || pendingWidth_ == 0) {
+            reset();
+            return;
+        }
+
+        try {
+            // Edges are replicated into every output channel
+            cv::Mat outputMat(pendingHeight_, pendingWidth_, CV_8UC4, const_cast<uint8_t*>(outputData));
+            cv::extractChannel(outputMat, previousEdges_, 0);
+        } catch (const cv::Exception& e) {
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception keeping edges for reuse: %s", e.what());
+            reset();
+            return;
+        }
+
+        std::swap(gray_, previousGray_);
+        std::swap(rowProfile_, previousRowProfile_);
+        std::swap(columnProfile_, previousColumnProfile_);
+        width_ = pendingWidth_;
+        height_ = pendingHeight_;
+        version_ = pendingVersion_;
+        pendingWidth_ = 0;
+        reusedRun_ = 0;
+    }
+
+    void MotionCompensator::reset() {
+        width_ = 0;
+        height_ = 0;
+        pendingWidth_ = 0;
+        reusedRun_ = 0;
+    }
+
+} // namespace EdgeDetection
@@ -0,0 +1,131 @@
+#ifndef MOTION_COMPENSATOR_H
+#define MOTION_COMPENSATOR_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+
+#include "image_processor.h"
+#include "parameter_store.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Largest global shift per frame, in pixels along each axis, that is searched for
+ */
+    constexpr int kMaxGlobalShift = 32;
+
+/**
+ * @brief Consecutive frames built from a shifted edge map before a full pass is forced
+ */
+    constexpr int kReuseRefreshFrames = 8;
+
+/**
+ * @brief Verification tiles recomputed and compared on every reused frame, and their size
+ */
+    constexpr int kVerifyTiles = 4;
+    constexpr int kVerifyTileSize = 64;
+
+/**
+ * @brief Global translation between two frames found by projection-profile matching
+ */
+    struct GlobalShift {
+        int dx = 0;             // Content moved right by dx pixels
+        int dy = 0;             // Content moved down by dy pixels
+        double error = 0.0;     // Mean absolute profile difference at the shift, per summed pixel
+        bool valid = false;     // Profiles matched well enough to trust the shift
+    };
+
+/**
+ * @brief Builds frames of a panning camera from the previous edge map shifted by the global motion
+ *
+ * Every frame is reduced to its luma row and column projection profiles
+ * (sums along each axis). The translation between two frames is the shift
+ * that minimizes the mean absolute difference of their overlapping profiles,
+ * refined once per axis over the rows (columns) both frames share. The
+ * output is the previous edge map moved by that shift, with only the newly
+ * exposed strips and a halo along every border recomputed, plus
+ * kVerifyTiles sample tiles of the reused area that rotate from frame to
+ * frame. When the sampled tiles disagree with the shifted edges (rotation,
+ * zoom, moving objects or sub-pixel drift), the frame falls back to full
+ * processing. A full pass also runs after every kReuseRefreshFrames reused
+ * frames, so errors outside the sampled tiles cannot pile up.
+ * Enabling is safe from any thread; the rest belongs to the processing thread.
+ */
+    class MotionCompensator {
+    public:
+        MotionCompensator();
+
+        MotionCompensator(const MotionCompensator&) = delete;
+        MotionCompensator& operator=(const MotionCompensator&) = delete;
+
+        void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Try to build the frame's output from the previous edge map
+         *
+         * Always records the frame's profiles, so update() can follow a full pass.
+         * @param rgba Frame data (RGBA format)
+         * @param width Frame width in pixels
+         * @param height Frame height in pixels
+         * @param params Parameters the frame is processed with
+         * @param outputData Output frame (RGBA format); only written on success
+         * @param stats Receives stage timings of the recomputed regions, may be null
+         * @return true if the output was built by reuse, false if the frame needs full processing
+         */
+        bool reuse(const uint8_t* rgba, int width, int height, const DetectorParameters& params,
+                   uint8_t* outputData, StatsRecorder* stats);
+
+        /**
+         * @brief Remember a fully processed frame's output as the edge map to shift next
+         * @param outputData Output of the frame last passed to reuse() (RGBA format)
+         */
+        void update(const uint8_t* outputData);
+
+        /**
+         * @brief Forget the previous frame, so the next one is processed in full
+         */
+        void reset();
+
+        /**
+         * @brief Shift estimated for the last frame
+         */
+        const GlobalShift& lastShift() const { return lastShift_; }
+
+    private:
+        void computeProfiles(const cv::Mat& frame);
+        GlobalShift estimateShift();
+        bool recomputeRegion(const cv::Mat& frame, const cv::Rect& region, const DetectorParameters& params,
+                             cv::Mat& edges);
+        bool verify(const cv::Mat& frame, const cv::Rect& reused, const DetectorParameters& params);
+
+        std::atomic<bool> enabled_;
+
+        cv::Mat gray_;                  // Current frame's luma
+        cv::Mat rowProfile_;            // ... CV_32S: one sum per row
+        cv::Mat columnProfile_;         // ... one sum per column
+        cv::Mat previousGray_;
+        cv::Mat previousRowProfile_;
+        cv::Mat previousColumnProfile_;
+        cv::Mat currentOverlap_;        // Profiles over the rows (columns) two frames share
+        cv::Mat previousOverlap_;
+        cv::Mat edges_;                 // Edge map being built
+        cv::Mat previousEdges_;         // Edge map of the previous frame
+        cv::Mat regionEdges_;
+        Workspace workspace_;
+
+        int width_;                     // Size and parameters of the previous frame; 0 = none
+        int height_;
+        uint64_t version_;
+        int pendingWidth_;              // ... of the frame whose profiles are current
+        int pendingHeight_;
+        uint64_t pendingVersion_;
+        int reusedRun_;                 // Consecutive reused frames
+        uint32_t verifyCursor_;
+        GlobalShift lastShift_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // MOTION_COMPENSATOR_H
@@ -0,0 +1,94 @@
+//
+// Frame-level motion gate on a downsampled luma thumbnail
+//
+#include "motion_gate.h"
+#include "log.h"
+#include <algorithm>
+#include <utility>
+
+#define LOG_TAG "MotionGate"
+
+namespace EdgeDetection {
+
+    MotionGate::MotionGate()
+            : enabled_(false),
+              threshold_(kDefaultMotionThreshold),
+              frameWidth_(0),
+              frameHeight_(0),
+              frameVersion_(0),
+              referenceWidth_(0),
+              referenceHeight_(0),
+              referenceVersion_(0),
+              hasReference_(false),
+              lastDifference_(-1.0) {
+    }
+
+    void MotionGate::configure(bool enabled, double threshold) {
+        threshold_.store(std::max(threshold, 0.0), std::memory_order_relaxed);
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool MotionGate::isStatic(const uint8_t* rgba, int width, int height, uint64_t parametersVersion) {
+        lastDifference_ = -1.0;
+        frameWidth_ = 0;
+        frameHeight_ = 0;
+        if (!rgba || width <= 0 || height <= 0) {
+            return false;
+        }
+
+        try {
+            // Whole blocks only: an integer scale takes OpenCV's vectorized area-averaging path,
+            // and the few rows and columns left over cannot hide motion on their own
+            int thumbnailWidth = std::max(1, width / kMotionGateScale);
+            int thumbnailHeight = std::max(1, height / kMotionGateScale);
+            int blockWidth = std::min(width, thumbnailWidth * kMotionGateScale);
+            int blockHeight = std::min(height, thumbnailHeight * kMotionGateScale);
+
+            cv::Mat frame(height, width, CV_8UC4, const_cast<uint8_t*>(rgba));
+            cv::resize(frame(cv::Rect(0, 0, blockWidth, blockHeight)), thumbnailRgba_,
+                       cv::Size(thumbnailWidth, thumbnailHeight), 0, 0, cv::INTER_AREA);
+            cv::cvtColor(thumbnailRgba_, thumbnail_, cv::COLOR_RGBA2GRAY);
+            frameWidth_ = width;
+            frameHeight_ = height;
+            frameVersion_ = parametersVersion;
+
+            if (!hasReference_ || width != referenceWidth_ || height != referenceHeight_ ||
+                parametersVersion != referenceVersion_) {
+                return false;
+            }
+
+            // Vectorized maximum of absolute differences over the thumbnail
+            lastDifference_ = cv::norm(thumbnail_, reference_, cv::NORM_INF);
+            return lastDifference_ < threshold_.load(std::memory_order_relaxed);
+
+        } catch (const cv::Exception& e) {
+            LOGE_EVERY_MS(kFrameLogIntervalMs, "OpenCV exception in motion gate: %s", e.what());
+            frameWidth_ = 0;
+            return false;
+        }
+    }
+
+    void MotionGate::accept() {
+        if (frameWidth_ == 0) {
+            hasReference_ = false;
+            return;
+        }
+
+        // Swap rather than copy; the old reference's buffer takes the next thumbnail
+        std::swap(thumbnail_, reference_);
+        referenceWidth_ = frameWidth_;
+        referenceHeight_ = frameHeight_;
+        referenceVersion_ = frameVersion_;
+        hasReference_ = true;
+        frameWidth_ = 0;
+        frameHeight_ = 0;
+    }
+
+    void MotionGate::reset() {
+        hasReference_ = false;
+        frameWidth_ = 0;
+        frameHeight_ = 0;
+        lastDifference_ = -1.0;
+    }
+
+} // namespace EdgeDetection
@@ -0,0 +1,99 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Frame pixels averaged into one thumbnail pixel per axis
+ */
+    constexpr int kMotionGateScale = 16;
+
+/**
+ * @brief Default luma change of a thumbnail pixel (0-255) below which a frame counts as static
+ *
+ * Averaging 256 pixels leaves well under one level of sensor noise, while a
+ * 4x4 pixel object changing by 100 levels still moves its block by 6.
+ */
+    constexpr double kDefaultMotionThreshold = 4.0;
+
+/**
+ * @brief Frame-level motion detector deciding whether a frame needs processing at all
+ *
+ * Each frame is reduced to a luma thumbnail at 1/kMotionGateScale of its
+ * size by block averaging, which also averages away most sensor noise, and
+ * compared with the thumbnail of the last frame that was actually processed.
+ * The frame is static when no thumbnail pixel changed by the threshold or
+ * more; a mean over the thumbnail would let a small moving object hide in a
+ * large idle frame. Comparing against the last processed frame
+ * rather than the previous one means a slow drift still triggers processing
+ * once it adds up. A change of frame size or detector parameters never counts
+ * as static. Configuration is safe from any thread; the rest belongs to the
+ * processing thread.
+ */
+    class MotionGate {
+    public:
+        MotionGate();
+
+        MotionGate(const MotionGate&) = delete;
+        MotionGate& operator=(const MotionGate&) = delete;
+
+        /**
+         * @brief Turn the gate on or off and set its threshold; applies from the next frame
+         * @param enabled Whether static frames may be skipped
+         * @param threshold Luma change of a thumbnail pixel below which a frame is static
+         */
+        void configure(bool enabled, double threshold);
+
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Whether the frame matches the last processed one closely enough to skip it
+         *
+         * Keeps the frame's thumbnail so that accept() can make it the new reference.
+         * @param rgba Frame data (RGBA format)
+         * @param width Frame width in pixels
+         * @param height Frame height in pixels
+         * @param parametersVersion Version of the parameters the frame would be processed with
+         * @return true if the frame can be skipped
+         */
+        bool isStatic(const uint8_t* rgba, int width, int height, uint64_t parametersVersion);
+
+        /**
+         * @brief Make the frame last passed to isStatic() the reference; call once it was processed
+         */
+        void accept();
+
+        /**
+         * @brief Forget the reference, so the next frame is always processed
+         */
+        void reset();
+
+        /**
+         * @brief Largest thumbnail luma change measured for the last frame, -1 if not compared
+         */
+        double lastDifference() const { return lastDifference_; }
+
+    private:
+        std::atomic<bool> enabled_;
+        std::atomic<double> threshold_;
+
+        cv::Mat thumbnailRgba_;     // Block averages of the frame
+        cv::Mat thumbnail_;         // ... as luma
+        cv::Mat reference_;         // Luma thumbnail of the last processed frame
+        int frameWidth_;            // Frame size and parameters of the last thumbnail
+        int frameHeight_;
+        uint64_t frameVersion_;
+        int referenceWidth_;        // Frame size and parameters the reference was processed with
+        int referenceHeight_;
+        uint64_t referenceVersion_;
+        bool hasReference_;
+        double lastDifference_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // MOTION_GATE_H
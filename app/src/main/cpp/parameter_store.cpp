@@ -0,0 +1,99 @@
+//
+// Lock-free parameter snapshots for live tuning
+//
+#include "parameter_store.h"
+#include "log.h"
+#include <algorithm>
+#include <utility>
+
+#define LOG_TAG "ParameterStore"
+
+namespace EdgeDetection {
+
+    static DetectorParameters sanitize(const DetectorParameters& requested) {
+        DetectorParameters parameters = requested;
+        parameters.lowThreshold = std::max(0.0, parameters.lowThreshold);
+        parameters.highThreshold = std::max(0.0, parameters.highThreshold);
+        if (parameters.lowThreshold > parameters.highThreshold) {
+            std::swap(parameters.lowThreshold, parameters.highThreshold);
+        }
+
+        int kernel = std::min(std::max(parameters.blurKernel, 1), ParameterStore::kMaxBlurKernel);
+        if (kernel % 2 == 0) {
+            kernel++;
+        }
+        parameters.blurKernel = kernel;
+
+        if (parameters.lowThreshold != requested.lowThreshold ||
+            parameters.highThreshold != requested.highThreshold ||
+            parameters.blurKernel != requested.blurKernel) {
+            LOGW("Adjusted parameters (%.1f, %.1f, %d) to (%.1f, %.1f, %d)",
+                 requested.lowThreshold, requested.highThreshold, requested.blurKernel,
+                 parameters.lowThreshold, parameters.highThreshold, parameters.blurKernel);
+        }
+        return parameters;
+    }
+
+    ParameterStore::ParameterStore(const DetectorParameters& initial)
+            : current_(nullptr), nextSlot_(1), lastVersion_(1) {
+        DetectorParameters parameters = sanitize(initial);
+        parameters.version = lastVersion_;
+        store(slots_[0], parameters);
+        current_.store(&slots_[0], std::memory_order_release);
+    }
+
+    void ParameterStore::store(Slot& slot, const DetectorParameters& parameters) {
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.lowThreshold.store(parameters.lowThreshold, std::memory_order_relaxed);
+        slot.highThreshold.store(parameters.highThreshold, std::memory_order_relaxed);
+        slot.blurKernel.store(parameters.blurKernel, std::memory_order_relaxed);
+        slot.version.store(parameters.version, std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    DetectorParameters ParameterStore::publish(const DetectorParameters& requested) {
+        DetectorParameters parameters = sanitize(requested);
+
+        std::lock_guard<std::mutex> lock(publishMutex_);
+        DetectorParameters current = snapshot();
+        if (current.lowThreshold == parameters.lowThreshold &&
+            current.highThreshold == parameters.highThreshold &&
+            current.blurKernel == parameters.blurKernel) {
+            return current;
+        }
+
+        parameters.version = ++lastVersion_;
+        Slot& slot = slots_[nextSlot_];
+        nextSlot_ = (nextSlot_ + 1) % kSlotCount;
+
+        store(slot, parameters);
+        current_.store(&slot, std::memory_order_release);
+        return parameters;
+    }
+
+    DetectorParameters ParameterStore::snapshot() const {
+        DetectorParameters parameters;
+        for (;;) {
+            const Slot* slot = current_.load(std::memory_order_acquire);
+            uint64_t before = slot->sequence.load(std::memory_order_acquire);
+            parameters.lowThreshold = slot->lowThreshold.load(std::memory_order_relaxed);
+            parameters.highThreshold = slot->highThreshold.load(std::memory_order_relaxed);
+            parameters.blurKernel = slot->blurKernel.load(std::memory_order_relaxed);
+            parameters.version = slot->version.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = slot->sequence.load(std::memory_order_relaxed);
+
+            if (before == after && (before & 1) == 0) {
+                return parameters;
+            }
+        }
+    }
+
+    uint64_t ParameterStore::version() const {
+        // Through the validated copy: a recycled slot may already hold a version not yet current
+        return snapshot().version;
+    }
+
+} // namespace EdgeDetection
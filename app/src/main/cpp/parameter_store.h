@@ -0,0 +1,87 @@
+#ifndef PARAMETER_STORE_H
+#define PARAMETER_STORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Tunable edge detection parameters
+ */
+    struct DetectorParameters {
+        double lowThreshold = 50.0;     // Lower Canny threshold
+        double highThreshold = 150.0;   // Upper Canny threshold
+        int blurKernel = 3;             // Gaussian blur kernel size (odd)
+
+        // Assigned by ParameterStore::publish; equal versions mean equal parameters,
+        // so caches of parameter-dependent results can key on it. Ignored on input.
+        uint64_t version = 0;
+    };
+
+/**
+ * @brief Single-writer, many-reader parameter snapshots (RCU style)
+ *
+ * The UI thread publishes a complete parameter set into a spare slot and
+ * swaps the current-slot pointer; frame loops copy the current set once at
+ * the start of each frame. Readers take no lock and never wait for the
+ * writer. Slots are recycled round-robin instead of being freed, and each
+ * carries a sequence count, so a reader that was preempted across several
+ * publishes notices the reused slot and simply rereads the newest one.
+ */
+    class ParameterStore {
+    public:
+        explicit ParameterStore(const DetectorParameters& initial = DetectorParameters());
+
+        ParameterStore(const ParameterStore&) = delete;
+        ParameterStore& operator=(const ParameterStore&) = delete;
+
+        /**
+         * @brief Make a parameter set current; applies from the next snapshot()
+         *
+         * Values are sanitized first (non-negative thresholds with low <= high,
+         * odd blur kernel in [1, kMaxBlurKernel]). Publishing a set equal to the
+         * current one keeps its version. Writers are serialized; readers are
+         * never blocked.
+         * @return The sanitized parameters, with their version
+         */
+        DetectorParameters publish(const DetectorParameters& parameters);
+
+        /**
+         * @brief Consistent copy of the current parameters (lock-free)
+         */
+        DetectorParameters snapshot() const;
+
+        /**
+         * @brief Version of the current parameters, without copying them
+         */
+        uint64_t version() const;
+
+        static constexpr int kMaxBlurKernel = 31;
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence{0};     // Odd while the writer refills the slot
+            std::atomic<double> lowThreshold{0.0};
+            std::atomic<double> highThreshold{0.0};
+            std::atomic<int> blurKernel{0};
+            std::atomic<uint64_t> version{0};
+        };
+
+        // Readers only retry if the writer laps all slots during one copy
+        static const int kSlotCount = 4;
+
+        void store(Slot& slot, const DetectorParameters& parameters);
+
+        Slot slots_[kSlotCount];
+        std::atomic<Slot*> current_;
+
+        std::mutex publishMutex_;
+        int nextSlot_;              // Guarded by publishMutex_
+        uint64_t lastVersion_;      // Guarded by publishMutex_
+    };
+
+} // namespace EdgeDetection
+
+#endif // PARAMETER_STORE_H
@@ -0,0 +1,240 @@
+//
+// Lock-free pipeline statistics and latency histogram
+//
+#include "processing_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace EdgeDetection {
+
+    // Frames per frame-rate sample
+    static const int kFpsWindow = 30;
+
+    const char* processingStageName(ProcessingStage stage) {
+        switch (stage) {
+            case ProcessingStage::Gray:  return "gray";
+            case ProcessingStage::Blur:  return "blur";
+            case ProcessingStage::Canny: return "canny";
+            case ProcessingStage::Rgba:  return "rgba";
+            case ProcessingStage::Copy:  return "copy";
+            case ProcessingStage::Gate:  return "gate";
+            case ProcessingStage::Motion: return "motion";
+        }
+        return "unknown";
+    }
+
+    LatencyHistogram::LatencyHistogram() : count_(0), max_(0) {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    int LatencyHistogram::bucketIndex(uint64_t value) {
+        const uint64_t linearLimit = uint64_t(1) << kSubBucketBits;
+        value = std::min<uint64_t>(value, (uint64_t(1) << kMaxValueBits) - 1);
+        if (value < linearLimit) {
+            return static_cast<int>(value);
+        }
+
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - (kSubBucketBits - 1);
+        uint64_t mantissa = value >> shift;   // In [2^(kSubBucketBits-1), 2^kSubBucketBits)
+        return (shift << (kSubBucketBits - 1)) + static_cast<int>(mantissa);
+    }
+
+    uint64_t LatencyHistogram::bucketMidpoint(int index) {
+        const int halfRange = 1 << (kSubBucketBits - 1);
+        if (index < (1 << kSubBucketBits)) {
+            return static_cast<uint64_t>(index);
+        }
+
+        int shift = index / halfRange - 1;
+        uint64_t mantissa = static_cast<uint64_t>(index - shift * halfRange);
+        uint64_t low = mantissa << shift;
+        return low + ((uint64_t(1) << shift) >> 1);
+    }
+
+    void LatencyHistogram::record(int64_t valueNs) {
+        uint64_t value = valueNs > 0 ? static_cast<uint64_t>(valueNs) : 0;
+        buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        atomicMax(max_, static_cast<int64_t>(value));
+    }
+
+    int64_t LatencyHistogram::percentileNs(double fraction) const {
+        // Sum the buckets rather than trusting count_, which may be mid-update
+        uint64_t total = 0;
+        for (const auto& bucket : buckets_) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0;
+        }
+
+        fraction = std::min(1.0, std::max(0.0, fraction));
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total)));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBucketCount; i++) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                // Never report more than the exact maximum
+                return std::min(static_cast<int64_t>(bucketMidpoint(i)), maxNs());
+            }
+        }
+        return maxNs();
+    }
+
+    void LatencyHistogram::reset() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    StatsRecorder::StatsRecorder()
+            : framesProcessed_(0),
+              framesDropped_(0),
+              framesSkipped_(0),
+              framesReused_(0),
+              framesPresented_(0),
+              queueTotalNs_(0),
+              processTotalNs_(0),
+              uploadTotalNs_(0),
+              presentTotalNs_(0),
+              bytesProcessed_(0),
+              lastFrameNs_(0),
+              lastBandCount_(0),
+              fpsWindowStartNs_(nowNs()),
+              averageFps_(0.0),
+              lowThreshold_(0.0),
+              highThreshold_(0.0),
+              blurKernel_(0) {
+    }
+
+    int64_t StatsRecorder::nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void StatsRecorder::recordStage(ProcessingStage stage, int64_t durationNs) {
+        StageCounters& counters = stages_[static_cast<int>(stage)];
+        counters.calls.fetch_add(1, std::memory_order_relaxed);
+        counters.totalNs.fetch_add(static_cast<uint64_t>(std::max<int64_t>(durationNs, 0)),
+                                   std::memory_order_relaxed);
+        atomicMax(counters.maxNs, durationNs);
+    }
+
+    int StatsRecorder::recordFrame(int64_t latencyNs, uint64_t bytes, int bands) {
+        frameLatency_.record(latencyNs);
+        lastFrameNs_.store(latencyNs, std::memory_order_relaxed);
+        lastBandCount_.store(bands, std::memory_order_relaxed);
+        bytesProcessed_.fetch_add(bytes, std::memory_order_relaxed);
+
+        int frames = framesProcessed_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (frames % kFpsWindow == 0) {
+            int64_t now = nowNs();
+            int64_t windowStart = fpsWindowStartNs_.exchange(now, std::memory_order_relaxed);
+            double seconds = (now - windowStart) / 1e9;
+            averageFps_.store(seconds > 0.0 ? kFpsWindow / seconds : 0.0, std::memory_order_relaxed);
+        }
+        return frames;
+    }
+
+    void StatsRecorder::recordDropped(int frames) {
+        framesDropped_.fetch_add(frames, std::memory_order_relaxed);
+    }
+
+    void StatsRecorder::recordSkipped() {
+        framesSkipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void StatsRecorder::recordReused() {
+        framesReused_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void StatsRecorder::recordPresented(const FrameTimes& times) {
+        // The last band may be uploaded a moment before the frame is closed
+        auto segment = [](int64_t from, int64_t to) {
+            return static_cast<uint64_t>(std::max<int64_t>(to - from, 0));
+        };
+        endToEndLatency_.record(times.presentNs - times.captureNs);
+        queueTotalNs_.fetch_add(segment(times.captureNs, times.processStartNs), std::memory_order_relaxed);
+        processTotalNs_.fetch_add(segment(times.processStartNs, times.processEndNs), std::memory_order_relaxed);
+        uploadTotalNs_.fetch_add(segment(times.processEndNs, times.uploadNs), std::memory_order_relaxed);
+        presentTotalNs_.fetch_add(segment(times.uploadNs, times.presentNs), std::memory_order_relaxed);
+        framesPresented_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void StatsRecorder::setParameters(double lowThreshold, double highThreshold, int blurKernel) {
+        lowThreshold_.store(lowThreshold, std::memory_order_relaxed);
+        highThreshold_.store(highThreshold, std::memory_order_relaxed);
+        blurKernel_.store(blurKernel, std::memory_order_relaxed);
+    }
+
+    ProcessingStats StatsRecorder::snapshot() const {
+        ProcessingStats stats = {};
+        stats.framesProcessed = framesProcessed_.load(std::memory_order_relaxed);
+        stats.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+        stats.framesSkipped = framesSkipped_.load(std::memory_order_relaxed);
+        stats.framesReused = framesReused_.load(std::memory_order_relaxed);
+        stats.averageFps = averageFps_.load(std::memory_order_relaxed);
+        stats.processingTime = lastFrameNs_.load(std::memory_order_relaxed) / 1e6;
+        stats.bandsPerFrame = lastBandCount_.load(std::memory_order_relaxed);
+        stats.bytesProcessed = bytesProcessed_.load(std::memory_order_relaxed);
+
+        stats.latencyP50Ms = frameLatency_.percentileNs(0.50) / 1e6;
+        stats.latencyP90Ms = frameLatency_.percentileNs(0.90) / 1e6;
+        stats.latencyP99Ms = frameLatency_.percentileNs(0.99) / 1e6;
+        stats.latencyMaxMs = frameLatency_.maxNs() / 1e6;
+
+        int presented = framesPresented_.load(std::memory_order_relaxed);
+        stats.framesPresented = presented;
+        stats.endToEndP50Ms = endToEndLatency_.percentileNs(0.50) / 1e6;
+        stats.endToEndP99Ms = endToEndLatency_.percentileNs(0.99) / 1e6;
+        if (presented > 0) {
+            stats.queueDelayMs = queueTotalNs_.load(std::memory_order_relaxed) / 1e6 / presented;
+            stats.processDelayMs = processTotalNs_.load(std::memory_order_relaxed) / 1e6 / presented;
+            stats.uploadDelayMs = uploadTotalNs_.load(std::memory_order_relaxed) / 1e6 / presented;
+            stats.presentDelayMs = presentTotalNs_.load(std::memory_order_relaxed) / 1e6 / presented;
+        }
+
+        for (int i = 0; i < kProcessingStageCount; i++) {
+            uint64_t calls = stages_[i].calls.load(std::memory_order_relaxed);
+            uint64_t totalNs = stages_[i].totalNs.load(std::memory_order_relaxed);
+            stats.stageAverageMs[i] = calls > 0 ? totalNs / 1e6 / calls : 0.0;
+            stats.stageMaxMs[i] = stages_[i].maxNs.load(std::memory_order_relaxed) / 1e6;
+        }
+
+        stats.currentThreshold1 = static_cast<int>(lowThreshold_.load(std::memory_order_relaxed));
+        stats.currentThreshold2 = static_cast<int>(highThreshold_.load(std::memory_order_relaxed));
+        stats.blurKernel = blurKernel_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void StatsRecorder::reset() {
+        frameLatency_.reset();
+        endToEndLatency_.reset();
+        for (auto& counters : stages_) {
+            counters.calls.store(0, std::memory_order_relaxed);
+            counters.totalNs.store(0, std::memory_order_relaxed);
+            counters.maxNs.store(0, std::memory_order_relaxed);
+        }
+        framesProcessed_.store(0, std::memory_order_relaxed);
+        framesDropped_.store(0, std::memory_order_relaxed);
+        framesSkipped_.store(0, std::memory_order_relaxed);
+        framesReused_.store(0, std::memory_order_relaxed);
+        framesPresented_.store(0, std::memory_order_relaxed);
+        queueTotalNs_.store(0, std::memory_order_relaxed);
+        processTotalNs_.store(0, std::memory_order_relaxed);
+        uploadTotalNs_.store(0, std::memory_order_relaxed);
+        presentTotalNs_.store(0, std::memory_order_relaxed);
+        bytesProcessed_.store(0, std::memory_order_relaxed);
+        lastFrameNs_.store(0, std::memory_order_relaxed);
+        lastBandCount_.store(0, std::memory_order_relaxed);
+        averageFps_.store(0.0, std::memory_order_relaxed);
+        fpsWindowStartNs_.store(nowNs(), std::memory_order_relaxed);
+    }
+
+} // namespace EdgeDetection
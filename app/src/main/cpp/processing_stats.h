@@ -0,0 +1,188 @@
+#ifndef PROCESSING_STATS_H
+#define PROCESSING_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "image_processor.h"
+#include "progressive_frame.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Log-linear (HDR-style) latency histogram with lock-free recording
+ *
+ * Buckets are linear below 2^kSubBucketBits ns and split every further power
+ * of two into 2^(kSubBucketBits-1) equal sub-buckets, so any recorded value
+ * is reported within ~3% regardless of magnitude (1 µs or 10 s). Recording is
+ * a single relaxed fetch_add plus a max update; percentiles are computed only
+ * when a snapshot is taken.
+ */
+    class LatencyHistogram {
+    public:
+        LatencyHistogram();
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+        void record(int64_t valueNs);
+
+        /**
+         * @brief Value at or below which the given fraction of samples fall
+         * @param fraction Quantile in [0, 1], e.g. 0.99
+         * @return Latency in nanoseconds (bucket midpoint), 0 if empty
+         */
+        int64_t percentileNs(double fraction) const;
+
+        int64_t maxNs() const { return max_.load(std::memory_order_relaxed); }
+        uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+        void reset();
+
+    private:
+        static const int kSubBucketBits = 6;
+        static const int kMaxValueBits = 40;    // ~18 minutes in ns; larger values are clamped
+        static const int kBucketCount = (kMaxValueBits - kSubBucketBits + 2) << (kSubBucketBits - 1);
+
+        static int bucketIndex(uint64_t value);
+        static uint64_t bucketMidpoint(int index);
+
+        std::atomic<uint64_t> buckets_[kBucketCount];
+        std::atomic<uint64_t> count_;
+        std::atomic<int64_t> max_;
+    };
+
+/**
+ * @brief Lock-free statistics of one pipeline (detector or stream)
+ *
+ * Hot-path updates (stage timings from any worker, frame completions, drops)
+ * are relaxed atomic operations; snapshot() assembles a ProcessingStats for
+ * the UI without stopping the pipeline. A snapshot taken during a frame may
+ * mix that frame's counters with the previous one's, which is fine for
+ * monitoring. reset() is likewise approximate while frames are in flight.
+ */
+    class StatsRecorder {
+    public:
+        StatsRecorder();
+
+        StatsRecorder(const StatsRecorder&) = delete;
+        StatsRecorder& operator=(const StatsRecorder&) = delete;
+
+        /**
+         * @brief Add the time one call of a stage took (any thread)
+         */
+        void recordStage(ProcessingStage stage, int64_t durationNs);
+
+        /**
+         * @brief Account one finished frame
+         * @param latencyNs Processing time of the frame
+         * @param bytes Input bytes processed
+         * @param bands Row bands the frame was split into
+         * @return Frames processed so far, including this one
+         */
+        int recordFrame(int64_t latencyNs, uint64_t bytes, int bands);
+
+        void recordDropped(int frames = 1);
+
+        /**
+         * @brief Account one frame the motion gate let through unprocessed
+         */
+        void recordSkipped();
+
+        /**
+         * @brief Account one processed frame that was built from the shifted previous edge map
+         */
+        void recordReused();
+
+        /**
+         * @brief Account one frame shown on screen with its complete timeline (GL thread)
+         */
+        void recordPresented(const FrameTimes& times);
+
+        /**
+         * @brief Remember the parameters frames are currently processed with
+         */
+        void setParameters(double lowThreshold, double highThreshold, int blurKernel);
+
+        /**
+         * @brief Consistent-enough copy of all counters for display
+         */
+        ProcessingStats snapshot() const;
+
+        void reset();
+
+    private:
+        struct StageCounters {
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> totalNs{0};
+            std::atomic<int64_t> maxNs{0};
+        };
+
+        static int64_t nowNs();
+
+        LatencyHistogram frameLatency_;
+        LatencyHistogram endToEndLatency_;      // Capture to present of displayed frames
+        StageCounters stages_[kProcessingStageCount];
+
+        std::atomic<int> framesProcessed_;
+        std::atomic<int> framesDropped_;
+        std::atomic<int> framesSkipped_;
+        std::atomic<int> framesReused_;
+        std::atomic<int> framesPresented_;
+        std::atomic<uint64_t> queueTotalNs_;    // Timeline segments summed over presented frames
+        std::atomic<uint64_t> processTotalNs_;
+        std::atomic<uint64_t> uploadTotalNs_;
+        std::atomic<uint64_t> presentTotalNs_;
+        std::atomic<uint64_t> bytesProcessed_;
+        std::atomic<int64_t> lastFrameNs_;
+        std::atomic<int> lastBandCount_;
+
+        // Frame rate over the last kFpsWindow frames
+        std::atomic<int64_t> fpsWindowStartNs_;
+        std::atomic<double> averageFps_;
+
+        std::atomic<double> lowThreshold_;
+        std::atomic<double> highThreshold_;
+        std::atomic<int> blurKernel_;
+    };
+
+/**
+ * @brief Adds the lifetime of a scope to a stage's timing; free when stats is null
+ */
+    class ScopedStageTimer {
+    public:
+        ScopedStageTimer(StatsRecorder* stats, ProcessingStage stage)
+                : stats_(stats), stage_(stage),
+                  start_(stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+
+        ~ScopedStageTimer() {
+            if (stats_) {
+                stats_->recordStage(stage_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start_).count());
+            }
+        }
+
+        ScopedStageTimer(const ScopedStageTimer&) = delete;
+        ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+    private:
+        StatsRecorder* stats_;
+        ProcessingStage stage_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+/**
+ * @brief Atomically raise target to value if value is larger
+ */
+    inline void atomicMax(std::atomic<int64_t>& target, int64_t value) {
+        int64_t current = target.load(std::memory_order_relaxed);
+        while (value > current &&
+               !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+} // namespace EdgeDetection
+
+#endif // PROCESSING_STATS_H
@@ -0,0 +1,202 @@
+//
+// Band-by-band hand-off of processed frames to the GL thread
+//
+#include "progressive_frame.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace EdgeDetection {
+
+    ProgressiveFrame::ProgressiveFrame()
+            : nextGeneration_(1),
+              started_(0),
+              ended_(0),
+              lastFailed_(false),
+              repeats_(0),
+              pinnedBuffer_(-1),
+              consumerGeneration_(0),
+              allBandsMask_(0),
+              takenMask_(0),
+              consumerFailed_(false),
+              consumerRepeats_(0),
+              bandsTaken_(0),
+              bandsTakenEarly_(0),
+              consumerWaiting_(false),
+              events_(0) {
+        for (Buffer& buffer : buffers_) {
+            for (std::atomic<uint64_t>& fence : buffer.fences) {
+                fence.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void ProgressiveFrame::reserve(int width, int height) {
+        size_t bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+        for (Buffer& buffer : buffers_) {
+            // resize() zero-fills, which also takes the page faults now rather than on the first frames
+            buffer.data.resize(bytes);
+        }
+    }
+
+    int64_t ProgressiveFrame::nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint8_t* ProgressiveFrame::beginFrame(int width, int height, int bandCount, int64_t captureNs) {
+        uint64_t generation = nextGeneration_++;
+        int index = static_cast<int>(generation & 1);
+        Buffer& buffer = buffers_[index];
+
+        // Invalidate the buffer for new pins, then let an upload from it (two
+        // frames back) finish its band; uploads take far less than a frame
+        buffer.generation.store(generation, std::memory_order_seq_cst);
+        while (pinnedBuffer_.load(std::memory_order_seq_cst) == index) {
+            std::this_thread::yield();
+        }
+
+        // Resized whenever the resolution changes (growing past the capacity reallocates,
+        // and new bytes are zero-filled); steady state reuses the buffer as is
+        size_t bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+        if (buffer.data.size() != bytes) {
+            buffer.data.resize(bytes);
+        }
+        buffer.width = width;
+        buffer.height = height;
+        buffer.bandCount = std::max(1, std::min(bandCount, kMaxBands));
+        int64_t now = nowNs();
+        buffer.endNs.store(0, std::memory_order_release);
+        buffer.startNs.store(now, std::memory_order_release);
+        buffer.captureNs.store(captureNs > 0 ? captureNs : now, std::memory_order_release);
+
+        started_.store(generation, std::memory_order_release);
+        notifyConsumer();
+        return buffer.data.data();
+    }
+
+    void ProgressiveFrame::markBandReady(int band) {
+        uint64_t generation = started_.load(std::memory_order_relaxed);
+        buffers_[generation & 1].fences[band].store(generation, std::memory_order_release);
+        notifyConsumer();
+    }
+
+    void ProgressiveFrame::endFrame(bool success) {
+        uint64_t generation = started_.load(std::memory_order_relaxed);
+        buffers_[generation & 1].endNs.store(nowNs(), std::memory_order_release);
+        lastFailed_.store(!success, std::memory_order_relaxed);
+        ended_.store(generation, std::memory_order_release);
+        notifyConsumer();
+    }
+
+    void ProgressiveFrame::repeatFrame() {
+        repeats_.fetch_add(1, std::memory_order_release);
+        notifyConsumer();
+    }
+
+    bool ProgressiveFrame::takeBand(FrameBand& band, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        while (true) {
+            uint64_t seenEvents = events_.load(std::memory_order_seq_cst);
+            uint64_t generation = started_.load(std::memory_order_acquire);
+
+            if (generation != 0) {
+                // Always follow the newest frame; bands of an overtaken one are skipped
+                if (generation != consumerGeneration_) {
+                    consumerGeneration_ = generation;
+                    allBandsMask_ = 0;
+                    takenMask_ = 0;
+                    consumerFailed_ = false;
+                }
+
+                int index = static_cast<int>(generation & 1);
+                Buffer& buffer = buffers_[index];
+                pinnedBuffer_.store(index, std::memory_order_seq_cst);
+                if (buffer.generation.load(std::memory_order_seq_cst) == generation) {
+                    allBandsMask_ = buffer.bandCount == kMaxBands ? ~0ull : (1ull << buffer.bandCount) - 1;
+
+                    // Read before the fences: once the frame is closed every band it will publish is visible
+                    bool ended = ended_.load(std::memory_order_acquire) == generation;
+                    for (int b = 0; b < buffer.bandCount && takenMask_ != allBandsMask_; b++) {
+                        if ((takenMask_ >> b) & 1 ||
+                            buffer.fences[b].load(std::memory_order_acquire) != generation) {
+                            continue;
+                        }
+                        takenMask_ |= 1ull << b;
+                        band.width = buffer.width;
+                        band.height = buffer.height;
+                        band.rowStart = buffer.height * b / buffer.bandCount;
+                        band.rowEnd = buffer.height * (b + 1) / buffer.bandCount;
+                        band.data = buffer.data.data() + static_cast<size_t>(band.rowStart) * buffer.width * 4;
+                        bandsTaken_.fetch_add(1, std::memory_order_relaxed);
+                        if (!ended) {
+                            bandsTakenEarly_.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        return true;
+                    }
+
+                    if (ended && takenMask_ != allBandsMask_ && lastFailed_.load(std::memory_order_relaxed)) {
+                        // The rest of a failed frame will never arrive
+                        pinnedBuffer_.store(-1, std::memory_order_release);
+                        takenMask_ = allBandsMask_;
+                        consumerFailed_ = true;
+                        return false;
+                    }
+                }
+                pinnedBuffer_.store(-1, std::memory_order_release);
+            }
+
+            // Nothing left to take and the producer repeated its newest frame: the texture is current
+            uint64_t repeats = repeats_.load(std::memory_order_acquire);
+            if (repeats != consumerRepeats_) {
+                consumerRepeats_ = repeats;
+                return false;
+            }
+
+            // Wait for the producer to start a frame or finish a band
+            std::unique_lock<std::mutex> lock(waitMutex_);
+            consumerWaiting_.store(true, std::memory_order_seq_cst);
+            bool changed = waitCondition_.wait_until(lock, deadline, [this, seenEvents] {
+                return events_.load(std::memory_order_seq_cst) != seenEvents;
+            });
+            consumerWaiting_.store(false, std::memory_order_relaxed);
+            if (!changed) {
+                return false;
+            }
+        }
+    }
+
+    void ProgressiveFrame::releaseBand() {
+        pinnedBuffer_.store(-1, std::memory_order_release);
+    }
+
+    bool ProgressiveFrame::frameTaken() const {
+        return allBandsMask_ != 0 && !consumerFailed_ && takenMask_ == allBandsMask_;
+    }
+
+    bool ProgressiveFrame::frameTimes(FrameTimes& times) const {
+        if (consumerGeneration_ == 0) {
+            return false;
+        }
+
+        // Read, then check the producer has not restarted the buffer meanwhile: it bumps
+        // the generation before its release stores rewrite the times
+        const Buffer& buffer = buffers_[consumerGeneration_ & 1];
+        times.captureNs = buffer.captureNs.load(std::memory_order_acquire);
+        times.processStartNs = buffer.startNs.load(std::memory_order_acquire);
+        times.processEndNs = buffer.endNs.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return buffer.generation.load(std::memory_order_seq_cst) == consumerGeneration_ &&
+               times.processEndNs != 0;
+    }
+
+    void ProgressiveFrame::notifyConsumer() {
+        events_.fetch_add(1, std::memory_order_seq_cst);
+        if (consumerWaiting_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            waitCondition_.notify_one();
+        }
+    }
+
+} // namespace EdgeDetection
@@ -0,0 +1,168 @@
+#ifndef PROGRESSIVE_FRAME_H
+#define PROGRESSIVE_FRAME_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Finished rows of a frame, ready to upload
+ */
+    struct FrameBand {
+        const uint8_t* data = nullptr;  // Row rowStart of the frame (RGBA format)
+        int width = 0;                  // Frame width in pixels
+        int height = 0;                 // Frame height in pixels
+        int rowStart = 0;               // First row of the band
+        int rowEnd = 0;                 // One past the last row of the band
+    };
+
+/**
+ * @brief Timeline of one displayed frame, steady clock nanoseconds; 0 = not reached
+ */
+    struct FrameTimes {
+        int64_t captureNs = 0;          // Frame handed to native code by the camera callback
+        int64_t processStartNs = 0;     // Processing thread started on it
+        int64_t processEndNs = 0;       // Processing finished (last band published)
+        int64_t uploadNs = 0;           // Last band uploaded into the texture
+        int64_t presentNs = 0;          // Draw showing it submitted
+    };
+
+/**
+ * @brief Output frame handed from the processing thread to the GL thread band by band
+ *
+ * Two RGBA buffers alternate between frames. Every band has a ready fence
+ * holding the generation of the last frame that finished it, stored with
+ * release semantics once the band's rows are written, so the consumer can
+ * upload those rows while the rest of the frame is still being computed.
+ * The consumer pins the buffer it reads, and a producer about to reuse that
+ * buffer for the frame after next waits for the pin to clear, so rows are
+ * never overwritten mid-upload. One producer (whose pool workers may mark
+ * bands) and one consumer.
+ */
+    class ProgressiveFrame {
+    public:
+        static constexpr int kMaxBands = 64;
+
+        ProgressiveFrame();
+
+        ProgressiveFrame(const ProgressiveFrame&) = delete;
+        ProgressiveFrame& operator=(const ProgressiveFrame&) = delete;
+
+        /**
+         * @brief Size and pre-fault both buffers; call before frames start flowing
+         */
+        void reserve(int width, int height);
+
+        /**
+         * @brief Start the next frame (producer)
+         * @param bandCount Bands the frame is split into, at most kMaxBands
+         * @param captureNs Capture timestamp of the input (steady clock); 0 = now
+         * @return width * height * 4 writable bytes for the frame
+         */
+        uint8_t* beginFrame(int width, int height, int bandCount, int64_t captureNs = 0);
+
+        /**
+         * @brief Publish rows of band `band` of the current frame; any thread
+         */
+        void markBandReady(int band);
+
+        /**
+         * @brief Close the current frame; unfinished bands of a failed frame are never published
+         */
+        void endFrame(bool success);
+
+        /**
+         * @brief Announce that the next frame equals the newest one, so nothing needs uploading (producer)
+         *
+         * A consumer with nothing left to take returns from takeBand() at once
+         * instead of waiting for a frame that is not coming.
+         */
+        void repeatFrame();
+
+        /**
+         * @brief Take the next finished band of the newest frame not taken yet (consumer)
+         *
+         * Bands come in completion order. Once every band of the newest frame
+         * has been taken, waits for a newer frame. The band stays pinned until
+         * releaseBand().
+         * @param band Receives the band
+         * @param timeoutMs Maximum time to wait in milliseconds
+         * @return false on timeout, when the frame failed or when the newest frame was repeated
+         */
+        bool takeBand(FrameBand& band, int timeoutMs);
+
+        /**
+         * @brief Unpin the band returned by the last takeBand()
+         */
+        void releaseBand();
+
+        /**
+         * @brief Whether the consumer has taken every band of its current frame
+         */
+        bool frameTaken() const;
+
+        /**
+         * @brief Capture and processing times of the consumer's current frame (consumer)
+         *
+         * Upload and present times are left to the caller.
+         * @return false if the frame has not been closed yet or its buffer was already reused
+         */
+        bool frameTimes(FrameTimes& times) const;
+
+        uint64_t bandsTaken() const { return bandsTaken_.load(std::memory_order_relaxed); }
+        uint64_t bandsTakenEarly() const { return bandsTakenEarly_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Buffer {
+            std::vector<uint8_t> data;
+            int width = 0;
+            int height = 0;
+            int bandCount = 0;
+            std::atomic<uint64_t> generation{0};        // Frame the buffer currently holds
+            std::atomic<int64_t> captureNs{0};          // ... and its timeline; endNs is 0 until closed
+            std::atomic<int64_t> startNs{0};
+            std::atomic<int64_t> endNs{0};
+            std::atomic<uint64_t> fences[kMaxBands];    // Frame that last finished each band
+        };
+
+        void notifyConsumer();
+        static int64_t nowNs();
+
+        Buffer buffers_[2];
+
+        // Producer-owned state
+        alignas(64) uint64_t nextGeneration_;
+
+        // Newest frame started, and the newest frame closed
+        alignas(64) std::atomic<uint64_t> started_;
+        std::atomic<uint64_t> ended_;
+        std::atomic<bool> lastFailed_;
+        std::atomic<uint64_t> repeats_;
+
+        // Buffer the consumer is reading, -1 = none
+        alignas(64) std::atomic<int> pinnedBuffer_;
+
+        // Consumer-owned state
+        alignas(64) uint64_t consumerGeneration_;
+        uint64_t allBandsMask_;     // One bit per band of the consumer's frame, 0 until first seen
+        uint64_t takenMask_;
+        bool consumerFailed_;
+        uint64_t consumerRepeats_;  // repeats_ as of the consumer's last look
+
+        std::atomic<uint64_t> bandsTaken_;
+        std::atomic<uint64_t> bandsTakenEarly_;     // ... while their frame was still being computed
+
+        // Slow path only: used when the consumer is ahead of the producer
+        alignas(64) std::atomic<bool> consumerWaiting_;
+        std::atomic<uint64_t> events_;
+        std::mutex waitMutex_;
+        std::condition_variable waitCondition_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // PROGRESSIVE_FRAME_H
@@ -0,0 +1,298 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "frame_mailbox.h"
+#include "image_processor.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief What a full ring does with a new item
+ */
+    enum class BackpressurePolicy {
+        Block,          // Producer waits for the consumer (never drops)
+        DropOldest,     // Oldest queued item is discarded to make room
+        DropNewest,     // New item is rejected
+        Grow            // Capacity doubles up to maxCapacity, then blocks
+    };
+
+/**
+ * @brief Occupancy and drop counters of a ring
+ */
+    struct RingStats {
+        size_t capacity;            // Current capacity in slots
+        size_t highWaterMark;       // Highest observed occupancy
+        uint64_t pushed;            // Items accepted
+        uint64_t popped;            // Items consumed
+        uint64_t droppedOldest;     // Items evicted by DropOldest
+        uint64_t droppedNewest;     // Items rejected by DropNewest
+        uint64_t blockedPushes;     // Pushes that had to wait for space
+        uint64_t growEvents;        // Capacity doublings under Grow
+    };
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring of reusable slots
+ *
+ * Items are exchanged with std::swap rather than copied: push() hands the
+ * item to the ring and returns a recycled item in its place, pop() hands the
+ * consumer's spent item back. With frame buffers this keeps steady state free
+ * of allocations and copies. Each slot carries a sequence number (Vyukov
+ * style) and sits on its own cache line, so producer and consumer never share
+ * a line except for the head index, which DropOldest lets the producer
+ * advance with a CAS.
+ */
+    template<typename T>
+    class SpscRing {
+    public:
+        /**
+         * @param capacity Initial capacity in slots
+         * @param policy Behaviour when the ring is full
+         * @param maxCapacity Upper bound for BackpressurePolicy::Grow (ignored otherwise)
+         */
+        SpscRing(size_t capacity, BackpressurePolicy policy, size_t maxCapacity = 0)
+                : policy_(policy) {
+            capacity = std::max<size_t>(capacity, 1);
+            size_t limit = policy == BackpressurePolicy::Grow ? std::max(capacity, maxCapacity) : capacity;
+
+            size_t physical = 1;
+            while (physical < limit) {
+                physical <<= 1;
+            }
+            mask_ = physical - 1;
+            maxCapacity_ = limit;
+
+            slots_.reset(new Slot[physical]);
+            for (size_t i = 0; i < physical; i++) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            capacity_.store(capacity, std::memory_order_relaxed);
+            head_.store(0, std::memory_order_relaxed);
+            tail_.store(0, std::memory_order_relaxed);
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        /**
+         * @brief Enqueue an item (producer thread only)
+         * @param item Swapped into the ring; on return holds a recycled item
+         * @return false if the item was rejected (DropNewest) or the ring was closed
+         */
+        bool push(T& item) {
+            bool blocked = false;
+            unsigned spins = 0;
+
+            for (;;) {
+                size_t pos = tail_.load(std::memory_order_relaxed);
+                Slot& slot = slots_[pos & mask_];
+                size_t head = head_.load(std::memory_order_acquire);
+                size_t capacity = capacity_.load(std::memory_order_relaxed);
+
+                if (pos - head < capacity &&
+                    slot.sequence.load(std::memory_order_acquire) == pos) {
+                    std::swap(slot.value, item);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    tail_.store(pos + 1, std::memory_order_release);
+
+                    size_t occupancy = pos + 1 - head;
+                    if (occupancy > highWaterMark_.load(std::memory_order_relaxed)) {
+                        highWaterMark_.store(occupancy, std::memory_order_relaxed);
+                    }
+                    pushed_.fetch_add(1, std::memory_order_relaxed);
+                    if (blocked) {
+                        blockedPushes_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return true;
+                }
+
+                if (closed_.load(std::memory_order_acquire)) {
+                    return false;
+                }
+
+                // A slot that is only momentarily busy (consumer mid-swap) is not "full"
+                if (pos - head < capacity) {
+                    backoff(spins);
+                    continue;
+                }
+
+                switch (policy_) {
+                    case BackpressurePolicy::DropNewest:
+                        droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+
+                    case BackpressurePolicy::DropOldest:
+                        if (discardOldest(head)) {
+                            droppedOldest_.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        continue;
+
+                    case BackpressurePolicy::Grow:
+                        if (capacity < maxCapacity_) {
+                            capacity_.store(std::min(capacity * 2, maxCapacity_), std::memory_order_relaxed);
+                            growEvents_.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        // At the cap: never drop, wait like Block
+                        blocked = true;
+                        backoff(spins);
+                        continue;
+
+                    case BackpressurePolicy::Block:
+                        blocked = true;
+                        backoff(spins);
+                        continue;
+                }
+            }
+        }
+
+        /**
+         * @brief Dequeue an item without waiting (consumer thread only)
+         * @param item Swapped with the oldest queued item; its old value is recycled
+         * @return false if the ring was empty
+         */
+        bool tryPop(T& item) {
+            for (;;) {
+                size_t head = head_.load(std::memory_order_relaxed);
+                Slot& slot = slots_[head & mask_];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(sequence - (head + 1));
+
+                if (diff < 0) {
+                    return false;
+                }
+                if (diff > 0) {
+                    continue;   // Producer evicted this slot; reload head
+                }
+                if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                                std::memory_order_relaxed)) {
+                    std::swap(slot.value, item);
+                    slot.sequence.store(head + mask_ + 1, std::memory_order_release);
+                    popped_.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+
+        /**
+         * @brief Dequeue an item, waiting up to timeoutMs for one to arrive
+         * @return false on timeout, or if the ring was closed and drained
+         */
+        bool pop(T& item, int timeoutMs) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            unsigned spins = 0;
+
+            while (!tryPop(item)) {
+                if (closed_.load(std::memory_order_acquire) ||
+                    std::chrono::steady_clock::now() >= deadline) {
+                    return tryPop(item);
+                }
+                backoff(spins);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Stop accepting items and release a producer blocked in push()
+         */
+        void close() { closed_.store(true, std::memory_order_release); }
+
+        size_t size() const {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+
+        RingStats stats() const {
+            RingStats s;
+            s.capacity = capacity_.load(std::memory_order_relaxed);
+            s.highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+            s.pushed = pushed_.load(std::memory_order_relaxed);
+            s.popped = popped_.load(std::memory_order_relaxed);
+            s.droppedOldest = droppedOldest_.load(std::memory_order_relaxed);
+            s.droppedNewest = droppedNewest_.load(std::memory_order_relaxed);
+            s.blockedPushes = blockedPushes_.load(std::memory_order_relaxed);
+            s.growEvents = growEvents_.load(std::memory_order_relaxed);
+            return s;
+        }
+
+        /**
+         * @brief Copy occupancy and drop counters into a ProcessingStats snapshot
+         */
+        void reportTo(ProcessingStats& stats) const {
+            RingStats s = this->stats();
+            stats.queueCapacity = static_cast<int>(s.capacity);
+            stats.queueHighWaterMark = static_cast<int>(s.highWaterMark);
+            stats.queueDroppedOldest = s.droppedOldest;
+            stats.queueDroppedNewest = s.droppedNewest;
+            stats.queueBlockedPushes = s.blockedPushes;
+        }
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        /**
+         * @brief Evict the oldest committed item (producer side of DropOldest)
+         */
+        bool discardOldest(size_t head) {
+            Slot& slot = slots_[head & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+                return false;
+            }
+            if (!head_.compare_exchange_strong(head, head + 1, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed)) {
+                return false;   // Consumer took it first
+            }
+            // Keep the evicted value in place; the next push recycles it
+            slot.sequence.store(head + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        static void backoff(unsigned& spins) {
+            if (spins < 64) {
+                spins++;
+            } else if (spins < 128) {
+                spins++;
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+
+        const BackpressurePolicy policy_;
+        size_t mask_;
+        size_t maxCapacity_;
+        std::unique_ptr<Slot[]> slots_;
+
+        alignas(64) std::atomic<size_t> head_;     // Consumer index (producer CAS on DropOldest)
+        alignas(64) std::atomic<size_t> tail_;     // Producer index
+        std::atomic<size_t> capacity_;
+        std::atomic<size_t> highWaterMark_{0};
+
+        alignas(64) std::atomic<bool> closed_{false};
+        std::atomic<uint64_t> pushed_{0};
+        std::atomic<uint64_t> popped_{0};
+        std::atomic<uint64_t> droppedOldest_{0};
+        std::atomic<uint64_t> droppedNewest_{0};
+        std::atomic<uint64_t> blockedPushes_{0};
+        std::atomic<uint64_t> growEvents_{0};
+    };
+
+/**
+ * @brief Lossless (or policy-controlled) queue of RGBA frames
+ */
+    using FrameQueue = SpscRing<FrameSlot>;
+
+} // namespace EdgeDetection
+
+#endif // SPSC_RING_H
@@ -0,0 +1,391 @@
+//
+// Multi-stream scheduler: several camera/video streams on one shared worker pool
+//
+#include "stream_scheduler.h"
+#include "log.h"
+#include "mat_allocator.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+#define LOG_TAG "StreamScheduler"
+
+namespace EdgeDetection {
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    enum FrameJobState {
+        kJobFree,       // Available for the next frame
+        kJobRunning,    // Bands queued or running
+        kJobDone        // Processed, waiting for earlier frames to be delivered
+    };
+
+    struct StreamScheduler::Band {
+        FrameJob* job;
+        int rowStart;
+        int rowEnd;
+    };
+
+    // One frame being processed; a stream cycles through framesInFlight of them in order
+    struct StreamScheduler::FrameJob {
+        Stream* stream;
+        FrameSlot input;
+        FrameSlot output;
+        DetectorParameters parameters;
+        std::vector<Band> bands;
+        std::vector<Workspace> workspaces;  // Per band, so buffer sizes stay stable across frames
+        std::atomic<int> bandsRemaining{0};
+        std::atomic<bool> bandFailed{false};
+        std::atomic<int> state{kJobFree};
+        int64_t startNs = 0;
+    };
+
+    struct StreamScheduler::Stream {
+        StreamScheduler* owner;
+        int id;
+        StreamConfig config;
+        int64_t frameIntervalNs;
+        int64_t deadlineNs;
+
+        std::unique_ptr<FrameQueue> queue;
+
+        // Producer-owned
+        FrameSlot staging;              // Recycled slot filled by submitFrame
+        uint64_t nextSequence = 1;
+
+        // Dispatcher-owned
+        FrameSlot pending;              // Next frame, taken from the queue
+        bool hasPending = false;
+        int64_t nextDueNs = 0;          // Rate limit: earliest start of the next frame
+        uint64_t jobsStarted = 0;
+
+        // In-flight frames, started and delivered in ring order
+        std::vector<std::unique_ptr<FrameJob>> jobs;
+        std::atomic<int> jobsInFlight{0};
+        std::mutex deliveryMutex;
+        uint64_t jobsDelivered = 0;     // Guarded by deliveryMutex
+
+        ParameterStore parameters;     // Published by updateParameters, read once per frame
+
+        StatsRecorder stats;
+    };
+
+    StreamScheduler::StreamScheduler(std::shared_ptr<WorkerPool> pool, StreamSink sink)
+            : pool_(pool ? std::move(pool) : WorkerPool::shared()),
+              sink_(std::move(sink)),
+              running_(true),
+              dispatcherWaiting_(false) {
+        // Bands are the unit of parallelism; OpenCV's own threads would oversubscribe the cores
+        cv::setNumThreads(0);
+
+        dispatcher_ = std::thread(&StreamScheduler::dispatchLoop, this);
+    }
+
+    StreamScheduler::~StreamScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            running_.store(false, std::memory_order_seq_cst);
+        }
+        wakeCondition_.notify_one();
+        if (dispatcher_.joinable()) {
+            dispatcher_.join();
+        }
+
+        // Bands still reference their stream; let them drain before tearing down
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        for (auto& stream : streams_) {
+            stream->queue->close();
+            while (stream->jobsInFlight.load(std::memory_order_acquire) > 0) {
+                if (!pool_->runPendingTask()) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    int StreamScheduler::registerStream(const StreamConfig& config) {
+        std::unique_ptr<Stream> stream(new Stream());
+        stream->owner = this;
+        stream->config = config;
+        stream->frameIntervalNs = config.targetFps > 0.0
+                                  ? static_cast<int64_t>(1e9 / config.targetFps) : 0;
+        stream->deadlineNs = config.deadlineMs > 0.0
+                             ? static_cast<int64_t>(config.deadlineMs * 1e6)
+                             : 2 * stream->frameIntervalNs;
+        stream->queue.reset(new FrameQueue(std::max(config.queueCapacity, 1), config.queuePolicy,
+                                           std::max(config.queueCapacity, 1) * 4));
+        DetectorParameters initial = stream->parameters.publish(config.parameters);
+        stream->stats.setParameters(initial.lowThreshold, initial.highThreshold, initial.blurKernel);
+
+        stream->jobs.resize(std::max(config.framesInFlight, 1));
+        for (auto& job : stream->jobs) {
+            job.reset(new FrameJob());
+            job->stream = stream.get();
+        }
+
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        stream->id = static_cast<int>(streams_.size());
+        streams_.push_back(std::move(stream));
+
+        LOGI("Registered stream %d (%.1f fps, priority %d)",
+             streams_.back()->id, config.targetFps, config.priority);
+        return streams_.back()->id;
+    }
+
+    int StreamScheduler::streamCount() const {
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        return static_cast<int>(streams_.size());
+    }
+
+    bool StreamScheduler::submitFrame(int streamId, const uint8_t* inputData, int width, int height,
+                                      int64_t timestampNs) {
+        if (!inputData || width <= 0 || height <= 0) {
+            LOGE("Invalid frame for stream %d", streamId);
+            return false;
+        }
+
+        Stream* stream = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(streamsMutex_);
+            if (streamId < 0 || streamId >= static_cast<int>(streams_.size())) {
+                LOGE("Unknown stream %d", streamId);
+                return false;
+            }
+            stream = streams_[streamId].get();
+        }
+
+        // Fill the recycled slot, then swap it into the ring
+        FrameSlot& staging = stream->staging;
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+        staging.data.resize(bytes);
+        memcpy(staging.data.data(), inputData, bytes);
+        staging.width = width;
+        staging.height = height;
+        staging.timestampNs = timestampNs;
+        staging.sequence = stream->nextSequence++;
+
+        bool accepted = stream->queue->push(staging);
+
+        if (dispatcherWaiting_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wakeCondition_.notify_one();
+        }
+        return accepted;
+    }
+
+    void StreamScheduler::updateParameters(int streamId, const DetectorParameters& parameters) {
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        if (streamId < 0 || streamId >= static_cast<int>(streams_.size())) {
+            LOGE("Unknown stream %d", streamId);
+            return;
+        }
+
+        Stream& stream = *streams_[streamId];
+        DetectorParameters applied = stream.parameters.publish(parameters);
+        stream.stats.setParameters(applied.lowThreshold, applied.highThreshold, applied.blurKernel);
+    }
+
+    ProcessingStats StreamScheduler::getStreamStats(int streamId) const {
+        ProcessingStats stats = {};
+
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        if (streamId < 0 || streamId >= static_cast<int>(streams_.size())) {
+            LOGE("Unknown stream %d", streamId);
+            return stats;
+        }
+
+        const Stream& stream = *streams_[streamId];
+        stats = stream.stats.snapshot();
+        stream.queue->reportTo(stats);
+
+        PoolStats poolStats = pool_->stats();
+        stats.tasksStolen = poolStats.tasksStolen;
+        stats.failedSteals = poolStats.failedSteals;
+        stats.workerIdleMs = poolStats.idleTimeMs;
+
+        if (const PooledMatAllocator* allocator = PooledMatAllocator::installed()) {
+            allocator->reportTo(stats);
+        }
+        return stats;
+    }
+
+    void StreamScheduler::dispatchLoop() {
+        TRACE_THREAD_NAME("stream-dispatcher");
+        while (running_.load(std::memory_order_acquire)) {
+            int64_t sleepUntilNs = INT64_MAX;
+            Stream* next = pickNextStream(nowNs(), sleepUntilNs);
+            if (next) {
+                startFrame(*next);
+                continue;
+            }
+
+            // Nothing runnable: sleep until a frame arrives, a frame finishes or a rate limit expires
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            dispatcherWaiting_.store(true, std::memory_order_seq_cst);
+            int64_t waitNs = sleepUntilNs == INT64_MAX ? 5000000 : sleepUntilNs - nowNs();
+            if (waitNs > 0 && running_.load(std::memory_order_seq_cst)) {
+                wakeCondition_.wait_for(lock, std::chrono::nanoseconds(std::min<int64_t>(waitNs, 5000000)));
+            }
+            dispatcherWaiting_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    StreamScheduler::Stream* StreamScheduler::pickNextStream(int64_t now, int64_t& sleepUntilNs) {
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+
+        Stream* best = nullptr;
+        int64_t bestDeadline = 0;
+
+        for (auto& entry : streams_) {
+            Stream& stream = *entry;
+            const FrameJob& nextJob = *stream.jobs[stream.jobsStarted % stream.jobs.size()];
+            if (nextJob.state.load(std::memory_order_acquire) != kJobFree) {
+                continue;   // Bounded frames in flight keep latency and fairness in check
+            }
+
+            // Take the next frame, skipping those that can no longer meet their deadline
+            for (;;) {
+                if (!stream.hasPending) {
+                    stream.hasPending = stream.queue->tryPop(stream.pending);
+                }
+                if (!stream.hasPending) {
+                    break;
+                }
+                bool late = stream.config.dropLateFrames && stream.deadlineNs > 0 &&
+                            now > stream.pending.timestampNs + stream.deadlineNs;
+                if (!late) {
+                    break;
+                }
+                stream.hasPending = false;
+                stream.stats.recordDropped();
+            }
+
+            if (!stream.hasPending) {
+                continue;
+            }
+            if (now < stream.nextDueNs) {
+                sleepUntilNs = std::min(sleepUntilNs, stream.nextDueNs);
+                continue;
+            }
+
+            // Strict priority, earliest deadline first within a priority level
+            int64_t deadline = stream.pending.timestampNs + stream.deadlineNs;
+            if (!best || stream.config.priority > best->config.priority ||
+                (stream.config.priority == best->config.priority && deadline < bestDeadline)) {
+                best = &stream;
+                bestDeadline = deadline;
+            }
+        }
+
+        return best;
+    }
+
+    void StreamScheduler::startFrame(Stream& stream) {
+        int64_t start = nowNs();
+        stream.nextDueNs = std::max(stream.nextDueNs + stream.frameIntervalNs, start);
+
+        FrameJob& job = *stream.jobs[stream.jobsStarted % stream.jobs.size()];
+        stream.jobsStarted++;
+        job.startNs = start;
+
+        std::swap(job.input, stream.pending);
+        stream.hasPending = false;
+
+        job.parameters = stream.parameters.snapshot();
+
+        const FrameSlot& input = job.input;
+        job.output.data.resize(input.data.size());
+        job.output.width = input.width;
+        job.output.height = input.height;
+        job.output.sequence = input.sequence;
+        job.output.timestampNs = input.timestampNs;
+
+        int bandCount = frameBandCount(input.height, pool_->size());
+        job.bands.resize(bandCount);
+        job.workspaces.resize(bandCount);
+        for (int i = 0; i < bandCount; i++) {
+            job.bands[i].job = &job;
+            job.bands[i].rowStart = input.height * i / bandCount;
+            job.bands[i].rowEnd = input.height * (i + 1) / bandCount;
+        }
+
+        job.bandFailed.store(false, std::memory_order_relaxed);
+        job.bandsRemaining.store(bandCount, std::memory_order_relaxed);
+        job.state.store(kJobRunning, std::memory_order_relaxed);
+        stream.jobsInFlight.fetch_add(1, std::memory_order_release);
+
+        pool_->submitRange(&StreamScheduler::runBand, &job, bandCount, nullptr);
+    }
+
+    void StreamScheduler::runBand(void* context, int index) {
+        FrameJob& job = *static_cast<FrameJob*>(context);
+        StreamScheduler& owner = *job.stream->owner;
+        const Band& band = job.bands[index];
+        const DetectorParameters& params = job.parameters;
+        TRACE_FRAME(job.input.sequence);
+
+        Workspace& workspace = job.workspaces[index];
+        workspace.stats = &job.stream->stats;
+        bool success = processFrameRows(job.input.data.data(),
+                                        job.input.width, job.input.height,
+                                        job.output.data.data(),
+                                        band.rowStart, band.rowEnd,
+                                        params.lowThreshold, params.highThreshold, params.blurKernel,
+                                        workspace);
+        if (!success) {
+            job.bandFailed.store(true, std::memory_order_relaxed);
+        }
+
+        if (job.bandsRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            job.state.store(kJobDone, std::memory_order_release);
+            owner.deliverFrames(*job.stream);
+        }
+    }
+
+    void StreamScheduler::deliverFrames(Stream& stream) {
+        int released = 0;
+        {
+            // A later frame may finish first; it waits here until the earlier ones are delivered
+            std::lock_guard<std::mutex> lock(stream.deliveryMutex);
+            for (;;) {
+                FrameJob& job = *stream.jobs[stream.jobsDelivered % stream.jobs.size()];
+                if (job.state.load(std::memory_order_acquire) != kJobDone) {
+                    break;
+                }
+
+                int64_t end = nowNs();
+                if (job.bandFailed.load(std::memory_order_relaxed)) {
+                    LOGE_EVERY_MS(kFrameLogIntervalMs, "Stream %d: frame %llu failed", stream.id,
+                                  static_cast<unsigned long long>(job.input.sequence));
+                } else {
+                    if (sink_) {
+                        TRACE_SCOPE_FRAME("sink", job.output.sequence);
+                        sink_(stream.id, job.output);
+                    }
+
+                    stream.stats.recordFrame(end - job.startNs, job.input.data.size(),
+                                             static_cast<int>(job.bands.size()));
+                }
+
+                stream.jobsDelivered++;
+                job.state.store(kJobFree, std::memory_order_release);
+                released++;
+            }
+        }
+
+        if (released > 0) {
+            if (dispatcherWaiting_.load(std::memory_order_seq_cst)) {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                wakeCondition_.notify_one();
+            }
+
+            // Last touch of the scheduler: the destructor may proceed once this reaches zero
+            stream.jobsInFlight.fetch_sub(released, std::memory_order_release);
+        }
+    }
+
+} // namespace EdgeDetection
@@ -0,0 +1,127 @@
+#ifndef STREAM_SCHEDULER_H
+#define STREAM_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "image_processor.h"
+#include "edge_detector.h"
+#include "processing_stats.h"
+#include "spsc_ring.h"
+#include "worker_pool.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Registration settings for one camera/video stream
+ */
+    struct StreamConfig {
+        double targetFps = 30.0;        // Maximum processing rate for this stream
+        int priority = 0;               // Higher priority streams are served first (strictly; see StreamScheduler)
+        double deadlineMs = 0.0;        // Latency budget from capture; 0 = two frame intervals
+        bool dropLateFrames = true;     // Skip frames already past their deadline
+        int queueCapacity = 4;          // Frames buffered ahead of processing
+        int framesInFlight = 2;         // Consecutive frames whose bands may share the pool at once
+        BackpressurePolicy queuePolicy = BackpressurePolicy::DropOldest;
+        DetectorParameters parameters;  // Initial edge detection parameters
+    };
+
+/**
+ * @brief Receives finished frames: stream id and the processed RGBA frame
+ *
+ * Called on a pool worker; the frame is only valid for the duration of the call.
+ */
+    using StreamSink = std::function<void(int streamId, const FrameSlot& output)>;
+
+/**
+ * @brief Runs several streams on one shared worker pool
+ *
+ * Each stream has its own input ring, parameters and statistics. A dispatcher
+ * thread rate-limits each stream to its target frame rate, drops frames that
+ * are already past their deadline, and starts the next frame by priority,
+ * then earliest deadline. Priorities are strict: a stream only gets a frame
+ * started while no higher-priority stream has one ready, so a busy
+ * higher-priority stream with targetFps 0 can hold back lower ones
+ * indefinitely; give streams that share the pool a finite target rate.
+ * The chosen frame is split into row bands that are processed as
+ * independent pool tasks. Up to framesInFlight consecutive frames of a stream
+ * run at once, so the next frame's bands fill cores left idle by the slow
+ * bands of the previous one; results still reach the sink in frame order.
+ * Bands of different streams interleave on the same workers instead of each
+ * stream oversubscribing the cores with its own threads.
+ */
+    class StreamScheduler {
+    public:
+        /**
+         * @param pool Worker pool to share; null uses WorkerPool::shared()
+         * @param sink Callback receiving finished frames
+         */
+        StreamScheduler(std::shared_ptr<WorkerPool> pool, StreamSink sink);
+        ~StreamScheduler();
+
+        StreamScheduler(const StreamScheduler&) = delete;
+        StreamScheduler& operator=(const StreamScheduler&) = delete;
+
+        /**
+         * @brief Add a stream
+         * @return Stream id used by the other calls
+         */
+        int registerStream(const StreamConfig& config);
+
+        /**
+         * @brief Queue a frame for a stream (one producer thread per stream)
+         * @param streamId Stream returned by registerStream
+         * @param inputData Frame data (RGBA format)
+         * @param width Frame width in pixels
+         * @param height Frame height in pixels
+         * @param timestampNs Capture timestamp (steady clock)
+         * @return false if the stream is unknown or the frame was rejected
+         */
+        bool submitFrame(int streamId, const uint8_t* inputData, int width, int height,
+                         int64_t timestampNs);
+
+        /**
+         * @brief Change a stream's edge detection parameters
+         */
+        void updateParameters(int streamId, const DetectorParameters& parameters);
+
+        /**
+         * @brief Statistics of one stream
+         */
+        ProcessingStats getStreamStats(int streamId) const;
+
+        int streamCount() const;
+
+    private:
+        struct Stream;
+        struct FrameJob;
+        struct Band;
+
+        void dispatchLoop();
+        Stream* pickNextStream(int64_t nowNs, int64_t& sleepUntilNs);
+        void startFrame(Stream& stream);
+        void deliverFrames(Stream& stream);
+        static void runBand(void* context, int index);
+
+        std::shared_ptr<WorkerPool> pool_;
+        StreamSink sink_;
+
+        mutable std::mutex streamsMutex_;
+        std::vector<std::unique_ptr<Stream>> streams_;
+
+        std::atomic<bool> running_;
+        std::atomic<bool> dispatcherWaiting_;
+        std::mutex wakeMutex_;
+        std::condition_variable wakeCondition_;
+        std::thread dispatcher_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // STREAM_SCHEDULER_H
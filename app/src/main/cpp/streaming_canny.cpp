@@ -0,0 +1,522 @@
+//
+// Streaming Canny over rolling line buffers for memory-constrained targets
+//
+#include "streaming_canny.h"
+#include "canny_stages.h"
+#include "log.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+#define LOG_TAG "StreamingCanny"
+
+namespace EdgeDetection {
+
+    // Hysteresis class of a pixel in the window
+    static constexpr uint8_t kNone = 0;
+    static constexpr uint8_t kWeak = 1;     // Above the low threshold, not yet connected to an edge
+    static constexpr uint8_t kEdge = 2;
+
+    // Fixed-point Gaussian: taps in Q8, blurred rows in Q16 before rounding
+    static constexpr int kTapBits = 8;
+
+/**
+ * @brief Index of position i in a row of n pixels under BORDER_REFLECT_101 (GaussianBlur's default)
+ */
+    static int reflect101(int i, int n) {
+        if (n == 1) {
+            return 0;
+        }
+        while (i < 0 || i >= n) {
+            i = i < 0 ? -i : 2 * n - 2 - i;
+        }
+        return i;
+    }
+
+    static int findRoot(std::vector<int>& parent, int node) {
+        while (parent[node] != node) {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    }
+
+    static void unite(std::vector<int>& parent, int a, int b) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+    StreamingCanny::StreamingCanny()
+            : width_(0),
+              height_(0),
+              channels_(0),
+              low_(0),
+              high_(0),
+              radius_(0),
+              windowRows_(0),
+              inputRows_(0),
+              blurredRows_(0),
+              gradientRows_(0),
+              suppressedRows_(0),
+              windowTop_(0),
+              componentCount_(0) {
+    }
+
+    bool StreamingCanny::begin(int width, int height, int channels, double lowThreshold,
+                               double highThreshold, int kernelSize, EdgeRowSink sink, int windowRows) {
+        if (width <= 0 || height <= 0) {
+            LOGE("Invalid streaming image size %dx%d", width, height);
+            return false;
+        }
+        if (channels != 1 && channels != 3 && channels != 4) {
+            LOGE("Unsupported channel count for streaming: %d", channels);
+            return false;
+        }
+        if (kernelSize <= 0 || kernelSize % 2 == 0) {
+            LOGE("Invalid blur kernel size for streaming: %d", kernelSize);
+            return false;
+        }
+
+        try {
+            width_ = width;
+            height_ = height;
+            channels_ = channels;
+            radius_ = kernelSize / 2;
+            windowRows_ = std::max(2, windowRows);
+            cannyThresholds(lowThreshold, highThreshold, low_, high_);
+            sink_ = std::move(sink);
+
+            // Same Gaussian as cv::getGaussianKernel, rounded to Q8 with the
+            // rounding error folded into the centre tap so the taps sum to one.
+            // Always the exact kernel: the window holds kernelSize rows either way
+            double sigma = blurSigma(kernelSize);
+            auto weight = [&](int k) {
+                double offset = k - radius_;
+                return std::exp(-offset * offset / (2.0 * sigma * sigma));
+            };
+            double weightSum = 0.0;
+            for (int k = 0; k < kernelSize; k++) {
+                weightSum += weight(k);
+            }
+            taps_.resize(kernelSize);
+            int tapSum = 0;
+            for (int k = 0; k < kernelSize; k++) {
+                taps_[k] = static_cast<uint16_t>(std::lround(weight(k) / weightSum * (1 << kTapBits)));
+                tapSum += taps_[k];
+            }
+            taps_[radius_] = static_cast<uint16_t>(taps_[radius_] + (1 << kTapBits) - tapSum);
+
+            size_t rowPixels = static_cast<size_t>(width);
+            grayRow_.create(1, width, CV_8UC1);
+            horizontal_.assign(rowPixels * kernelSize, 0);
+            accumulator_.assign(rowPixels, 0);
+            blurred_.assign(rowPixels * 3, 0);
+            dx_.assign(rowPixels * 3, 0);
+            dy_.assign(rowPixels * 3, 0);
+            magnitude_.assign(rowPixels * 3, 0);
+            suppressed_.assign(rowPixels, 0);
+            classes_.assign(rowPixels * windowRows_, kNone);
+            edgeRow_.assign(rowPixels, 0);
+            boundary_.assign(rowPixels, -1);
+            stack_.clear();
+            componentCount_ = 0;
+            lateRuns_.clear();
+
+            inputRows_ = 0;
+            blurredRows_ = 0;
+            gradientRows_ = 0;
+            suppressedRows_ = 0;
+            windowTop_ = 0;
+            return true;
+
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in StreamingCanny::begin: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            LOGE("Standard exception in StreamingCanny::begin: %s", e.what());
+            return false;
+        }
+    }
+
+    bool StreamingCanny::pushRow(const uint8_t* row) {
+        if (inputRows_ >= height_) {
+            LOGE("Streaming image already has all %d rows", height_);
+            return false;
+        }
+
+        try {
+            cv::Mat inputRow(1, width_, CV_8UC(channels_), const_cast<uint8_t*>(row));
+            if (channels_ == 4) {
+                cv::cvtColor(inputRow, grayRow_, cv::COLOR_RGBA2GRAY);
+            } else if (channels_ == 3) {
+                cv::cvtColor(inputRow, grayRow_, cv::COLOR_BGR2GRAY);
+            } else {
+                std::memcpy(grayRow_.ptr<uint8_t>(0), row, static_cast<size_t>(width_));
+            }
+            horizontalBlur(inputRows_++);
+
+            // Each stage runs as soon as the rows below it are in; the last input
+            // row releases several at once, borders standing in for missing rows
+            while (blurredRows_ < height_ && std::min(height_ - 1, blurredRows_ + radius_) < inputRows_) {
+                verticalBlur(blurredRows_++);
+                while (gradientRows_ < blurredRows_ && std::min(height_ - 1, gradientRows_ + 1) < blurredRows_) {
+                    computeGradients(gradientRows_++);
+                    while (suppressedRows_ < gradientRows_ &&
+                           std::min(height_ - 1, suppressedRows_ + 1) < gradientRows_) {
+                        suppressRow(suppressedRows_);
+                        insertRow(suppressedRows_);
+                        suppressedRows_++;
+                    }
+                }
+            }
+            return true;
+
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in StreamingCanny::pushRow: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            LOGE("Standard exception in StreamingCanny::pushRow: %s", e.what());
+            return false;
+        }
+    }
+
+    bool StreamingCanny::finish(const LateEdgeSink& lateSink) {
+        if (inputRows_ != height_) {
+            LOGE("Streaming image ended after %d of %d rows", inputRows_, height_);
+            return false;
+        }
+
+        try {
+            while (windowTop_ < suppressedRows_) {
+                exitRow();
+            }
+
+            std::sort(lateRuns_.begin(), lateRuns_.end(), [](const EdgeRun& a, const EdgeRun& b) {
+                return a.y != b.y ? a.y < b.y : a.xStart < b.xStart;
+            });
+            for (const EdgeRun& run : lateRuns_) {
+                lateSink(run.y, run.xStart, run.xEnd);
+            }
+            LOGD("Streamed %dx%d with %zu late edge runs", width_, height_, lateRuns_.size());
+
+            lateRuns_.clear();
+            componentCount_ = 0;
+            return true;
+
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in StreamingCanny::finish: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            LOGE("Standard exception in StreamingCanny::finish: %s", e.what());
+            return false;
+        }
+    }
+
+    size_t StreamingCanny::workingSetBytes() const {
+        size_t bytes = grayRow_.total() * grayRow_.elemSize()
+                       + horizontal_.capacity() * sizeof(uint16_t)
+                       + accumulator_.capacity() * sizeof(uint32_t)
+                       + blurred_.capacity()
+                       + (dx_.capacity() + dy_.capacity()) * sizeof(short)
+                       + (magnitude_.capacity() + suppressed_.capacity()) * sizeof(uint16_t)
+                       + classes_.capacity() + edgeRow_.capacity()
+                       + (stack_.capacity() + boundary_.capacity()) * sizeof(int)
+                       + lateRuns_.capacity() * sizeof(EdgeRun);
+        for (const std::vector<EdgeRun>& runs : components_) {
+            bytes += runs.capacity() * sizeof(EdgeRun);
+        }
+        for (const std::vector<EdgeRun>& runs : nextComponents_) {
+            bytes += runs.capacity() * sizeof(EdgeRun);
+        }
+        return bytes;
+    }
+
+    void StreamingCanny::horizontalBlur(int row) {
+        const uint8_t* gray = grayRow_.ptr<uint8_t>(0);
+        uint16_t* out = horizontal_.data() + static_cast<size_t>(row % taps_.size()) * width_;
+        int taps = static_cast<int>(taps_.size());
+
+        for (int x = 0; x < width_; x++) {
+            uint32_t sum = 0;
+            if (x >= radius_ && x + radius_ < width_) {
+                const uint8_t* source = gray + x - radius_;
+                for (int k = 0; k < taps; k++) {
+                    sum += taps_[k] * source[k];
+                }
+            } else {
+                for (int k = 0; k < taps; k++) {
+                    sum += taps_[k] * gray[reflect101(x - radius_ + k, width_)];
+                }
+            }
+            out[x] = static_cast<uint16_t>(sum);
+        }
+    }
+
+    void StreamingCanny::verticalBlur(int row) {
+        int taps = static_cast<int>(taps_.size());
+        std::fill(accumulator_.begin(), accumulator_.end(), 0);
+        for (int k = 0; k < taps; k++) {
+            int sourceRow = reflect101(row - radius_ + k, height_);
+            const uint16_t* source = horizontal_.data() + static_cast<size_t>(sourceRow % taps) * width_;
+            uint32_t tap = taps_[k];
+            for (int x = 0; x < width_; x++) {
+                accumulator_[x] += tap * source[x];
+            }
+        }
+
+        uint8_t* out = blurred_.data() + static_cast<size_t>(row % 3) * width_;
+        for (int x = 0; x < width_; x++) {
+            out[x] = static_cast<uint8_t>((accumulator_[x] + (1u << (2 * kTapBits - 1))) >> (2 * kTapBits));
+        }
+    }
+
+    void StreamingCanny::computeGradients(int row) {
+        // 3x3 Sobel with a replicated border, as cv::Canny computes it
+        const uint8_t* above = blurred_.data() + static_cast<size_t>(std::max(row - 1, 0) % 3) * width_;
+        const uint8_t* current = blurred_.data() + static_cast<size_t>(row % 3) * width_;
+        const uint8_t* below = blurred_.data() + static_cast<size_t>(std::min(row + 1, height_ - 1) % 3) * width_;
+        size_t offset = static_cast<size_t>(row % 3) * width_;
+        short* dxRow = dx_.data() + offset;
+        short* dyRow = dy_.data() + offset;
+        uint16_t* magnitudeRow = magnitude_.data() + offset;
+
+        for (int x = 0; x < width_; x++) {
+            int left = std::max(x - 1, 0);
+            int right = std::min(x + 1, width_ - 1);
+            int gx = (above[right] - above[left]) + 2 * (current[right] - current[left])
+                     + (below[right] - below[left]);
+            int gy = (below[left] + 2 * below[x] + below[right]) - (above[left] + 2 * above[x] + above[right]);
+            dxRow[x] = static_cast<short>(gx);
+            dyRow[x] = static_cast<short>(gy);
+            magnitudeRow[x] = static_cast<uint16_t>(std::abs(gx) + std::abs(gy));
+        }
+    }
+
+    void StreamingCanny::suppressRow(int row) {
+        size_t offset = static_cast<size_t>(row % 3) * width_;
+        const uint16_t* above = row > 0
+                                ? magnitude_.data() + static_cast<size_t>((row - 1) % 3) * width_ : nullptr;
+        const uint16_t* below = row + 1 < height_
+                                ? magnitude_.data() + static_cast<size_t>((row + 1) % 3) * width_ : nullptr;
+        suppressNonMaximaRow(dx_.data() + offset, dy_.data() + offset, above, magnitude_.data() + offset,
+                             below, suppressed_.data(), width_);
+    }
+
+    void StreamingCanny::insertRow(int row) {
+        if (row - windowTop_ == windowRows_) {
+            exitRow();
+        }
+
+        int slot = row % windowRows_;
+        uint8_t* classes = classes_.data() + static_cast<size_t>(slot) * width_;
+        for (int x = 0; x < width_; x++) {
+            int m = suppressed_[x];
+            if (m > high_) {
+                classes[x] = kEdge;
+                stack_.push_back(slot * width_ + x);
+            } else {
+                classes[x] = m > low_ ? kWeak : kNone;
+            }
+        }
+
+        // Edges already in the window only reached the rows that were there
+        if (row > windowTop_) {
+            const uint8_t* above = classes_.data() + static_cast<size_t>((row - 1) % windowRows_) * width_;
+            for (int x = 0; x < width_; x++) {
+                if (classes[x] != kWeak) {
+                    continue;
+                }
+                int left = std::max(x - 1, 0);
+                int right = std::min(x + 1, width_ - 1);
+                for (int nx = left; nx <= right; nx++) {
+                    if (above[nx] == kEdge) {
+                        classes[x] = kEdge;
+                        stack_.push_back(slot * width_ + x);
+                        break;
+                    }
+                }
+            }
+        }
+
+        flood(row);
+    }
+
+    void StreamingCanny::flood(int bottomRow) {
+        int topSlot = windowTop_ % windowRows_;
+        int bottomSlot = bottomRow % windowRows_;
+
+        while (!stack_.empty()) {
+            int index = stack_.back();
+            stack_.pop_back();
+            int slot = index / width_;
+            int x = index - slot * width_;
+            int left = std::max(x - 1, 0);
+            int right = std::min(x + 1, width_ - 1);
+
+            promoteNeighbours(slot, left, right);
+            if (slot != topSlot) {
+                promoteNeighbours((slot + windowRows_ - 1) % windowRows_, left, right);
+            } else {
+                // Above the window only unresolved components remain
+                for (int nx = left; nx <= right; nx++) {
+                    if (boundary_[nx] >= 0) {
+                        promoteComponent(boundary_[nx]);
+                    }
+                }
+            }
+            if (slot != bottomSlot) {
+                promoteNeighbours((slot + 1) % windowRows_, left, right);
+            }
+        }
+    }
+
+    void StreamingCanny::promoteNeighbours(int slot, int left, int right) {
+        uint8_t* classes = classes_.data() + static_cast<size_t>(slot) * width_;
+        for (int x = left; x <= right; x++) {
+            if (classes[x] == kWeak) {
+                classes[x] = kEdge;
+                stack_.push_back(slot * width_ + x);
+            }
+        }
+    }
+
+    void StreamingCanny::promoteComponent(int component) {
+        // Its pixels were emitted as non-edges; finish() reports them
+        std::vector<EdgeRun>& runs = components_[component];
+        lateRuns_.insert(lateRuns_.end(), runs.begin(), runs.end());
+        runs.clear();
+
+        int topSlot = windowTop_ % windowRows_;
+        for (int x = 0; x < width_; x++) {
+            if (boundary_[x] == component) {
+                boundary_[x] = -1;
+                promoteNeighbours(topSlot, std::max(x - 1, 0), std::min(x + 1, width_ - 1));
+            }
+        }
+    }
+
+    void StreamingCanny::exitRow() {
+        int row = windowTop_;
+        const uint8_t* classes = classes_.data() + static_cast<size_t>(row % windowRows_) * width_;
+        for (int x = 0; x < width_; x++) {
+            edgeRow_[x] = classes[x] == kEdge ? 255 : 0;
+        }
+        sink_(row, edgeRow_.data());
+
+        // The row's unresolved weak runs become the new boundary, joined to the
+        // components of the previous boundary they touch (8-connected)
+        rowRuns_.clear();
+        for (int x = 0; x < width_;) {
+            if (classes[x] != kWeak) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < width_ && classes[x] == kWeak) {
+                x++;
+            }
+            rowRuns_.push_back({row, start, x});
+        }
+
+        int oldCount = componentCount_;
+        int runCount = static_cast<int>(rowRuns_.size());
+        parent_.resize(oldCount + runCount);
+        std::iota(parent_.begin(), parent_.end(), 0);
+        for (int run = 0; run < runCount; run++) {
+            int left = std::max(rowRuns_[run].xStart - 1, 0);
+            int right = std::min(rowRuns_[run].xEnd, width_ - 1);
+            for (int x = left; x <= right; x++) {
+                if (boundary_[x] >= 0) {
+                    unite(parent_, oldCount + run, boundary_[x]);
+                }
+            }
+        }
+
+        // Run lists past the live count are spares that keep their capacity for later rows
+        newLabel_.assign(oldCount + runCount, -1);
+        int nextCount = 0;
+        for (int run = 0; run < runCount; run++) {
+            int root = findRoot(parent_, oldCount + run);
+            if (newLabel_[root] < 0) {
+                newLabel_[root] = nextCount++;
+                if (static_cast<int>(nextComponents_.size()) < nextCount) {
+                    nextComponents_.emplace_back();
+                }
+                nextComponents_[newLabel_[root]].clear();
+            }
+            nextComponents_[newLabel_[root]].push_back(rowRuns_[run]);
+        }
+        for (int component = 0; component < oldCount; component++) {
+            std::vector<EdgeRun>& runs = components_[component];
+            int label = runs.empty() ? -1 : newLabel_[findRoot(parent_, component)];
+            if (label < 0) {
+                // Closed without meeting an edge: its pixels stay non-edges
+                continue;
+            }
+            std::vector<EdgeRun>& target = nextComponents_[label];
+            if (target.size() < runs.size()) {
+                target.swap(runs);
+            }
+            target.insert(target.end(), runs.begin(), runs.end());
+        }
+
+        std::fill(boundary_.begin(), boundary_.end(), -1);
+        for (int run = 0; run < runCount; run++) {
+            int label = newLabel_[findRoot(parent_, oldCount + run)];
+            std::fill(boundary_.begin() + rowRuns_[run].xStart, boundary_.begin() + rowRuns_[run].xEnd, label);
+        }
+        components_.swap(nextComponents_);
+        componentCount_ = nextCount;
+        windowTop_++;
+    }
+
+    bool applyCannyStreaming(const cv::Mat& inputMat, cv::Mat& outputMat,
+                             double lowThreshold, double highThreshold, int kernelSize) {
+        TRACE_SCOPE("streamingCanny");
+        try {
+            if (inputMat.empty()) {
+                LOGE("Input matrix is empty");
+                return false;
+            }
+            if (inputMat.depth() != CV_8U) {
+                LOGE("Streaming Canny needs 8-bit input, got depth %d", inputMat.depth());
+                return false;
+            }
+
+            outputMat.create(inputMat.rows, inputMat.cols, CV_8UC1);
+            size_t rowBytes = static_cast<size_t>(inputMat.cols);
+            StreamingCanny canny;
+            bool started = canny.begin(inputMat.cols, inputMat.rows, inputMat.channels(),
+                                       lowThreshold, highThreshold, kernelSize,
+                                       [&](int y, const uint8_t* edges) {
+                                           std::memcpy(outputMat.ptr<uint8_t>(y), edges, rowBytes);
+                                       });
+            if (!started) {
+                return false;
+            }
+            for (int y = 0; y < inputMat.rows; y++) {
+                if (!canny.pushRow(inputMat.ptr<uint8_t>(y))) {
+                    return false;
+                }
+            }
+            return canny.finish([&](int y, int xStart, int xEnd) {
+                uint8_t* row = outputMat.ptr<uint8_t>(y);
+                std::fill(row + xStart, row + xEnd, 255);
+            });
+
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in applyCannyStreaming: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            LOGE("Standard exception in applyCannyStreaming: %s", e.what());
+            return false;
+        }
+    }
+
+} // namespace EdgeDetection
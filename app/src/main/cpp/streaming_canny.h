@@ -0,0 +1,163 @@
+#ifndef STREAMING_CANNY_H
+#define STREAMING_CANNY_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Default rows of suppressed edges held back for hysteresis before they are emitted
+ */
+    constexpr int kHysteresisWindowRows = 16;
+
+/**
+ * @brief Receives one finished row of edges (width bytes, 0/255); valid only during the call
+ */
+    using EdgeRowSink = std::function<void(int y, const uint8_t* edges)>;
+
+/**
+ * @brief Receives pixels [xStart, xEnd) of row y that turned out to be edges after the row was emitted
+ */
+    using LateEdgeSink = std::function<void(int y, int xStart, int xEnd)>;
+
+/**
+ * @brief Canny that consumes an image row by row with working memory proportional to its width
+ *
+ * Each stage keeps only the rows it needs in circular line buffers: the
+ * kernel height of horizontally blurred rows, three blurred rows for Sobel
+ * and three gradient rows for non-maximum suppression. Hysteresis runs over
+ * a window of the latest suppressed rows; a row is emitted once it leaves the
+ * window. Weak pixels that leave unresolved are remembered per connected
+ * component, and the components still touching the window are tracked across
+ * the rows above it, so a chain that only meets a strong pixel further down
+ * is still found. Those pixels are reported by finish() as a fix-up pass, which
+ * makes the combined output exactly the hysteresis of the whole image.
+ *
+ * The blur is the full sampled Gaussian of blurSigma(kernelSize) at every
+ * kernel size, with taps rounded to Q8 and the result rounded to 8 bits as in
+ * OpenCV's 8-bit GaussianBlur (reflected border); a replicated-border 3x3
+ * Sobel, suppression and thresholds then follow cv::Canny. That is not how
+ * applyCanny gets its gradients: it uses the unrounded fused
+ * derivative-of-Gaussian up to kernel 7 and the recursive or box-cascade
+ * approximations above (see blurBackend). Gradients therefore differ by a few
+ * levels, and weak chains near a threshold come and go between the two; with
+ * large kernels, whose blurred edges sit close to the thresholds, whole
+ * outlines can. Strong edges agree. Not thread safe.
+ */
+    class StreamingCanny {
+    public:
+        StreamingCanny();
+
+        StreamingCanny(const StreamingCanny&) = delete;
+        StreamingCanny& operator=(const StreamingCanny&) = delete;
+
+        /**
+         * @brief Start an image; sizes every line buffer
+         * @param width Image width in pixels
+         * @param height Image height in rows
+         * @param channels 4 (RGBA), 3 (BGR) or 1 (grayscale)
+         * @param lowThreshold Lower threshold for edge detection
+         * @param highThreshold Upper threshold for edge detection
+         * @param kernelSize Gaussian blur kernel size (odd)
+         * @param sink Receives each edge row as soon as it is final
+         * @param windowRows Hysteresis window height, at least 2
+         * @return true if successful, false otherwise
+         */
+        bool begin(int width, int height, int channels, double lowThreshold, double highThreshold,
+                   int kernelSize, EdgeRowSink sink, int windowRows = kHysteresisWindowRows);
+
+        /**
+         * @brief Feed the next input row; may emit earlier rows through the sink
+         * @param row width * channels bytes, only read during the call
+         * @return true if successful, false otherwise
+         */
+        bool pushRow(const uint8_t* row);
+
+        /**
+         * @brief Emit the remaining rows, then every late edge in row order
+         * @return true if successful, false if rows are missing or a call failed
+         */
+        bool finish(const LateEdgeSink& lateSink);
+
+        /**
+         * @brief Bytes held by the line buffers and hysteresis state
+         */
+        size_t workingSetBytes() const;
+
+    private:
+        struct EdgeRun {
+            int y;
+            int xStart;
+            int xEnd;
+        };
+
+        void horizontalBlur(int row);
+        void verticalBlur(int row);
+        void computeGradients(int row);
+        void suppressRow(int row);
+        void insertRow(int row);
+        void exitRow();
+        void flood(int bottomRow);
+        void promoteNeighbours(int slot, int left, int right);
+        void promoteComponent(int component);
+
+        int width_;
+        int height_;
+        int channels_;
+        int low_;
+        int high_;
+        int radius_;
+        int windowRows_;
+        EdgeRowSink sink_;
+
+        int inputRows_;         // Rows pushed so far
+        int blurredRows_;       // Rows blurred so far
+        int gradientRows_;      // Rows with gradients so far
+        int suppressedRows_;    // Rows suppressed (and entered into the window) so far
+        int windowTop_;         // First row still in the hysteresis window
+
+        std::vector<uint16_t> taps_;        // Q8 Gaussian taps summing to 256
+        cv::Mat grayRow_;
+        std::vector<uint16_t> horizontal_;  // Ring of kernel-size horizontally blurred rows, Q8
+        std::vector<uint32_t> accumulator_; // Vertical blur sums, Q16
+        std::vector<uint8_t> blurred_;      // Ring of 3 blurred rows
+        std::vector<short> dx_;             // Ring of 3 gradient rows
+        std::vector<short> dy_;
+        std::vector<uint16_t> magnitude_;
+        std::vector<uint16_t> suppressed_;  // Current suppressed row
+        std::vector<uint8_t> classes_;      // Ring of window rows: none, weak or edge per pixel
+        std::vector<uint8_t> edgeRow_;      // Row being emitted
+        std::vector<int> stack_;            // Ring indices of edges whose neighbours are unvisited
+
+        // Weak pixels that left the window unresolved, by connected component.
+        // boundary_ labels the last emitted row with those components; a
+        // component no longer on it is closed and dropped as non-edge. Only
+        // the first componentCount_ run lists are live; the rest are reused.
+        std::vector<int> boundary_;
+        int componentCount_;
+        std::vector<std::vector<EdgeRun>> components_;
+        std::vector<std::vector<EdgeRun>> nextComponents_;
+        std::vector<EdgeRun> rowRuns_;
+        std::vector<int> parent_;
+        std::vector<int> newLabel_;
+        std::vector<EdgeRun> lateRuns_;
+    };
+
+/**
+ * @brief Canny edge detection of a whole image through StreamingCanny
+ * @param inputMat Input image (RGBA, BGR or grayscale)
+ * @param outputMat Output edge image (CV_8UC1, 0/255)
+ * @param lowThreshold Lower threshold for edge detection
+ * @param highThreshold Upper threshold for edge detection
+ * @param kernelSize Gaussian blur kernel size
+ * @return true if successful, false otherwise
+ */
+    bool applyCannyStreaming(const cv::Mat& inputMat, cv::Mat& outputMat,
+                             double lowThreshold, double highThreshold, int kernelSize);
+
+} // namespace EdgeDetection
+
+#endif // STREAMING_CANNY_H
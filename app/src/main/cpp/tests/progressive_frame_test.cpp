@@ -0,0 +1,166 @@
+//
+// ProgressiveFrame: band hand-off order, generation monotonicity and pinning under a live producer
+//
+#include "progressive_frame.h"
+#include "test_check.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace EdgeDetection;
+
+namespace {
+
+    // Frames the producer pushes through in the stress run
+    const int kStressFrames = 20000;
+
+    // Every pixel of a frame holds its generation, so a band's rows tell which frame wrote them
+    void fillRows(uint8_t* frame, int width, int rowStart, int rowEnd, uint32_t generation) {
+        uint32_t* pixels = reinterpret_cast<uint32_t*>(frame) + static_cast<size_t>(rowStart) * width;
+        size_t count = static_cast<size_t>(rowEnd - rowStart) * width;
+        for (size_t i = 0; i < count; i++) {
+            pixels[i] = generation;
+        }
+    }
+
+    // Generation stamped on every pixel of the band, or 0 if its pixels disagree
+    uint32_t bandGeneration(const FrameBand& band) {
+        size_t count = static_cast<size_t>(band.rowEnd - band.rowStart) * band.width;
+        uint32_t first;
+        memcpy(&first, band.data, sizeof(first));
+        for (size_t i = 1; i < count; i++) {
+            uint32_t value;
+            memcpy(&value, band.data + i * 4, sizeof(value));
+            if (value != first) {
+                return 0;
+            }
+        }
+        return first;
+    }
+
+    void produceFrame(ProgressiveFrame& frame, uint32_t generation, int width, int height, int bands,
+                      int bandsToFinish, bool success) {
+        uint8_t* data = frame.beginFrame(width, height, bands);
+        for (int b = 0; b < bandsToFinish; b++) {
+            fillRows(data, width, height * b / bands, height * (b + 1) / bands, generation);
+            frame.markBandReady(b);
+        }
+        frame.endFrame(success);
+    }
+
+    void testBandOrderSingleThread() {
+        ProgressiveFrame frame;
+        frame.reserve(16, 12);
+        FrameBand band;
+        CHECK(!frame.takeBand(band, 1));
+
+        // Bands come in completion order, before the frame is closed
+        uint8_t* data = frame.beginFrame(16, 12, 4);
+        fillRows(data, 16, 6, 9, 1);
+        frame.markBandReady(2);
+        CHECK(frame.takeBand(band, 10));
+        CHECK(band.rowStart == 6 && band.rowEnd == 9 && band.width == 16 && band.height == 12);
+        CHECK(bandGeneration(band) == 1);
+        frame.releaseBand();
+        CHECK(!frame.takeBand(band, 1));
+        CHECK(!frame.frameTaken());
+        CHECK(frame.bandsTakenEarly() == 1);
+
+        // A newer frame overtakes the rest of the old one
+        fillRows(data, 16, 0, 3, 1);
+        frame.markBandReady(0);
+        frame.endFrame(true);
+        produceFrame(frame, 2, 16, 12, 4, 4, true);
+        int taken = 0;
+        while (frame.takeBand(band, 1)) {
+            CHECK(bandGeneration(band) == 2);
+            frame.releaseBand();
+            taken++;
+        }
+        CHECK(taken == 4);
+        CHECK(frame.frameTaken());
+
+        FrameTimes times;
+        CHECK(frame.frameTimes(times));
+        CHECK(times.processEndNs >= times.processStartNs);
+
+        // A failed frame ends the wait for its missing bands; a repeat ends the wait for a new frame
+        produceFrame(frame, 3, 16, 12, 4, 1, false);
+        CHECK(frame.takeBand(band, 10) && bandGeneration(band) == 3);
+        frame.releaseBand();
+        CHECK(!frame.takeBand(band, 10));
+        CHECK(!frame.frameTaken());
+        frame.repeatFrame();
+        auto start = std::chrono::steady_clock::now();
+        CHECK(!frame.takeBand(band, 1000));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+    }
+
+    void testProducerConsumer() {
+        ProgressiveFrame frame;
+        frame.reserve(64, 48);
+        std::atomic<bool> producing{true};
+
+        std::thread producer([&] {
+            for (uint32_t generation = 1; generation <= kStressFrames; generation++) {
+                // Change the resolution now and then so buffers are resized, not just reused
+                int width = (generation / 1000) % 2 ? 48 : 64;
+                int height = (generation / 1000) % 2 ? 40 : 48;
+                bool fails = generation % 13 == 0;
+                produceFrame(frame, generation, width, height, 8, fails ? 3 : 8, !fails);
+                if (generation % 17 == 0) {
+                    frame.repeatFrame();
+                }
+            }
+            producing.store(false, std::memory_order_release);
+        });
+
+        uint32_t lastGeneration = 0;
+        uint64_t bands = 0;
+        int torn = 0;
+        int older = 0;
+        int rewritten = 0;
+        int badRows = 0;
+        FrameBand band;
+        while (true) {
+            bool running = producing.load(std::memory_order_acquire);
+            if (!frame.takeBand(band, 1)) {
+                if (!running) {
+                    break;
+                }
+                continue;
+            }
+            bands++;
+            badRows += band.rowStart < 0 || band.rowEnd > band.height || band.rowStart >= band.rowEnd;
+
+            uint32_t generation = bandGeneration(band);
+            torn += generation == 0;
+            older += generation < lastGeneration;
+            lastGeneration = std::max(lastGeneration, generation);
+
+            // Hold the pin across a reschedule: the producer must not start rewriting this buffer
+            std::this_thread::yield();
+            rewritten += bandGeneration(band) != generation;
+            frame.releaseBand();
+        }
+        producer.join();
+
+        CHECK(bands > 0);
+        CHECK(bands == frame.bandsTaken());
+        CHECK(torn == 0);
+        CHECK(older == 0);
+        CHECK(rewritten == 0);
+        CHECK(badRows == 0);
+    }
+
+} // namespace
+
+int main() {
+    int failed = 0;
+    failed += RUN_TEST(testBandOrderSingleThread);
+    failed += RUN_TEST(testProducerConsumer);
+    return failed == 0 ? 0 : 1;
+}
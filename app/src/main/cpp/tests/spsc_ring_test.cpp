@@ -0,0 +1,288 @@
+//
+// SpscRing: FIFO order, the overflow policies at capacity and a two-thread stress run
+//
+#include "spsc_ring.h"
+#include "test_check.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace EdgeDetection;
+
+namespace {
+
+    // Values pushed by the stress runs; enough for the two threads to interleave at every slot
+    const int kStressItems = 200000;
+
+    void pushAll(SpscRing<int>& ring, int first, int last, std::vector<bool>* accepted = nullptr) {
+        for (int value = first; value <= last; value++) {
+            int item = value;
+            bool pushed = ring.push(item);
+            if (accepted) {
+                accepted->push_back(pushed);
+            }
+        }
+    }
+
+    std::vector<int> popAll(SpscRing<int>& ring) {
+        std::vector<int> values;
+        int item = 0;
+        while (ring.tryPop(item)) {
+            values.push_back(item);
+        }
+        return values;
+    }
+
+    void testFifoOrder() {
+        SpscRing<int> ring(8, BackpressurePolicy::Block);
+        int item = 0;
+        CHECK(!ring.tryPop(item));
+
+        // Several laps, so the indices wrap the slot array
+        for (int lap = 0; lap < 5; lap++) {
+            pushAll(ring, lap * 10 + 1, lap * 10 + 6);
+            CHECK(ring.size() == 6);
+            CHECK(popAll(ring) == std::vector<int>({lap * 10 + 1, lap * 10 + 2, lap * 10 + 3,
+                                                    lap * 10 + 4, lap * 10 + 5, lap * 10 + 6}));
+            CHECK(ring.size() == 0);
+        }
+
+        RingStats stats = ring.stats();
+        CHECK(stats.pushed == 30);
+        CHECK(stats.popped == 30);
+        CHECK(stats.highWaterMark == 6);
+    }
+
+    void testBlockAtCapacity() {
+        SpscRing<int> ring(4, BackpressurePolicy::Block);
+        pushAll(ring, 1, 4);
+
+        std::atomic<bool> returned{false};
+        std::thread producer([&] {
+            int item = 5;
+            ring.push(item);
+            returned.store(true);
+        });
+
+        // The fifth push must wait for the consumer rather than drop anything
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(!returned.load());
+        CHECK(ring.size() == 4);
+
+        int item = 0;
+        CHECK(ring.pop(item, 1000) && item == 1);
+        producer.join();
+        CHECK(returned.load());
+        CHECK(popAll(ring) == std::vector<int>({2, 3, 4, 5}));
+
+        RingStats stats = ring.stats();
+        CHECK(stats.capacity == 4);
+        CHECK(stats.blockedPushes == 1);
+        CHECK(stats.droppedOldest == 0 && stats.droppedNewest == 0);
+    }
+
+    void testBlockReleasedByClose() {
+        SpscRing<int> ring(2, BackpressurePolicy::Block);
+        pushAll(ring, 1, 2);
+
+        std::atomic<int> result{-1};
+        std::thread producer([&] {
+            int item = 3;
+            result.store(ring.push(item) ? 1 : 0);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.close();
+        producer.join();
+
+        // The blocked push gives up; what was queued before close() still drains
+        CHECK(result.load() == 0);
+        CHECK(popAll(ring) == std::vector<int>({1, 2}));
+        int item = 0;
+        CHECK(!ring.pop(item, 10));
+    }
+
+    void testDropOldestAtCapacity() {
+        SpscRing<int> ring(4, BackpressurePolicy::DropOldest);
+        std::vector<bool> accepted;
+        pushAll(ring, 1, 7, &accepted);
+
+        CHECK(accepted == std::vector<bool>(7, true));
+        CHECK(ring.size() == 4);
+        CHECK(popAll(ring) == std::vector<int>({4, 5, 6, 7}));
+
+        RingStats stats = ring.stats();
+        CHECK(stats.capacity == 4);
+        CHECK(stats.pushed == 7);
+        CHECK(stats.popped == 4);
+        CHECK(stats.droppedOldest == 3);
+        CHECK(stats.droppedNewest == 0);
+        CHECK(stats.highWaterMark == 4);
+    }
+
+    void testDropNewestAtCapacity() {
+        SpscRing<int> ring(4, BackpressurePolicy::DropNewest);
+        std::vector<bool> accepted;
+        pushAll(ring, 1, 7, &accepted);
+
+        CHECK(accepted == std::vector<bool>({true, true, true, true, false, false, false}));
+        CHECK(popAll(ring) == std::vector<int>({1, 2, 3, 4}));
+
+        // Room again once the consumer has caught up
+        pushAll(ring, 8, 8, &accepted);
+        CHECK(accepted.back());
+        CHECK(popAll(ring) == std::vector<int>({8}));
+
+        RingStats stats = ring.stats();
+        CHECK(stats.pushed == 5);
+        CHECK(stats.droppedNewest == 3);
+        CHECK(stats.droppedOldest == 0);
+    }
+
+    void testGrowAtCapacity() {
+        SpscRing<int> ring(2, BackpressurePolicy::Grow, 8);
+        std::vector<bool> accepted;
+        pushAll(ring, 1, 8, &accepted);
+
+        // 2 -> 4 -> 8 without dropping or blocking
+        CHECK(accepted == std::vector<bool>(8, true));
+        RingStats stats = ring.stats();
+        CHECK(stats.capacity == 8);
+        CHECK(stats.growEvents == 2);
+        CHECK(stats.blockedPushes == 0);
+
+        // At the cap Grow waits like Block
+        std::atomic<bool> returned{false};
+        std::thread producer([&] {
+            int item = 9;
+            ring.push(item);
+            returned.store(true);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(!returned.load());
+
+        int item = 0;
+        CHECK(ring.pop(item, 1000) && item == 1);
+        producer.join();
+        CHECK(popAll(ring) == std::vector<int>({2, 3, 4, 5, 6, 7, 8, 9}));
+
+        stats = ring.stats();
+        CHECK(stats.capacity == 8);
+        CHECK(stats.growEvents == 2);
+        CHECK(stats.blockedPushes == 1);
+    }
+
+    void testGrowAcrossWrap() {
+        // Physical slot array of 8; start the indices at 6 so the queued items straddle the wrap
+        SpscRing<int> ring(2, BackpressurePolicy::Grow, 8);
+        for (int lap = 0; lap < 3; lap++) {
+            pushAll(ring, 100, 101);
+            CHECK(popAll(ring) == std::vector<int>({100, 101}));
+        }
+        CHECK(ring.stats().capacity == 2);
+
+        std::vector<bool> accepted;
+        pushAll(ring, 1, 8, &accepted);
+        CHECK(accepted == std::vector<bool>(8, true));
+        CHECK(ring.stats().capacity == 8);
+        CHECK(popAll(ring) == std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8}));
+
+        // Interleave after growing: the slots keep their sequence numbers across the wrap
+        for (int value = 10; value < 40; value += 3) {
+            pushAll(ring, value, value + 2);
+            CHECK(popAll(ring) == std::vector<int>({value, value + 1, value + 2}));
+        }
+    }
+
+    void testStressExactlyOnce() {
+        SpscRing<int> ring(16, BackpressurePolicy::Block);
+        std::vector<int> seen(kStressItems, 0);
+        bool ordered = true;
+
+        std::thread consumer([&] {
+            int expected = 0;
+            int item = -1;
+            while (ring.pop(item, 5000)) {
+                if (item < 0 || item >= kStressItems) {
+                    ordered = false;
+                    continue;
+                }
+                ordered = ordered && item == expected;
+                seen[item]++;
+                expected = item + 1;
+            }
+        });
+
+        for (int value = 0; value < kStressItems; value++) {
+            int item = value;
+            CHECK(ring.push(item));
+        }
+        ring.close();
+        consumer.join();
+
+        bool exactlyOnce = true;
+        for (int count : seen) {
+            exactlyOnce = exactlyOnce && count == 1;
+        }
+        CHECK(exactlyOnce);
+        CHECK(ordered);
+        CHECK(ring.stats().pushed == static_cast<uint64_t>(kStressItems));
+        CHECK(ring.stats().popped == static_cast<uint64_t>(kStressItems));
+    }
+
+    void testStressDropOldest() {
+        // The producer's eviction races the consumer's pop for the head slot
+        SpscRing<int> ring(4, BackpressurePolicy::DropOldest);
+        std::vector<int> seen(kStressItems, 0);
+        bool ordered = true;
+
+        std::thread consumer([&] {
+            int last = -1;
+            int item = -1;
+            while (ring.pop(item, 5000)) {
+                if (item < 0 || item >= kStressItems) {
+                    ordered = false;
+                    continue;
+                }
+                ordered = ordered && item > last;
+                seen[item]++;
+                last = item;
+            }
+        });
+
+        for (int value = 0; value < kStressItems; value++) {
+            int item = value;
+            CHECK(ring.push(item));
+        }
+        ring.close();
+        consumer.join();
+
+        uint64_t received = 0;
+        bool atMostOnce = true;
+        for (int count : seen) {
+            atMostOnce = atMostOnce && count <= 1;
+            received += count;
+        }
+        RingStats stats = ring.stats();
+        CHECK(atMostOnce);
+        CHECK(ordered);
+        CHECK(seen[kStressItems - 1] == 1);
+        CHECK(received == stats.popped);
+        CHECK(stats.popped + stats.droppedOldest == static_cast<uint64_t>(kStressItems));
+    }
+
+} // namespace
+
+int main() {
+    int failed = 0;
+    failed += RUN_TEST(testFifoOrder);
+    failed += RUN_TEST(testBlockAtCapacity);
+    failed += RUN_TEST(testBlockReleasedByClose);
+    failed += RUN_TEST(testDropOldestAtCapacity);
+    failed += RUN_TEST(testDropNewestAtCapacity);
+    failed += RUN_TEST(testGrowAtCapacity);
+    failed += RUN_TEST(testGrowAcrossWrap);
+    failed += RUN_TEST(testStressExactlyOnce);
+    failed += RUN_TEST(testStressDropOldest);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cstdio>
+
+//
+// Minimal assertion helpers for the host unit tests: a failed CHECK prints the
+// condition and location and counts the failure; a test binary exits non-zero
+// if any check failed, which is what ctest looks at
+//
+
+namespace EdgeDetection {
+namespace Test {
+
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void fail(const char* condition, const char* file, int line) {
+        std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, condition);
+        failures()++;
+    }
+
+    inline int run(const char* name, void (*test)()) {
+        int before = failures();
+        test();
+        std::fprintf(stderr, "%s %s\n", failures() == before ? "[ OK   ]" : "[ FAIL ]", name);
+        return failures() == before ? 0 : 1;
+    }
+
+} // namespace Test
+} // namespace EdgeDetection
+
+#define CHECK(condition) \
+    ((condition) ? (void) 0 : ::EdgeDetection::Test::fail(#condition, __FILE__, __LINE__))
+
+#define RUN_TEST(test) ::EdgeDetection::Test::run(#test, test)
+
+#endif // TEST_CHECK_H
@@ -0,0 +1,162 @@
+//
+// applyCannyTiled against whole-image applyCanny on images spanning several tiles
+//
+#include "tiled_canny.h"
+#include "blur_filters.h"
+#include "image_processor.h"
+#include "worker_pool.h"
+#include "test_check.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+
+using namespace EdgeDetection;
+
+namespace {
+
+    // Tile size of the comparisons: small, so the test images span a grid of tiles
+    const int kTestTileSize = 64;
+
+    // Share of edge pixels the recursive blur's truncated support may change
+    const double kMaxRecursiveMismatch = 0.005;
+
+    struct Thresholds {
+        double low;
+        double high;
+    };
+
+/**
+ * @brief Grayscale test image: blocks of differing contrast, low-contrast rings and noise
+ *
+ * The rings are long weak chains that cross many tile borders and only reach
+ * a strong pixel where they cut through a block edge, so hysteresis has to
+ * follow them from tile to tile.
+ */
+    cv::Mat makeTestImage(int width, int height, unsigned seed) {
+        cv::Mat image(height, width, CV_8UC1);
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> noise(-8, 8);
+        for (int y = 0; y < height; y++) {
+            uint8_t* row = image.ptr<uint8_t>(y);
+            for (int x = 0; x < width; x++) {
+                int value = ((x / 45 + y / 37) & 1) ? 150 : 70;
+                int dx = x - width / 2;
+                int dy = y - height / 2;
+                int ring = static_cast<int>(std::sqrt(static_cast<double>(dx * dx + dy * dy))) / 24;
+                value += (ring & 1) ? 18 : 0;
+                row[x] = static_cast<uint8_t>(std::min(255, std::max(0, value + noise(random))));
+            }
+        }
+        return image;
+    }
+
+/**
+ * @brief Edges of applyCannyTiled, reassembled into one image
+ */
+    bool runTiled(const cv::Mat& image, double low, double high, int kernel, WorkerPool* pool, cv::Mat& edges) {
+        edges.create(image.rows, image.cols, CV_8UC1);
+        std::mutex sinkMutex;
+        int tiles = 0;
+        bool ok = applyCannyTiled(image, low, high, kernel, [&](const cv::Rect& tile, const cv::Mat& tileEdges) {
+            std::lock_guard<std::mutex> lock(sinkMutex);
+            tiles++;
+            for (int y = 0; y < tile.height; y++) {
+                std::memcpy(edges.ptr<uint8_t>(tile.y + y) + tile.x, tileEdges.ptr<uint8_t>(y), tile.width);
+            }
+        }, pool, kTestTileSize);
+
+        int tilesX = (image.cols + kTestTileSize - 1) / kTestTileSize;
+        int tilesY = (image.rows + kTestTileSize - 1) / kTestTileSize;
+        return ok && tiles == tilesX * tilesY;
+    }
+
+    void countDifferences(const cv::Mat& expected, const cv::Mat& actual, int& edgePixels, int& differing) {
+        edgePixels = 0;
+        differing = 0;
+        for (int y = 0; y < expected.rows; y++) {
+            const uint8_t* expectedRow = expected.ptr<uint8_t>(y);
+            const uint8_t* actualRow = actual.ptr<uint8_t>(y);
+            for (int x = 0; x < expected.cols; x++) {
+                edgePixels += expectedRow[x] != 0;
+                differing += (expectedRow[x] != 0) != (actualRow[x] != 0);
+            }
+        }
+    }
+
+    void compareWithWholeImage(int kernel, bool exact) {
+        // Sizes that are not multiples of the tile size leave partial tiles on the right and bottom
+        const cv::Size sizes[] = {cv::Size(333, 251), cv::Size(256, 192)};
+        const Thresholds thresholds[] = {{30.0, 90.0}, {10.0, 40.0}};
+        WorkerPool pool(3);
+
+        for (const cv::Size& size : sizes) {
+            cv::Mat image = makeTestImage(size.width, size.height, 5u + kernel);
+            for (const Thresholds& pair : thresholds) {
+                Workspace workspace;
+                cv::Mat expected;
+                CHECK(applyCanny(image, expected, pair.low, pair.high, kernel, workspace));
+
+                for (WorkerPool* tilePool : {static_cast<WorkerPool*>(nullptr), &pool}) {
+                    cv::Mat tiled;
+                    CHECK(runTiled(image, pair.low, pair.high, kernel, tilePool, tiled));
+
+                    int edgePixels = 0;
+                    int differing = 0;
+                    countDifferences(expected, tiled, edgePixels, differing);
+                    CHECK(edgePixels > 0);
+                    if (exact) {
+                        CHECK(differing == 0);
+                    } else {
+                        CHECK(differing <= kMaxRecursiveMismatch * edgePixels);
+                    }
+                    if (differing != 0) {
+                        fprintf(stderr, "  %dx%d kernel %d thresholds %.0f/%.0f %s: %d of %d edge pixels differ\n",
+                                size.width, size.height, kernel, pair.low, pair.high,
+                                tilePool ? "pool" : "serial", differing, edgePixels);
+                    }
+                }
+            }
+        }
+    }
+
+    void testExactBlurMatchesWholeImage() {
+        for (int kernel : {3, 5, 7}) {
+            CHECK(blurBackend(kernel) == BlurBackend::Exact);
+            compareWithWholeImage(kernel, true);
+        }
+    }
+
+    void testBoxCascadeMatchesWholeImage() {
+        for (int kernel : {13, 21}) {
+            CHECK(blurBackend(kernel) == BlurBackend::BoxCascade);
+            compareWithWholeImage(kernel, true);
+        }
+    }
+
+    void testRecursiveBlurIsClose() {
+        for (int kernel : {9, 11}) {
+            CHECK(blurBackend(kernel) == BlurBackend::Recursive);
+            compareWithWholeImage(kernel, false);
+        }
+    }
+
+    void testInvalidInput() {
+        auto sink = [](const cv::Rect&, const cv::Mat&) {};
+        CHECK(!applyCannyTiled(cv::Mat(), 30.0, 90.0, 3, sink));
+        CHECK(!applyCannyTiled(makeTestImage(64, 64, 1), 30.0, 90.0, 3, sink, nullptr, 8));
+    }
+
+} // namespace
+
+int main() {
+    int failed = 0;
+    failed += RUN_TEST(testExactBlurMatchesWholeImage);
+    failed += RUN_TEST(testBoxCascadeMatchesWholeImage);
+    failed += RUN_TEST(testRecursiveBlurIsClose);
+    failed += RUN_TEST(testInvalidInput);
+    return failed == 0 ? 0 : 1;
+}
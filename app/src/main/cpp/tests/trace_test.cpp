@@ -0,0 +1,82 @@
+//
+// Trace: ring ownership across thread lifetimes and the Chrome JSON export
+//
+#include "trace.h"
+#include "test_check.h"
+#include <string>
+#include <thread>
+
+using namespace EdgeDetection;
+
+namespace {
+
+    // Threads started one after another, as FrameScheduler restarts do
+    const int kRestarts = 50;
+
+    int countOf(const std::string& text, const std::string& pattern) {
+        int count = 0;
+        for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1)) {
+            count++;
+        }
+        return count;
+    }
+
+    void testNamingDoesNotTakeRing() {
+        Trace::setEnabled(false);
+        Trace::clear();
+        std::thread named([] {
+            Trace::setThreadName("named-idle");
+            Trace::record("dropped", 1, 10, 20);
+        });
+        named.join();
+
+        std::string json = Trace::toChromeJson();
+        CHECK(json.find("named-idle") == std::string::npos);
+        CHECK(json.find("dropped") == std::string::npos);
+    }
+
+    void testNameAppliesAtFirstEvent() {
+        Trace::setEnabled(true);
+        Trace::clear();
+        std::thread worker([] {
+            Trace::setThreadName("named-early");
+            Trace::record("stage", 7, 1000, 3000);
+        });
+        worker.join();
+        Trace::setEnabled(false);
+
+        std::string json = Trace::toChromeJson();
+        CHECK(countOf(json, "named-early") == 1);
+        CHECK(countOf(json, "\"name\":\"stage\"") == 1);
+        CHECK(json.find("\"frame\":7") != std::string::npos);
+    }
+
+    void testRestartsReuseRings() {
+        Trace::setEnabled(true);
+        Trace::clear();
+        for (int i = 0; i < kRestarts; i++) {
+            std::thread worker([i] {
+                std::string name = "restart-" + std::to_string(i);
+                Trace::setThreadName(name.c_str());
+                Trace::record("restart-stage", i, 1000, 2000);
+            });
+            worker.join();
+        }
+        Trace::setEnabled(false);
+
+        // Each thread took over its predecessor's ring, so only the last one's events remain
+        std::string json = Trace::toChromeJson();
+        CHECK(countOf(json, "restart-stage") == 1);
+        CHECK(json.find("\"restart-" + std::to_string(kRestarts - 1) + "\"") != std::string::npos);
+        CHECK(json.find("\"restart-0\"") == std::string::npos);
+    }
+
+} // namespace
+
+int main() {
+    int failed = 0;
+    failed += RUN_TEST(testNamingDoesNotTakeRing);
+    failed += RUN_TEST(testNameAppliesAtFirstEvent);
+    failed += RUN_TEST(testRestartsReuseRings);
+    return failed == 0 ? 0 : 1;
+}
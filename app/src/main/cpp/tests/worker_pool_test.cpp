@@ -0,0 +1,221 @@
+//
+// WorkStealingDeque races and WorkerPool::parallelFor coverage under real threads
+//
+#include "worker_pool.h"
+#include "work_stealing_deque.h"
+#include "test_check.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace EdgeDetection;
+
+namespace {
+
+    // Rounds of the last-element race; each is one push and one pop racing one steal
+    const int kRaceRounds = 100000;
+
+    // Items pushed while thieves steal; enough to grow a 2-slot ring many times over
+    const int kGrowItems = 200000;
+    const int kThieves = 3;
+
+    void testPopStealLastElement() {
+        WorkStealingDeque<int> deque(2);
+        std::atomic<int> round{-1};
+        std::atomic<int> thiefDone{-1};
+        std::vector<int> stolen(kRaceRounds, -1);
+
+        std::thread thief([&] {
+            for (int r = 0; r < kRaceRounds; r++) {
+                while (round.load(std::memory_order_acquire) != r) {
+                    std::this_thread::yield();
+                }
+                int item = -1;
+                if (deque.steal(item)) {
+                    stolen[r] = item;
+                }
+                thiefDone.store(r, std::memory_order_release);
+            }
+        });
+
+        int bothWon = 0;
+        int noneWon = 0;
+        int wrongValue = 0;
+        for (int r = 0; r < kRaceRounds; r++) {
+            deque.push(r);
+            round.store(r, std::memory_order_release);
+            int item = -1;
+            bool popped = deque.pop(item);
+            while (thiefDone.load(std::memory_order_acquire) != r) {
+                std::this_thread::yield();
+            }
+
+            bool wasStolen = stolen[r] >= 0;
+            bothWon += popped && wasStolen;
+            noneWon += !popped && !wasStolen;
+            wrongValue += (popped && item != r) || (wasStolen && stolen[r] != r);
+        }
+        thief.join();
+
+        // Exactly one side gets the last item, and the deque is empty afterwards
+        CHECK(bothWon == 0);
+        CHECK(noneWon == 0);
+        CHECK(wrongValue == 0);
+        CHECK(deque.size() == 0);
+        int item = -1;
+        CHECK(!deque.pop(item));
+        CHECK(!deque.steal(item));
+    }
+
+    void testGrowWhileStealing() {
+        WorkStealingDeque<int> deque(2);
+        std::vector<std::atomic<int>> taken(kGrowItems);
+        for (std::atomic<int>& count : taken) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        std::atomic<bool> producing{true};
+        std::atomic<int> outOfRange{0};
+
+        auto record = [&](int item) {
+            if (item < 0 || item >= kGrowItems) {
+                outOfRange.fetch_add(1);
+            } else {
+                taken[item].fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector<std::thread> thieves;
+        for (int t = 0; t < kThieves; t++) {
+            thieves.emplace_back([&] {
+                int item = -1;
+                while (producing.load(std::memory_order_acquire)) {
+                    if (deque.steal(item)) {
+                        record(item);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                while (deque.steal(item)) {
+                    record(item);
+                }
+            });
+        }
+
+        // Bursts of pushes grow the ring while thieves read it; the owner pops now and then
+        int item = -1;
+        for (int value = 0; value < kGrowItems; value++) {
+            deque.push(value);
+            if (value % 7 == 0 && deque.pop(item)) {
+                record(item);
+            }
+        }
+        while (deque.pop(item)) {
+            record(item);
+        }
+        producing.store(false, std::memory_order_release);
+        for (std::thread& thief : thieves) {
+            thief.join();
+        }
+
+        bool exactlyOnce = true;
+        for (std::atomic<int>& count : taken) {
+            exactlyOnce = exactlyOnce && count.load() == 1;
+        }
+        CHECK(exactlyOnce);
+        CHECK(outOfRange.load() == 0);
+        CHECK(deque.size() == 0);
+    }
+
+    void testParallelForExactlyOnce() {
+        WorkerPool pool(4);
+        const int counts[] = {1, 2, 3, 4, 5, 17, 64, 1000, 10007};
+
+        for (int count : counts) {
+            for (int repeat = 0; repeat < 20; repeat++) {
+                std::vector<std::atomic<int>> runs(count);
+                for (std::atomic<int>& run : runs) {
+                    run.store(0, std::memory_order_relaxed);
+                }
+                pool.parallelFor(count, [&](int i) {
+                    runs[i].fetch_add(1, std::memory_order_relaxed);
+                });
+
+                bool exactlyOnce = true;
+                for (std::atomic<int>& run : runs) {
+                    exactlyOnce = exactlyOnce && run.load() == 1;
+                }
+                CHECK(exactlyOnce);
+            }
+        }
+
+        PoolStats stats = pool.stats();
+        CHECK(stats.workers == 4);
+        CHECK(stats.tasksExecuted > 0);
+    }
+
+    void testNestedParallelFor() {
+        // Tasks that wait on their own batches run queued work instead of blocking the pool
+        WorkerPool pool(3);
+        const int outer = 16;
+        const int inner = 64;
+        std::vector<std::atomic<int>> runs(outer * inner);
+        for (std::atomic<int>& run : runs) {
+            run.store(0, std::memory_order_relaxed);
+        }
+
+        pool.parallelFor(outer, [&](int i) {
+            pool.parallelFor(inner, [&](int j) {
+                runs[i * inner + j].fetch_add(1, std::memory_order_relaxed);
+            });
+        });
+
+        bool exactlyOnce = true;
+        for (std::atomic<int>& run : runs) {
+            exactlyOnce = exactlyOnce && run.load() == 1;
+        }
+        CHECK(exactlyOnce);
+    }
+
+    void testConcurrentSubmitters() {
+        // Several outside threads share the injection queue
+        WorkerPool pool(4);
+        const int submitters = 4;
+        const int perSubmitter = 5000;
+        std::vector<std::atomic<int>> runs(submitters * perSubmitter);
+        for (std::atomic<int>& run : runs) {
+            run.store(0, std::memory_order_relaxed);
+        }
+
+        std::vector<std::thread> threads;
+        for (int s = 0; s < submitters; s++) {
+            threads.emplace_back([&, s] {
+                for (int batch = 0; batch < perSubmitter; batch += 100) {
+                    pool.parallelFor(100, [&](int i) {
+                        runs[s * perSubmitter + batch + i].fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        bool exactlyOnce = true;
+        for (std::atomic<int>& run : runs) {
+            exactlyOnce = exactlyOnce && run.load() == 1;
+        }
+        CHECK(exactlyOnce);
+    }
+
+} // namespace
+
+int main() {
+    int failed = 0;
+    failed += RUN_TEST(testPopStealLastElement);
+    failed += RUN_TEST(testGrowWhileStealing);
+    failed += RUN_TEST(testParallelForExactlyOnce);
+    failed += RUN_TEST(testNestedParallelFor);
+    failed += RUN_TEST(testConcurrentSubmitters);
+    return failed == 0 ? 0 : 1;
+}
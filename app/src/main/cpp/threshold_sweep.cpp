@@ -0,0 +1,295 @@
+//
+// Canny threshold sweeps sharing one gradient and non-maximum suppression pass
+//
+#include "threshold_sweep.h"
+#include "log.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <tuple>
+#include <utility>
+
+#define LOG_TAG "ThresholdSweep"
+
+namespace EdgeDetection {
+
+    // Most pairs one bit-sliced flood fill carries
+    static constexpr int kMaxSlicedPairs = 64;
+
+    // Rows per non-maximum suppression task
+    static constexpr int kSuppressBandRows = 64;
+
+/**
+ * @brief Hysteresis scratch of one lane, reused across the groups it runs
+ */
+    template<typename Word>
+    struct SweepScratch {
+        std::vector<Word> weak;     // Bits of pairs whose low threshold the pixel passes
+        std::vector<Word> edges;    // Bits of pairs for which the pixel is a final edge
+        std::vector<int> stack;
+    };
+
+    struct ThresholdSweep::Scratch {
+        std::vector<int> lows;
+        std::vector<int> highs;
+
+        // Lanes of each word width, grown to the pool size on first use
+        std::tuple<std::vector<SweepScratch<uint8_t>>, std::vector<SweepScratch<uint16_t>>,
+                   std::vector<SweepScratch<uint32_t>>, std::vector<SweepScratch<uint64_t>>> lanes;
+
+        template<typename Word>
+        std::vector<SweepScratch<Word>>& lanesOf() {
+            return std::get<std::vector<SweepScratch<Word>>>(lanes);
+        }
+    };
+
+/**
+ * @brief Hysteresis for a group of pairs at once, one bit per pair in a Word per pixel
+ *
+ * Maps are padded by one pixel so the 8-neighbour walk needs no bounds checks.
+ * A pixel is pushed only when it gains a bit, so each (pixel, pair) is visited
+ * once however many pairs share the pass.
+ */
+    template<typename Word>
+    static void sweepGroup(const cv::Mat& suppressed, const int* lows, const int* highs, int count,
+                           int firstPair, SweepScratch<Word>& scratch, SweepOutput& output) {
+        int width = suppressed.cols;
+        int height = suppressed.rows;
+        int stride = width + 2;
+        size_t cells = static_cast<size_t>(stride) * (height + 2);
+
+        scratch.weak.assign(cells, 0);
+        scratch.edges.assign(cells, 0);
+        scratch.stack.clear();
+        Word* weak = scratch.weak.data();
+        Word* edges = scratch.edges.data();
+
+        int minLow = *std::min_element(lows, lows + count);
+        for (int y = 0; y < height; y++) {
+            const uint16_t* row = suppressed.ptr<uint16_t>(y);
+            int base = (y + 1) * stride + 1;
+            for (int x = 0; x < width; x++) {
+                int m = row[x];
+                if (m <= minLow) {
+                    continue;
+                }
+                Word weakBits = 0;
+                Word strongBits = 0;
+                for (int k = 0; k < count; k++) {
+                    weakBits |= static_cast<Word>(m > lows[k]) << k;
+                    strongBits |= static_cast<Word>(m > highs[k]) << k;
+                }
+                weak[base + x] = weakBits;
+                if (strongBits) {
+                    edges[base + x] = strongBits;
+                    scratch.stack.push_back(base + x);
+                }
+            }
+        }
+
+        const int offsets[8] = {-stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1};
+        while (!scratch.stack.empty()) {
+            int index = scratch.stack.back();
+            scratch.stack.pop_back();
+            Word bits = edges[index];
+            for (int offset : offsets) {
+                int neighbour = index + offset;
+                Word gained = bits & weak[neighbour] & static_cast<Word>(~edges[neighbour]);
+                if (gained) {
+                    edges[neighbour] |= gained;
+                    scratch.stack.push_back(neighbour);
+                }
+            }
+        }
+
+        for (int k = 0; k < count; k++) {
+            uint64_t edgeCount = 0;
+            for (int y = 0; y < height; y++) {
+                const Word* cell = edges + (y + 1) * stride + 1;
+                uint8_t* packedRow = output.packed.ptr<uint8_t>((firstPair + k) * height + y);
+                for (size_t byte = 0; byte < output.rowBytes; byte++) {
+                    uint8_t value = 0;
+                    int x0 = static_cast<int>(byte * 8);
+                    int x1 = std::min(x0 + 8, width);
+                    for (int x = x0; x < x1; x++) {
+                        value |= static_cast<uint8_t>((cell[x] >> k) & 1) << (7 - (x - x0));
+                    }
+                    packedRow[byte] = value;
+                    edgeCount += static_cast<uint64_t>(__builtin_popcount(value));
+                }
+            }
+            output.edgeCounts[firstPair + k] = edgeCount;
+        }
+    }
+
+/**
+ * @brief Run all groups of a sweep on the pool with Word-wide bit planes
+ * @return false if any lane failed
+ */
+    template<typename Word>
+    static bool sweepGroups(WorkerPool& pool, const cv::Mat& suppressed,
+                            const std::vector<int>& lows, const std::vector<int>& highs,
+                            int groupSize, std::vector<SweepScratch<Word>>& scratch, SweepOutput& output) {
+        int pairCount = static_cast<int>(lows.size());
+        int groupCount = (pairCount + groupSize - 1) / groupSize;
+
+        // Lanes pull groups dynamically and keep their scratch maps between them
+        int lanes = std::min(groupCount, pool.size());
+        if (static_cast<int>(scratch.size()) < lanes) {
+            scratch.resize(lanes);
+        }
+        std::atomic<int> nextGroup(0);
+        std::atomic<bool> failed(false);
+        pool.parallelFor(lanes, [&](int lane) {
+            try {
+                for (int group = nextGroup.fetch_add(1); group < groupCount; group = nextGroup.fetch_add(1)) {
+                    TRACE_SCOPE("sweep.group");
+                    int first = group * groupSize;
+                    int count = std::min(groupSize, pairCount - first);
+                    sweepGroup<Word>(suppressed, lows.data() + first, highs.data() + first, count,
+                                     first, scratch[lane], output);
+                }
+            } catch (const std::exception& e) {
+                LOGE("Exception in threshold sweep lane %d: %s", lane, e.what());
+                failed.store(true, std::memory_order_relaxed);
+            }
+        });
+        return !failed.load(std::memory_order_relaxed);
+    }
+
+    ThresholdSweep::ThresholdSweep(std::shared_ptr<WorkerPool> pool)
+            : pool_(pool ? std::move(pool) : WorkerPool::shared()), scratch_(new Scratch()) {
+    }
+
+    ThresholdSweep::~ThresholdSweep() = default;
+
+    bool ThresholdSweep::setImage(const cv::Mat& inputMat, int blurKernel, uint64_t imageId) {
+        TRACE_SCOPE("sweep.setImage");
+        if (!stages_.updateGradients(inputMat, imageId, blurKernel)) {
+            return false;
+        }
+
+        try {
+            const cv::Mat& dx = stages_.gradientX();
+            const cv::Mat& dy = stages_.gradientY();
+            int height = dx.rows;
+
+            cv::Mat magnitude(height, dx.cols, CV_16UC1);
+            suppressed_.create(height, dx.cols, CV_16UC1);
+
+            int bands = std::max(1, (height + kSuppressBandRows - 1) / kSuppressBandRows);
+            pool_->parallelFor(bands, [&](int band) {
+                int rowStart = band * kSuppressBandRows;
+                gradientMagnitude(dx, dy, magnitude, rowStart, std::min(height, rowStart + kSuppressBandRows));
+            });
+            pool_->parallelFor(bands, [&](int band) {
+                int rowStart = band * kSuppressBandRows;
+                suppressNonMaxima(dx, dy, magnitude, suppressed_, rowStart,
+                                  std::min(height, rowStart + kSuppressBandRows));
+            });
+            return true;
+
+        } catch (const cv::Exception& e) {
+            suppressed_.release();
+            LOGE("OpenCV exception in ThresholdSweep::setImage: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            suppressed_.release();
+            LOGE("Standard exception in ThresholdSweep::setImage: %s", e.what());
+            return false;
+        }
+    }
+
+    bool ThresholdSweep::run(const std::vector<ThresholdPair>& pairs, SweepOutput& output,
+                             SweepMode mode) {
+        TRACE_SCOPE("sweep.run");
+        if (suppressed_.empty()) {
+            LOGE("ThresholdSweep::run called without an image");
+            return false;
+        }
+
+        try {
+            int pairCount = static_cast<int>(pairs.size());
+            int width = suppressed_.cols;
+            int height = suppressed_.rows;
+
+            std::vector<int>& lows = scratch_->lows;
+            std::vector<int>& highs = scratch_->highs;
+            lows.resize(pairCount);
+            highs.resize(pairCount);
+            for (int k = 0; k < pairCount; k++) {
+                cannyThresholds(pairs[k].low, pairs[k].high, lows[k], highs[k]);
+            }
+
+            output.width = width;
+            output.height = height;
+            output.pairCount = pairCount;
+            output.rowBytes = (static_cast<size_t>(width) + 7) / 8;
+            output.packed.create(std::max(1, pairCount * height), static_cast<int>(output.rowBytes), CV_8UC1);
+            output.edgeCounts.assign(pairCount, 0);
+            if (pairCount == 0) {
+                return true;
+            }
+
+            int workers = pool_->size();
+            int groupSize;
+            switch (mode) {
+                case SweepMode::PerPair:
+                    groupSize = 1;
+                    break;
+                case SweepMode::BitSliced:
+                    groupSize = std::min(pairCount, kMaxSlicedPairs);
+                    break;
+                case SweepMode::Auto:
+                default:
+                    // Smallest groups that still give every worker one, for the narrowest words
+                    groupSize = std::min(kMaxSlicedPairs, (pairCount + workers - 1) / workers);
+                    break;
+            }
+
+            // Narrowest word that holds a group: less memory traffic per flood fill step
+            bool success;
+            if (groupSize <= 8) {
+                success = sweepGroups<uint8_t>(*pool_, suppressed_, lows, highs, groupSize,
+                                               scratch_->lanesOf<uint8_t>(), output);
+            } else if (groupSize <= 16) {
+                success = sweepGroups<uint16_t>(*pool_, suppressed_, lows, highs, groupSize,
+                                                scratch_->lanesOf<uint16_t>(), output);
+            } else if (groupSize <= 32) {
+                success = sweepGroups<uint32_t>(*pool_, suppressed_, lows, highs, groupSize,
+                                                scratch_->lanesOf<uint32_t>(), output);
+            } else {
+                success = sweepGroups<uint64_t>(*pool_, suppressed_, lows, highs, groupSize,
+                                                scratch_->lanesOf<uint64_t>(), output);
+            }
+
+            LOGD("Swept %d threshold pairs on %dx%d in groups of %d", pairCount, width, height, groupSize);
+            return success;
+
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in ThresholdSweep::run: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            LOGE("Standard exception in ThresholdSweep::run: %s", e.what());
+            return false;
+        }
+    }
+
+    bool ThresholdSweep::unpack(const SweepOutput& output, int pair, cv::Mat& edgeMat) {
+        if (pair < 0 || pair >= output.pairCount) {
+            LOGE("Sweep pair %d out of range (%d pairs)", pair, output.pairCount);
+            return false;
+        }
+
+        edgeMat.create(output.height, output.width, CV_8UC1);
+        for (int y = 0; y < output.height; y++) {
+            const uint8_t* packedRow = output.packed.ptr<uint8_t>(pair * output.height + y);
+            uint8_t* row = edgeMat.ptr<uint8_t>(y);
+            for (int x = 0; x < output.width; x++) {
+                row[x] = (packedRow[x >> 3] >> (7 - (x & 7))) & 1 ? 255 : 0;
+            }
+        }
+        return true;
+    }
+
+} // namespace EdgeDetection
@@ -0,0 +1,100 @@
+#ifndef THRESHOLD_SWEEP_H
+#define THRESHOLD_SWEEP_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "canny_stages.h"
+#include "worker_pool.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief One (low, high) Canny threshold pair of a sweep
+ */
+    struct ThresholdPair {
+        double low;
+        double high;
+    };
+
+/**
+ * @brief How a sweep runs hysteresis over its threshold pairs
+ */
+    enum class SweepMode {
+        Auto,       // Bit-sliced groups sized so every worker gets one
+        PerPair,    // One pass per pair, pairs in parallel
+        BitSliced   // Up to 64 pairs per pass, one bit plane per pair
+    };
+
+/**
+ * @brief Edge maps of a sweep, bit-packed, one per threshold pair
+ */
+    struct SweepOutput {
+        int width = 0;
+        int height = 0;
+        int pairCount = 0;
+        size_t rowBytes = 0;                // Bytes per packed row: (width + 7) / 8
+        cv::Mat packed;                     // CV_8UC1, pairCount * height rows of rowBytes;
+                                            // row y of pair k is row k * height + y, MSB = leftmost pixel
+        std::vector<uint64_t> edgeCounts;   // Edge pixels per pair
+    };
+
+/**
+ * @brief Canny over many threshold pairs sharing one blur, gradient and NMS pass
+ *
+ * setImage() computes blur, Sobel gradients and non-maximum suppression once
+ * and keeps the suppressed gradient magnitudes; run() then only does the
+ * threshold-dependent hysteresis for each pair. In bit-sliced mode one pixel
+ * word carries a bit per pair, so a single flood fill serves up to 64 pairs.
+ * Results match applyCanny with the same thresholds. The hysteresis maps are
+ * kept between runs, so repeated runs at one size allocate nothing.
+ */
+    class ThresholdSweep {
+    public:
+        /**
+         * @param pool Worker pool to run on; null uses WorkerPool::shared()
+         */
+        explicit ThresholdSweep(std::shared_ptr<WorkerPool> pool = nullptr);
+        ~ThresholdSweep();
+
+        ThresholdSweep(const ThresholdSweep&) = delete;
+        ThresholdSweep& operator=(const ThresholdSweep&) = delete;
+
+        /**
+         * @brief Prepare an image for sweeping
+         * @param inputMat Input image (RGBA, BGR or grayscale)
+         * @param blurKernel Gaussian blur kernel size
+         * @param imageId Identity of the image content; unchanged ids reuse the gradients (0 = never)
+         * @return true if successful, false otherwise
+         */
+        bool setImage(const cv::Mat& inputMat, int blurKernel, uint64_t imageId = 0);
+
+        /**
+         * @brief Edge maps of the current image for every threshold pair
+         * @param pairs Threshold pairs; low and high are swapped if given the wrong way round
+         * @param output Receives one packed map and edge count per pair
+         * @param mode Hysteresis strategy
+         * @return true if successful, false otherwise
+         */
+        bool run(const std::vector<ThresholdPair>& pairs, SweepOutput& output,
+                 SweepMode mode = SweepMode::Auto);
+
+        /**
+         * @brief Expand one pair's packed map into a 0/255 edge image like cv::Canny's
+         */
+        static bool unpack(const SweepOutput& output, int pair, cv::Mat& edgeMat);
+
+    private:
+        struct Scratch;
+
+        std::shared_ptr<WorkerPool> pool_;
+        CannyStageCache stages_;
+        cv::Mat suppressed_;    // CV_16U L1 magnitude where a local maximum, else 0
+        std::unique_ptr<Scratch> scratch_;  // Thresholds and lane maps, kept so repeated runs do not allocate
+    };
+
+} // namespace EdgeDetection
+
+#endif // THRESHOLD_SWEEP_H
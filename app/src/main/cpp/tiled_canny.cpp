@@ -0,0 +1,403 @@
+//
+// Tiled Canny for large stills: bounded memory with exact, global hysteresis
+//
+#include "tiled_canny.h"
+#include "canny_stages.h"
+#include "image_processor.h"
+#include "log.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#define LOG_TAG "TiledCanny"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Scratch of one lane, reused for every tile it processes
+ */
+    struct TileWorkspace {
+        cv::Mat grayMat;
+        cv::Mat blurredMat;
+        BlurBuffers blurBuffers;
+        cv::Mat dxMat;
+        cv::Mat dyMat;
+        cv::Mat magnitude;
+        cv::Mat suppressed;
+        cv::Mat edgeMat;
+        std::vector<int> labels;        // Component per tile pixel, -1 = no edge candidate
+        std::vector<int> parent;        // Union-find over provisional labels
+        std::vector<int> compact;       // Provisional root -> component id
+        std::vector<uint8_t> strong;    // Component contains a pixel above the high threshold
+        std::vector<int> borderIndex;   // Component -> index among border components, -1 = interior
+    };
+
+/**
+ * @brief What pass one keeps of a tile: its border components and where they touch the border
+ */
+    struct TileSummary {
+        std::vector<int> top;           // Border component per pixel of the first row, -1 = none
+        std::vector<int> bottom;        // ... of the last row
+        std::vector<int> left;          // ... of the first column
+        std::vector<int> right;         // ... of the last column
+        std::vector<uint8_t> strong;    // Per border component
+        int firstGlobal = 0;            // Index of its first border component in the global forest
+    };
+
+    static int findRoot(std::vector<int>& parent, int node) {
+        while (parent[node] != node) {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    }
+
+    static void unite(std::vector<int>& parent, int a, int b) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+/**
+ * @brief Suppressed gradient magnitudes of a tile, computed from its haloed crop of the image
+ * @return Tile rectangle within workspace.suppressed
+ */
+    static cv::Rect suppressTile(const cv::Mat& inputMat, const cv::Rect& tile, int kernelSize,
+                                 TileWorkspace& workspace) {
+        // Sobel needs blurred rows one beyond the magnitudes NMS compares, which sit
+        // one beyond the tile; the blur needs its own support on top of that
+        int halo = blurSupportRadius(kernelSize) + 2;
+        cv::Rect crop(tile.x - halo, tile.y - halo, tile.width + 2 * halo, tile.height + 2 * halo);
+        crop &= cv::Rect(0, 0, inputMat.cols, inputMat.rows);
+
+        convertToGray(inputMat(crop), workspace.grayMat);
+        cannyGradients(workspace.grayMat, kernelSize, workspace.blurredMat, workspace.blurBuffers,
+                       workspace.dxMat, workspace.dyMat);
+
+        // Crop edges inside the image are wrong by up to the halo, but never
+        // reach the tile; crop edges on the image border behave as in cv::Canny
+        int rowStart = std::max(0, tile.y - crop.y - 1);
+        int rowEnd = std::min(crop.height, tile.y - crop.y + tile.height + 1);
+        workspace.magnitude.create(crop.height, crop.width, CV_16UC1);
+        workspace.suppressed.create(crop.height, crop.width, CV_16UC1);
+        gradientMagnitude(workspace.dxMat, workspace.dyMat, workspace.magnitude, rowStart, rowEnd);
+        suppressNonMaxima(workspace.dxMat, workspace.dyMat, workspace.magnitude, workspace.suppressed,
+                          tile.y - crop.y, tile.y - crop.y + tile.height);
+
+        return cv::Rect(tile.x - crop.x, tile.y - crop.y, tile.width, tile.height);
+    }
+
+/**
+ * @brief Label 8-connected edge candidates of a tile and find which components are strong
+ *
+ * Deterministic for a given tile, so pass two reproduces pass one's labels.
+ * @return Component count
+ */
+    static int labelTile(const cv::Mat& suppressed, const cv::Rect& tile, int low, int high,
+                         TileWorkspace& workspace) {
+        int width = tile.width;
+        int height = tile.height;
+        std::vector<int>& labels = workspace.labels;
+        std::vector<int>& parent = workspace.parent;
+        labels.assign(static_cast<size_t>(width) * height, -1);
+        parent.clear();
+
+        for (int y = 0; y < height; y++) {
+            const uint16_t* row = suppressed.ptr<uint16_t>(tile.y + y) + tile.x;
+            int* labelRow = labels.data() + static_cast<size_t>(y) * width;
+            const int* labelAbove = y > 0 ? labelRow - width : nullptr;
+
+            for (int x = 0; x < width; x++) {
+                if (row[x] <= low) {
+                    continue;
+                }
+
+                // Neighbours already visited in scan order: W, NW, N, NE
+                int label = -1;
+                auto join = [&](int other) {
+                    if (other < 0) {
+                        return;
+                    }
+                    if (label < 0) {
+                        label = other;
+                    } else {
+                        unite(parent, label, other);
+                    }
+                };
+                if (x > 0) {
+                    join(labelRow[x - 1]);
+                }
+                if (labelAbove) {
+                    if (x > 0) {
+                        join(labelAbove[x - 1]);
+                    }
+                    join(labelAbove[x]);
+                    if (x + 1 < width) {
+                        join(labelAbove[x + 1]);
+                    }
+                }
+                if (label < 0) {
+                    label = static_cast<int>(parent.size());
+                    parent.push_back(label);
+                }
+                labelRow[x] = label;
+            }
+        }
+
+        // Compact roots to ids in scan order and collect strong flags
+        workspace.compact.assign(parent.size(), -1);
+        workspace.strong.clear();
+        int components = 0;
+        for (int y = 0; y < height; y++) {
+            const uint16_t* row = suppressed.ptr<uint16_t>(tile.y + y) + tile.x;
+            int* labelRow = labels.data() + static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; x++) {
+                if (labelRow[x] < 0) {
+                    continue;
+                }
+                int root = findRoot(parent, labelRow[x]);
+                if (workspace.compact[root] < 0) {
+                    workspace.compact[root] = components++;
+                    workspace.strong.push_back(0);
+                }
+                int component = workspace.compact[root];
+                labelRow[x] = component;
+                if (row[x] > high) {
+                    workspace.strong[component] = 1;
+                }
+            }
+        }
+
+        // Border components in a fixed order: top row, bottom row, left column, right column
+        workspace.borderIndex.assign(components, -1);
+        int borderCount = 0;
+        auto visit = [&](int x, int y) {
+            int component = labels[static_cast<size_t>(y) * width + x];
+            if (component >= 0 && workspace.borderIndex[component] < 0) {
+                workspace.borderIndex[component] = borderCount++;
+            }
+        };
+        for (int x = 0; x < width; x++) {
+            visit(x, 0);
+            visit(x, height - 1);
+        }
+        for (int y = 0; y < height; y++) {
+            visit(0, y);
+            visit(width - 1, y);
+        }
+        return components;
+    }
+
+/**
+ * @brief Record a labelled tile's border components for the global merge
+ */
+    static void summarizeTile(int width, int height, const TileWorkspace& workspace, TileSummary& summary) {
+        auto borderAt = [&](int x, int y) {
+            int component = workspace.labels[static_cast<size_t>(y) * width + x];
+            return component >= 0 ? workspace.borderIndex[component] : -1;
+        };
+
+        summary.top.resize(width);
+        summary.bottom.resize(width);
+        for (int x = 0; x < width; x++) {
+            summary.top[x] = borderAt(x, 0);
+            summary.bottom[x] = borderAt(x, height - 1);
+        }
+        summary.left.resize(height);
+        summary.right.resize(height);
+        for (int y = 0; y < height; y++) {
+            summary.left[y] = borderAt(0, y);
+            summary.right[y] = borderAt(width - 1, y);
+        }
+
+        int borderCount = 0;
+        for (int index : workspace.borderIndex) {
+            borderCount = std::max(borderCount, index + 1);
+        }
+        summary.strong.assign(borderCount, 0);
+        for (size_t component = 0; component < workspace.borderIndex.size(); component++) {
+            if (workspace.borderIndex[component] >= 0) {
+                summary.strong[workspace.borderIndex[component]] = workspace.strong[component];
+            }
+        }
+    }
+
+/**
+ * @brief Run fn(tile, lane) for every tile, lanes pulling tiles dynamically
+ * @return false if any tile failed
+ */
+    template<typename F>
+    static bool forEachTile(WorkerPool* pool, int tileCount, int lanes, F&& fn) {
+        std::atomic<int> nextTile(0);
+        std::atomic<bool> failed(false);
+        auto runLane = [&](int lane) {
+            try {
+                for (int tile = nextTile.fetch_add(1); tile < tileCount && !failed.load(std::memory_order_relaxed);
+                     tile = nextTile.fetch_add(1)) {
+                    fn(tile, lane);
+                }
+            } catch (const cv::Exception& e) {
+                LOGE("OpenCV exception in tile lane %d: %s", lane, e.what());
+                failed.store(true, std::memory_order_relaxed);
+            } catch (const std::exception& e) {
+                LOGE("Standard exception in tile lane %d: %s", lane, e.what());
+                failed.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        if (pool && lanes > 1) {
+            pool->parallelFor(lanes, runLane);
+        } else {
+            runLane(0);
+        }
+        return !failed.load(std::memory_order_relaxed);
+    }
+
+    bool applyCannyTiled(const cv::Mat& inputMat, double lowThreshold, double highThreshold,
+                         int kernelSize, const TileSink& sink, WorkerPool* pool, int tileSize) {
+        TRACE_SCOPE("tiledCanny");
+        try {
+            if (inputMat.empty() || !sink || tileSize < 16) {
+                LOGE("Invalid input for tiled Canny (tile size %d)", tileSize);
+                return false;
+            }
+
+            int low;
+            int high;
+            cannyThresholds(lowThreshold, highThreshold, low, high);
+
+            int tilesX = (inputMat.cols + tileSize - 1) / tileSize;
+            int tilesY = (inputMat.rows + tileSize - 1) / tileSize;
+            int tileCount = tilesX * tilesY;
+            auto tileRect = [&](int tile) {
+                int x = (tile % tilesX) * tileSize;
+                int y = (tile / tilesX) * tileSize;
+                return cv::Rect(x, y, std::min(tileSize, inputMat.cols - x), std::min(tileSize, inputMat.rows - y));
+            };
+
+            int lanes = pool ? std::min(tileCount, pool->size()) : 1;
+            std::vector<TileWorkspace> workspaces(lanes);
+
+            // Pass 1: local components, keeping only those on tile borders
+            std::vector<TileSummary> summaries(tileCount);
+            bool success = forEachTile(pool, tileCount, lanes, [&](int tile, int lane) {
+                TRACE_SCOPE("tiledCanny.label");
+                TileWorkspace& workspace = workspaces[lane];
+                cv::Rect rect = tileRect(tile);
+                cv::Rect inner = suppressTile(inputMat, rect, kernelSize, workspace);
+                labelTile(workspace.suppressed, inner, low, high, workspace);
+                summarizeTile(rect.width, rect.height, workspace, summaries[tile]);
+            });
+            if (!success) {
+                return false;
+            }
+
+            // Global merge: border components touching across tile edges and corners
+            int globalCount = 0;
+            for (TileSummary& summary : summaries) {
+                summary.firstGlobal = globalCount;
+                globalCount += static_cast<int>(summary.strong.size());
+            }
+            std::vector<int> parent(globalCount);
+            for (int i = 0; i < globalCount; i++) {
+                parent[i] = i;
+            }
+            auto link = [&](const TileSummary& a, int borderA, const TileSummary& b, int borderB) {
+                if (borderA >= 0 && borderB >= 0) {
+                    unite(parent, a.firstGlobal + borderA, b.firstGlobal + borderB);
+                }
+            };
+            for (int ty = 0; ty < tilesY; ty++) {
+                for (int tx = 0; tx < tilesX; tx++) {
+                    const TileSummary& here = summaries[ty * tilesX + tx];
+                    if (tx + 1 < tilesX) {
+                        const TileSummary& right = summaries[ty * tilesX + tx + 1];
+                        int rows = static_cast<int>(here.right.size());
+                        for (int y = 0; y < rows; y++) {
+                            for (int dy = -1; dy <= 1; dy++) {
+                                if (y + dy >= 0 && y + dy < rows) {
+                                    link(here, here.right[y], right, right.left[y + dy]);
+                                }
+                            }
+                        }
+                    }
+                    if (ty + 1 < tilesY) {
+                        const TileSummary& below = summaries[(ty + 1) * tilesX + tx];
+                        int cols = static_cast<int>(here.bottom.size());
+                        for (int x = 0; x < cols; x++) {
+                            for (int dx = -1; dx <= 1; dx++) {
+                                if (x + dx >= 0 && x + dx < cols) {
+                                    link(here, here.bottom[x], below, below.top[x + dx]);
+                                }
+                            }
+                        }
+                        // Diagonal neighbours across tile corners
+                        if (tx + 1 < tilesX) {
+                            const TileSummary& belowRight = summaries[(ty + 1) * tilesX + tx + 1];
+                            link(here, here.bottom.back(), belowRight, belowRight.top.front());
+                        }
+                        if (tx > 0) {
+                            const TileSummary& belowLeft = summaries[(ty + 1) * tilesX + tx - 1];
+                            link(here, here.bottom.front(), belowLeft, belowLeft.top.back());
+                        }
+                    }
+                }
+            }
+            std::vector<uint8_t> rootStrong(globalCount, 0);
+            for (const TileSummary& summary : summaries) {
+                for (size_t i = 0; i < summary.strong.size(); i++) {
+                    if (summary.strong[i]) {
+                        rootStrong[findRoot(parent, summary.firstGlobal + static_cast<int>(i))] = 1;
+                    }
+                }
+            }
+            // Resolved per component up front, so pass two only reads shared state
+            std::vector<uint8_t> globalStrong(globalCount);
+            for (int i = 0; i < globalCount; i++) {
+                globalStrong[i] = rootStrong[findRoot(parent, i)];
+            }
+
+            // Pass 2: recompute each tile and keep components strong anywhere in the image
+            success = forEachTile(pool, tileCount, lanes, [&](int tile, int lane) {
+                TRACE_SCOPE("tiledCanny.emit");
+                TileWorkspace& workspace = workspaces[lane];
+                const TileSummary& summary = summaries[tile];
+                cv::Rect rect = tileRect(tile);
+                cv::Rect inner = suppressTile(inputMat, rect, kernelSize, workspace);
+                int components = labelTile(workspace.suppressed, inner, low, high, workspace);
+
+                for (int component = 0; component < components; component++) {
+                    int border = workspace.borderIndex[component];
+                    if (border >= 0) {
+                        workspace.strong[component] = globalStrong[summary.firstGlobal + border];
+                    }
+                }
+
+                workspace.edgeMat.create(rect.height, rect.width, CV_8UC1);
+                for (int y = 0; y < rect.height; y++) {
+                    const int* labelRow = workspace.labels.data() + static_cast<size_t>(y) * rect.width;
+                    uint8_t* edgeRow = workspace.edgeMat.ptr<uint8_t>(y);
+                    for (int x = 0; x < rect.width; x++) {
+                        edgeRow[x] = labelRow[x] >= 0 && workspace.strong[labelRow[x]] ? 255 : 0;
+                    }
+                }
+                sink(rect, workspace.edgeMat);
+            });
+
+            LOGD("Tiled Canny on %dx%d: %d tiles, %d border components", inputMat.cols, inputMat.rows,
+                 tileCount, globalCount);
+            return success;
+
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in applyCannyTiled: %s", e.what());
+            return false;
+        } catch (const std::exception& e) {
+            LOGE("Standard exception in applyCannyTiled: %s", e.what());
+            return false;
+        }
+    }
+
+} // namespace EdgeDetection
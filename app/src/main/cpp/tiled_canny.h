@@ -0,0 +1,52 @@
+#ifndef TILED_CANNY_H
+#define TILED_CANNY_H
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+
+#include "worker_pool.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Default tile edge length for large images; about 5 MB of scratch per worker
+ */
+    constexpr int kLargeImageTileSize = 512;
+
+/**
+ * @brief Receives one finished tile: its rectangle in the image and its edges (CV_8UC1, 0/255)
+ *
+ * Called on pool workers, possibly for several tiles at once; the edge Mat is
+ * only valid for the duration of the call.
+ */
+    using TileSink = std::function<void(const cv::Rect& tile, const cv::Mat& edges)>;
+
+/**
+ * @brief Canny edge detection of a large image in overlapping tiles with bounded memory
+ *
+ * Every tile is blurred and differentiated with a halo of the blur's support
+ * (see blurSupportRadius), so no full-size intermediate is ever allocated and
+ * peak memory is proportional to tile size times worker count. Hysteresis is
+ * kept global: a first pass labels each tile's weak/strong edge components and
+ * keeps only the ones touching the tile border, those are merged across tile
+ * borders with a union-find, and a second pass recomputes each tile and emits
+ * edges whose component reaches a strong pixel anywhere in the image. With the
+ * exact and box-cascade blurs the halo covers the whole support and the result
+ * equals applyCanny's on the whole image. The recursive blur (kernels 9 and
+ * 11) responds beyond its halo, so a few pixels near tile borders can differ.
+ * @param inputMat Input image (RGBA, BGR or grayscale); read only, never copied whole
+ * @param lowThreshold Lower threshold for edge detection
+ * @param highThreshold Upper threshold for edge detection
+ * @param kernelSize Gaussian blur kernel size
+ * @param sink Receives the edge tiles
+ * @param pool Pool to run tiles on; null runs them on the calling thread
+ * @param tileSize Tile edge length in pixels
+ * @return true if successful, false otherwise
+ */
+    bool applyCannyTiled(const cv::Mat& inputMat, double lowThreshold, double highThreshold,
+                         int kernelSize, const TileSink& sink, WorkerPool* pool = nullptr,
+                         int tileSize = kLargeImageTileSize);
+
+} // namespace EdgeDetection
+
+#endif // TILED_CANNY_H
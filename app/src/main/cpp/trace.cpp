@@ -0,0 +1,275 @@
+//
+// Per-stage latency tracer with Chrome trace_event export
+//
+#include "trace.h"
+#include "log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define LOG_TAG "Trace"
+
+namespace EdgeDetection {
+namespace Trace {
+
+    // Events kept per thread (40 bytes each, ~640 KiB); older events are overwritten
+    static const size_t kEventsPerThread = 16384;
+
+    // Seqlock-protected event: seq is odd while the owner rewrites the slot
+    struct EventSlot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> frame{0};
+        std::atomic<int64_t> beginNs{0};
+        std::atomic<int64_t> endNs{0};
+    };
+
+    struct ThreadBuffer {
+        explicit ThreadBuffer(int id) : tid(id), slots(new EventSlot[kEventsPerThread]) {}
+
+        int tid;                            // Guarded by the registry mutex
+        std::string name;                   // Guarded by the registry mutex
+        std::atomic<uint64_t> written{0};   // Events ever recorded (owner writes)
+        std::atomic<uint64_t> clearedAt{0}; // Events before this index were cleared
+        std::unique_ptr<EventSlot[]> slots;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::vector<ThreadBuffer*> freeBuffers; // Rings of exited threads, reused by new ones
+        int nextTid = 1;
+    };
+
+    // Intentionally leaked: threads may still record while statics are destroyed
+    static Registry& registry() {
+        static Registry* instance = new Registry();
+        return *instance;
+    }
+
+    static std::atomic<bool> recording(false);
+    static thread_local uint64_t localFrame = 0;
+
+    // Held until the thread's first event, so threads that never record own no ring
+    static thread_local std::string localName;
+
+    // Hands the calling thread's ring back to the registry when the thread exits
+    struct BufferOwner {
+        ThreadBuffer* buffer = nullptr;
+
+        ~BufferOwner() {
+            if (buffer) {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                reg.freeBuffers.push_back(buffer);
+                buffer = nullptr;
+            }
+        }
+    };
+    static thread_local BufferOwner localOwner;
+
+    // A ring taken over from an exited thread keeps its memory but drops that thread's events
+    static ThreadBuffer& threadBuffer() {
+        if (!localOwner.buffer) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            ThreadBuffer* buffer;
+            if (!reg.freeBuffers.empty()) {
+                buffer = reg.freeBuffers.back();
+                reg.freeBuffers.pop_back();
+                buffer->tid = reg.nextTid++;
+                buffer->clearedAt.store(buffer->written.load(std::memory_order_relaxed),
+                                        std::memory_order_relaxed);
+            } else {
+                reg.buffers.push_back(std::make_shared<ThreadBuffer>(reg.nextTid++));
+                buffer = reg.buffers.back().get();
+            }
+            buffer->name = localName;
+            localOwner.buffer = buffer;
+        }
+        return *localOwner.buffer;
+    }
+
+    void setEnabled(bool enabled) {
+        recording.store(enabled, std::memory_order_relaxed);
+        LOGI("Tracing %s", enabled ? "enabled" : "disabled");
+    }
+
+    bool isEnabled() {
+        return recording.load(std::memory_order_relaxed);
+    }
+
+    void setCurrentFrame(uint64_t sequence) {
+        localFrame = sequence;
+    }
+
+    uint64_t currentFrame() {
+        return localFrame;
+    }
+
+    void setThreadName(const char* name) {
+        localName = name ? name : "";
+        if (localOwner.buffer) {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            localOwner.buffer->name = localName;
+        }
+    }
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(const char* name, uint64_t frame, int64_t beginNs, int64_t endNs) {
+        if (!isEnabled()) {
+            return;
+        }
+
+        ThreadBuffer& buffer = threadBuffer();
+        uint64_t index = buffer.written.load(std::memory_order_relaxed);
+        EventSlot& slot = buffer.slots[index % kEventsPerThread];
+
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.frame.store(frame, std::memory_order_relaxed);
+        slot.beginNs.store(beginNs, std::memory_order_relaxed);
+        slot.endNs.store(endNs, std::memory_order_relaxed);
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+
+        buffer.written.store(index + 1, std::memory_order_release);
+    }
+
+    struct Event {
+        const char* name;
+        uint64_t frame;
+        int64_t beginNs;
+        int64_t endNs;
+    };
+
+    // Copy a thread's buffered events, skipping slots rewritten during the copy
+    static void collect(const ThreadBuffer& buffer, std::vector<Event>& events) {
+        uint64_t written = buffer.written.load(std::memory_order_acquire);
+        uint64_t first = written > kEventsPerThread ? written - kEventsPerThread : 0;
+        first = std::max(first, buffer.clearedAt.load(std::memory_order_relaxed));
+
+        for (uint64_t index = first; index < written; index++) {
+            const EventSlot& slot = buffer.slots[index % kEventsPerThread];
+            uint64_t before = slot.seq.load(std::memory_order_acquire);
+            Event event;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.frame = slot.frame.load(std::memory_order_relaxed);
+            event.beginNs = slot.beginNs.load(std::memory_order_relaxed);
+            event.endNs = slot.endNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = slot.seq.load(std::memory_order_relaxed);
+
+            if (before == after && before == 2 * index + 2 && event.name) {
+                events.push_back(event);
+            }
+        }
+    }
+
+    static void appendEscaped(std::string& out, const char* text) {
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                out += '\\';
+            }
+            if (static_cast<unsigned char>(*c) >= 0x20) {
+                out += *c;
+            }
+        }
+    }
+
+    std::string toChromeJson() {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::vector<std::string> names;
+        std::vector<int> tids;
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            buffers = reg.buffers;
+            for (const auto& buffer : buffers) {
+                names.push_back(buffer->name);
+                tids.push_back(buffer->tid);
+            }
+        }
+
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        char number[128];
+        std::vector<Event> events;
+
+        for (size_t i = 0; i < buffers.size(); i++) {
+            const ThreadBuffer& buffer = *buffers[i];
+
+            if (!names[i].empty()) {
+                out += first ? "\n" : ",\n";
+                first = false;
+                snprintf(number, sizeof(number),
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                         tids[i]);
+                out += number;
+                appendEscaped(out, names[i].c_str());
+                out += "\"}}";
+            }
+
+            events.clear();
+            collect(buffer, events);
+            for (const Event& event : events) {
+                out += first ? "\n" : ",\n";
+                first = false;
+                out += "{\"name\":\"";
+                appendEscaped(out, event.name);
+                // Complete ("X") events; timestamps in microseconds
+                snprintf(number, sizeof(number),
+                         "\",\"cat\":\"edge\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                         "\"args\":{\"frame\":%llu}}",
+                         tids[i], event.beginNs / 1e3, (event.endNs - event.beginNs) / 1e3,
+                         static_cast<unsigned long long>(event.frame));
+                out += number;
+            }
+        }
+
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool dumpChromeTrace(const char* path) {
+        if (!path) {
+            LOGE("No trace output path");
+            return false;
+        }
+
+        std::string json = toChromeJson();
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            LOGE("Cannot open trace file %s", path);
+            return false;
+        }
+
+        bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+        written = fclose(file) == 0 && written;
+        if (written) {
+            LOGI("Wrote %zu bytes of trace to %s", json.size(), path);
+        } else {
+            LOGE("Failed writing trace file %s", path);
+        }
+        return written;
+    }
+
+    void clear() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto& buffer : reg.buffers) {
+            buffer->clearedAt.store(buffer->written.load(std::memory_order_acquire),
+                                    std::memory_order_relaxed);
+        }
+    }
+
+} // namespace Trace
+} // namespace EdgeDetection
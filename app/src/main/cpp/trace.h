@@ -0,0 +1,119 @@
+#ifndef EDGE_TRACE_H
+#define EDGE_TRACE_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Per-stage latency tracer
+ *
+ * Scoped events (name, frame sequence, begin and end in nanoseconds) go into
+ * a fixed-size ring owned by the recording thread, so recording takes no
+ * locks and allocates nothing after a thread's first event. Old events are
+ * overwritten once a ring is full. A thread gets its ring with its first
+ * event and hands it back when it exits, and the next thread to record
+ * reuses it, so there are never more rings than threads that recorded at
+ * once. dumpChromeTrace() writes everything still buffered as Chrome
+ * trace_event JSON, which opens in Perfetto or chrome://tracing and shows
+ * how the pipeline stages of consecutive frames overlap across threads.
+ *
+ * The TRACE_* macros compile to nothing unless EDGE_TRACE_ENABLED is set
+ * (CMake option EDGE_ENABLE_TRACING); the functions below are always
+ * available so tools can link against them either way.
+ */
+
+namespace EdgeDetection {
+namespace Trace {
+
+/**
+ * @brief Start or stop recording (recording starts disabled)
+ */
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+/**
+ * @brief Tag events recorded from now on by the calling thread with a frame sequence number
+ */
+    void setCurrentFrame(uint64_t sequence);
+    uint64_t currentFrame();
+
+/**
+ * @brief Name the calling thread in the trace viewer
+ */
+    void setThreadName(const char* name);
+
+/**
+ * @brief Monotonic timestamp used for all events
+ */
+    int64_t nowNs();
+
+/**
+ * @brief Record one completed scope on the calling thread's ring
+ * @param name Static string (stored by pointer)
+ */
+    void record(const char* name, uint64_t frame, int64_t beginNs, int64_t endNs);
+
+/**
+ * @brief Render all buffered events as Chrome trace_event JSON
+ */
+    std::string toChromeJson();
+
+/**
+ * @brief Write the buffered events to a Chrome trace_event JSON file
+ * @return true if the file was written
+ */
+    bool dumpChromeTrace(const char* path);
+
+/**
+ * @brief Discard all buffered events
+ */
+    void clear();
+
+/**
+ * @brief Records the enclosing scope as one event
+ */
+    class Scope {
+    public:
+        explicit Scope(const char* name) : Scope(name, currentFrame()) {}
+
+        Scope(const char* name, uint64_t frame)
+                : name_(name), frame_(frame), beginNs_(isEnabled() ? nowNs() : 0) {}
+
+        ~Scope() {
+            if (beginNs_ != 0) {
+                record(name_, frame_, beginNs_, nowNs());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name_;
+        uint64_t frame_;
+        int64_t beginNs_;
+    };
+
+} // namespace Trace
+} // namespace EdgeDetection
+
+#define EDGE_TRACE_CONCAT_INNER(a, b) a##b
+#define EDGE_TRACE_CONCAT(a, b) EDGE_TRACE_CONCAT_INNER(a, b)
+
+#if EDGE_TRACE_ENABLED
+#define TRACE_SCOPE(name) \
+    ::EdgeDetection::Trace::Scope EDGE_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_SCOPE_FRAME(name, frame) \
+    ::EdgeDetection::Trace::Scope EDGE_TRACE_CONCAT(traceScope_, __LINE__)(name, frame)
+#define TRACE_FRAME(frame) ::EdgeDetection::Trace::setCurrentFrame(frame)
+#define TRACE_CURRENT_FRAME() ::EdgeDetection::Trace::currentFrame()
+#define TRACE_THREAD_NAME(name) ::EdgeDetection::Trace::setThreadName(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_FRAME(name, frame) ((void)(frame))
+#define TRACE_FRAME(frame) ((void)(frame))
+#define TRACE_CURRENT_FRAME() (static_cast<uint64_t>(0))
+#define TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // EDGE_TRACE_H
@@ -0,0 +1,167 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace EdgeDetection {
+
+/**
+ * @brief Lock-free Chase–Lev work-stealing deque
+ *
+ * The owning thread pushes and pops at the bottom (LIFO, cache-warm); any
+ * other thread steals from the top (FIFO, oldest work first). Only a steal
+ * racing the owner for the last element pays for a CAS; the owner's common
+ * path is two plain atomic stores. The ring grows on demand and retired
+ * rings are kept until destruction, because a thief may still be reading
+ * one. Items are copied word by word through relaxed atomics so a thief that
+ * loses the race for a slot reads a value it will discard, never undefined
+ * behaviour.
+ */
+    template<typename T>
+    class WorkStealingDeque {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "WorkStealingDeque items must be trivially copyable");
+
+    public:
+        /**
+         * @param initialCapacity Starting ring size, rounded up to a power of two
+         */
+        explicit WorkStealingDeque(size_t initialCapacity = 64) : top_(0), bottom_(0) {
+            size_t capacity = 2;
+            while (capacity < initialCapacity) {
+                capacity <<= 1;
+            }
+            rings_.emplace_back(new Ring(capacity));
+            ring_.store(rings_.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        /**
+         * @brief Add an item at the bottom (owner thread only)
+         */
+        void push(const T& item) {
+            int64_t bottom = bottom_.load(std::memory_order_relaxed);
+            int64_t top = top_.load(std::memory_order_acquire);
+            Ring* ring = ring_.load(std::memory_order_relaxed);
+
+            if (bottom - top > static_cast<int64_t>(ring->mask)) {
+                ring = grow(ring, top, bottom);
+            }
+
+            ring->store(bottom, item);
+            bottom_.store(bottom + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Take the most recently pushed item (owner thread only)
+         * @return false if the deque was empty
+         */
+        bool pop(T& item) {
+            int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+            Ring* ring = ring_.load(std::memory_order_relaxed);
+            bottom_.store(bottom, std::memory_order_seq_cst);
+            int64_t top = top_.load(std::memory_order_seq_cst);
+
+            if (top > bottom) {
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            item = ring->load(bottom);
+            if (top == bottom) {
+                // Last item: race the thieves for it
+                bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                        std::memory_order_relaxed);
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Take the oldest item (any thread)
+         * @return false if the deque was empty or another thread took the item first
+         */
+        bool steal(T& item) {
+            int64_t top = top_.load(std::memory_order_seq_cst);
+            int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+            if (top >= bottom) {
+                return false;
+            }
+
+            Ring* ring = ring_.load(std::memory_order_acquire);
+            item = ring->load(top);
+            return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Approximate item count (exact only when no other thread is active)
+         */
+        size_t size() const {
+            int64_t bottom = bottom_.load(std::memory_order_relaxed);
+            int64_t top = top_.load(std::memory_order_relaxed);
+            return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+        }
+
+    private:
+        static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        struct Slot {
+            std::atomic<uint64_t> words[kWords];
+        };
+
+        struct Ring {
+            explicit Ring(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+
+            void store(int64_t index, const T& item) {
+                uint64_t words[kWords] = {};
+                memcpy(words, &item, sizeof(T));
+                Slot& slot = slots[static_cast<size_t>(index) & mask];
+                for (size_t i = 0; i < kWords; i++) {
+                    slot.words[i].store(words[i], std::memory_order_relaxed);
+                }
+            }
+
+            T load(int64_t index) const {
+                uint64_t words[kWords];
+                const Slot& slot = slots[static_cast<size_t>(index) & mask];
+                for (size_t i = 0; i < kWords; i++) {
+                    words[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                T item;
+                memcpy(&item, words, sizeof(T));
+                return item;
+            }
+
+            size_t mask;
+            std::unique_ptr<Slot[]> slots;
+        };
+
+        Ring* grow(Ring* ring, int64_t top, int64_t bottom) {
+            rings_.emplace_back(new Ring((ring->mask + 1) * 2));
+            Ring* bigger = rings_.back().get();
+            for (int64_t i = top; i < bottom; i++) {
+                bigger->store(i, ring->load(i));
+            }
+            ring_.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+
+        alignas(64) std::atomic<int64_t> top_;      // Next item to steal
+        alignas(64) std::atomic<int64_t> bottom_;   // Next free slot (owner side)
+        std::atomic<Ring*> ring_;
+        std::vector<std::unique_ptr<Ring>> rings_;  // Owner-only; includes retired rings
+    };
+
+} // namespace EdgeDetection
+
+#endif // WORK_STEALING_DEQUE_H
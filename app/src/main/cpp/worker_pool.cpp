@@ -0,0 +1,260 @@
+//
+// Shared work-stealing thread pool for tile and stream processing
+//
+#include "worker_pool.h"
+#include "log.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+
+#define LOG_TAG "WorkerPool"
+
+namespace EdgeDetection {
+
+    // Identifies the pool (and slot) a worker thread belongs to
+    static thread_local const WorkerPool* currentPool = nullptr;
+    static thread_local int currentIndex = -1;
+
+    WorkerPool::WorkerPool(int numThreads) {
+        if (numThreads <= 0) {
+            numThreads = static_cast<int>(std::thread::hardware_concurrency());
+            if (numThreads <= 0) {
+                numThreads = 2;
+            }
+        }
+
+        workers_.reserve(numThreads);
+        for (int i = 0; i < numThreads; i++) {
+            workers_.emplace_back(new Worker());
+        }
+        for (int i = 0; i < numThreads; i++) {
+            workers_[i]->thread = std::thread(&WorkerPool::workerLoop, this, i);
+        }
+
+        // Return only once every worker has done its one-time setup, so thread
+        // start-up cost is paid here rather than during the first frames
+        while (startedWorkers_.load(std::memory_order_acquire) < numThreads) {
+            std::this_thread::yield();
+        }
+
+        LOGI("Worker pool started with %d threads", numThreads);
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stopping_.store(true, std::memory_order_seq_cst);
+        }
+        sleepCondition_.notify_all();
+
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+    std::shared_ptr<WorkerPool> WorkerPool::shared() {
+        static std::mutex sharedMutex;
+        static std::weak_ptr<WorkerPool> sharedPool;
+
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        std::shared_ptr<WorkerPool> pool = sharedPool.lock();
+        if (!pool) {
+            pool = std::make_shared<WorkerPool>();
+            sharedPool = pool;
+        }
+        return pool;
+    }
+
+    int WorkerPool::currentWorkerIndex() const {
+        return currentPool == this ? currentIndex : -1;
+    }
+
+    void WorkerPool::submit(const Task& task) {
+        submitRange(task.run, task.context, 1, task.group);
+    }
+
+    void WorkerPool::submitRange(void (*run)(void*, int), void* context, int count,
+                                 TaskGroup* group) {
+        if (count <= 0) {
+            return;
+        }
+        if (group) {
+            group->pending.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Workers keep their own tasks local (thieves rebalance); outside threads inject
+        int self = currentWorkerIndex();
+        if (self >= 0) {
+            Worker& worker = *workers_[self];
+            for (int i = 0; i < count; i++) {
+                worker.tasks.push(Task{run, context, i, group});
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(injectMutex_);
+            size_t needed = injectedCount_ + static_cast<size_t>(count);
+            if (needed > injected_.size()) {
+                // Unroll the ring into a larger one
+                std::vector<Task> grown(std::max<size_t>(needed, injected_.size() * 2));
+                for (size_t i = 0; i < injectedCount_; i++) {
+                    grown[i] = injected_[(injectedHead_ + i) % injected_.size()];
+                }
+                injected_.swap(grown);
+                injectedHead_ = 0;
+            }
+            for (int i = 0; i < count; i++) {
+                injected_[(injectedHead_ + injectedCount_++) % injected_.size()] = Task{run, context, i, group};
+            }
+        }
+
+        queued_.fetch_add(count, std::memory_order_seq_cst);
+        wakeWorkers(count);
+    }
+
+    void WorkerPool::wakeWorkers(int count) {
+        if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            if (count > 1) {
+                sleepCondition_.notify_all();
+            } else {
+                sleepCondition_.notify_one();
+            }
+        }
+    }
+
+    void WorkerPool::wait(TaskGroup& group) {
+        unsigned idleSpins = 0;
+        while (group.pending.load(std::memory_order_acquire) > 0) {
+            if (runPendingTask()) {
+                idleSpins = 0;
+            } else if (++idleSpins < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    bool WorkerPool::runPendingTask() {
+        Task task;
+        int self = currentWorkerIndex();
+        if ((self >= 0 && popLocal(self, task)) || popInjected(task) || steal(self, task)) {
+            execute(self, task);
+            return true;
+        }
+        return false;
+    }
+
+    bool WorkerPool::popLocal(int index, Task& task) {
+        if (!workers_[index]->tasks.pop(task)) {
+            return false;
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool WorkerPool::popInjected(Task& task) {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        if (injectedCount_ == 0) {
+            return false;
+        }
+        task = injected_[injectedHead_];
+        injectedHead_ = (injectedHead_ + 1) % injected_.size();
+        injectedCount_--;
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool WorkerPool::steal(int thief, Task& task) {
+        size_t count = workers_.size();
+        size_t start = thief >= 0 ? static_cast<size_t>(thief) + 1 : 0;
+
+        for (size_t i = 0; i < count; i++) {
+            size_t victim = (start + i) % count;
+            if (static_cast<int>(victim) == thief) {
+                continue;
+            }
+            if (workers_[victim]->tasks.steal(task)) {
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                if (thief >= 0) {
+                    workers_[thief]->stolen.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+
+        if (thief >= 0) {
+            workers_[thief]->failedSteals.fetch_add(1, std::memory_order_relaxed);
+        }
+        return false;
+    }
+
+    void WorkerPool::execute(int self, const Task& task) {
+        task.run(task.context, task.index);
+        if (task.group) {
+            task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        if (self >= 0) {
+            workers_[self]->executed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            outsideExecuted_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    PoolStats WorkerPool::stats() const {
+        PoolStats stats = {};
+        stats.workers = size();
+        stats.tasksExecuted = outsideExecuted_.load(std::memory_order_relaxed);
+
+        int64_t idleNs = 0;
+        for (const auto& worker : workers_) {
+            stats.tasksExecuted += worker->executed.load(std::memory_order_relaxed);
+            stats.tasksStolen += worker->stolen.load(std::memory_order_relaxed);
+            stats.failedSteals += worker->failedSteals.load(std::memory_order_relaxed);
+            stats.idleWaits += worker->idleWaits.load(std::memory_order_relaxed);
+            idleNs += worker->idleNs.load(std::memory_order_relaxed);
+        }
+        stats.idleTimeMs = idleNs / 1e6;
+        return stats;
+    }
+
+    void WorkerPool::workerLoop(int index) {
+        currentPool = this;
+        currentIndex = index;
+        Worker& self = *workers_[index];
+
+        char threadName[32];
+        snprintf(threadName, sizeof(threadName), "edge-worker-%d", index);
+        TRACE_THREAD_NAME(threadName);
+        startedWorkers_.fetch_add(1, std::memory_order_release);
+
+        while (!stopping_.load(std::memory_order_acquire)) {
+            if (runPendingTask()) {
+                continue;
+            }
+
+            auto idleStart = std::chrono::steady_clock::now();
+            {
+                std::unique_lock<std::mutex> lock(sleepMutex_);
+                sleeping_.fetch_add(1, std::memory_order_seq_cst);
+                sleepCondition_.wait(lock, [this] {
+                    return queued_.load(std::memory_order_seq_cst) > 0 ||
+                           stopping_.load(std::memory_order_seq_cst);
+                });
+                sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            auto idleNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - idleStart).count();
+            self.idleWaits.fetch_add(1, std::memory_order_relaxed);
+            self.idleNs.fetch_add(idleNs, std::memory_order_relaxed);
+        }
+
+        currentPool = nullptr;
+        currentIndex = -1;
+    }
+
+} // namespace EdgeDetection
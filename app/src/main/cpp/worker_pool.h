@@ -0,0 +1,161 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "work_stealing_deque.h"
+
+namespace EdgeDetection {
+
+/**
+ * @brief Completion counter for a batch of tasks
+ */
+    struct TaskGroup {
+        std::atomic<int> pending{0};    // Tasks submitted but not yet finished
+    };
+
+/**
+ * @brief Unit of work: a plain function pointer plus context, so submitting does not allocate
+ */
+    struct Task {
+        void (*run)(void* context, int index);  // Entry point
+        void* context;                          // Caller-owned state
+        int index;                              // Task index within its batch
+        TaskGroup* group;                       // Completion counter (may be null)
+    };
+
+/**
+ * @brief Scheduling counters of a worker pool, summed over all workers
+ */
+    struct PoolStats {
+        int workers;                // Worker thread count
+        uint64_t tasksExecuted;     // Tasks run by workers and helping threads
+        uint64_t tasksStolen;       // Tasks taken from another worker's deque
+        uint64_t failedSteals;      // Steal sweeps that found nothing to take
+        uint64_t idleWaits;         // Times a worker went to sleep for lack of work
+        double idleTimeMs;          // Total time workers spent asleep
+    };
+
+/**
+ * @brief Shared work-stealing thread pool
+ *
+ * Every worker owns a lock-free Chase–Lev deque: it pushes and pops its own
+ * tasks at the bottom and idle workers steal the oldest tasks from the top of
+ * the others, so a worker stuck on an expensive (edge-dense) tile sheds the
+ * rest of its queue to idle cores. Tasks submitted from outside the pool go
+ * through a FIFO injection queue, which keeps tiles of consecutive frames in
+ * submission order. Waiting on a TaskGroup runs pending tasks instead of
+ * blocking, so a thread can wait from inside the pool without deadlocking it.
+ */
+    class WorkerPool {
+    public:
+        /**
+         * @param numThreads Worker count; 0 selects the number of hardware threads
+         */
+        explicit WorkerPool(int numThreads = 0);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /**
+         * @brief Process-wide pool shared by all detectors and streams
+         */
+        static std::shared_ptr<WorkerPool> shared();
+
+        int size() const { return static_cast<int>(workers_.size()); }
+
+        /**
+         * @brief Index of the calling worker in this pool, or -1 for outside threads
+         */
+        int currentWorkerIndex() const;
+
+        /**
+         * @brief Queue a task; increments task.group->pending if a group is set
+         */
+        void submit(const Task& task);
+
+        /**
+         * @brief Queue run(context, i) for i in [0, count) as one batch
+         */
+        void submitRange(void (*run)(void*, int), void* context, int count, TaskGroup* group);
+
+        /**
+         * @brief Run tasks until every task of the group has finished
+         */
+        void wait(TaskGroup& group);
+
+        /**
+         * @brief Run fn(i) for i in [0, count) on the pool and wait for completion
+         */
+        template<typename F>
+        void parallelFor(int count, F&& fn) {
+            TaskGroup group;
+            submitRange(&invoke<typename std::remove_reference<F>::type>, &fn, count, &group);
+            wait(group);
+        }
+
+        /**
+         * @brief Execute one queued task on the calling thread
+         * @return false if no task was available
+         */
+        bool runPendingTask();
+
+        /**
+         * @brief Snapshot of the scheduling counters
+         */
+        PoolStats stats() const;
+
+    private:
+        struct alignas(64) Worker {
+            WorkStealingDeque<Task> tasks;
+            std::thread thread;
+
+            // Written by this worker only; read by stats()
+            std::atomic<uint64_t> executed{0};
+            std::atomic<uint64_t> stolen{0};
+            std::atomic<uint64_t> failedSteals{0};
+            std::atomic<uint64_t> idleWaits{0};
+            std::atomic<int64_t> idleNs{0};
+        };
+
+        template<typename F>
+        static void invoke(void* context, int index) {
+            (*static_cast<F*>(context))(index);
+        }
+
+        void workerLoop(int index);
+        bool popLocal(int index, Task& task);
+        bool popInjected(Task& task);
+        bool steal(int thief, Task& task);
+        void execute(int self, const Task& task);
+        void wakeWorkers(int count);
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+
+        // Tasks submitted by threads outside the pool: a FIFO ring that only ever
+        // grows, so steady-state submissions don't allocate (guarded by injectMutex_)
+        std::mutex injectMutex_;
+        std::vector<Task> injected_;
+        size_t injectedHead_ = 0;
+        size_t injectedCount_ = 0;
+        std::atomic<uint64_t> outsideExecuted_{0};
+
+        std::atomic<int> queued_{0};
+        std::atomic<int> sleeping_{0};
+        std::atomic<bool> stopping_{false};
+        std::atomic<int> startedWorkers_{0};
+        std::mutex sleepMutex_;
+        std::condition_variable sleepCondition_;
+    };
+
+} // namespace EdgeDetection
+
+#endif // WORKER_POOL_H
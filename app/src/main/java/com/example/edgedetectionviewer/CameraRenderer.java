@@ -31,8 +31,8 @@ public class CameraRenderer {
     private static final String TAG = "CameraRenderer";
 
     // Camera configuration
-    private static final int PREFERRED_WIDTH = 640;
-    private static final int PREFERRED_HEIGHT = 480;
+    static final int PREFERRED_WIDTH = 640;
+    static final int PREFERRED_HEIGHT = 480;
     private static final int MAX_PREVIEW_WIDTH = 1920;
     private static final int MAX_PREVIEW_HEIGHT = 1080;
 
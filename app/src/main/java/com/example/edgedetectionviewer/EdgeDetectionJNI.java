@@ -2,7 +2,9 @@ package com.example.edgedetectionviewer;
 
 /**
  * JNI Bridge class for native edge detection operations
- * This class provides the interface between Java code and native C++ implementation
+ * This class provides the interface between Java code and native C++ implementation.
+ * Each pipeline lives in a native EdgeDetector created by nativeCreate(); the returned
+ * handle is passed as nativePtr to every other call, so several pipelines can coexist.
  */
 public class EdgeDetectionJNI {
 
@@ -17,27 +19,145 @@ public class EdgeDetectionJNI {
     }
 
     /**
-     * Initialize the native edge detection system
+     * Create an independent native edge detection pipeline
+     * @return Native handle, or 0 if creation failed
+     */
+    public static native long nativeCreate();
+
+    /**
+     * Destroy a pipeline created by nativeCreate()
+     * @param nativePtr Native handle
+     */
+    public static native void nativeDestroy(long nativePtr);
+
+    /**
+     * Initialize the native edge detection system and warm it up for the expected frame size.
+     * Allocates and touches all frame buffers and runs a few synthetic frames through the
+     * pipeline, so the first camera frame already runs at steady-state latency.
+     * The time spent is reported in ProcessingStats.warmUpMs.
+     * @param nativePtr Native handle
+     * @param width Expected frame width in pixels (RGBA), or 0 to skip the warm-up
+     * @param height Expected frame height in pixels
      * @return true if initialization successful
      */
-    public static native boolean nativeInit();
+    public static native boolean nativeInit(long nativePtr, int width, int height);
 
     /**
      * Process camera frame with edge detection
+     * @param nativePtr Native handle
      * @param inputData Input image data as byte array (RGBA format)
      * @param width Image width in pixels
      * @param height Image height in pixels
      * @return Processed image as byte array (RGBA format)
      */
-    public static native byte[] processFrame(byte[] inputData, int width, int height);
+    public static native byte[] processFrame(long nativePtr, byte[] inputData, int width, int height);
+
+    /**
+     * Process a paused frame or still image for interactive tuning.
+     * The native side caches every stage for the given image id, so calling again after
+     * updateParameters() reruns only what the change affects: a threshold change redoes
+     * just non-maximum suppression and hysteresis, a blur kernel change redoes blur onward.
+     * @param nativePtr Native handle
+     * @param inputData Input image data as byte array (RGBA format)
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @param imageId Nonzero identity of the image content; use a new id whenever the pixels change
+     * @return Processed image as byte array (RGBA format), or null on failure
+     */
+    public static native byte[] processImage(long nativePtr, byte[] inputData, int width, int height, long imageId);
+
+    /**
+     * Process a large still capture (12-48 MP) in tiles.
+     * Native scratch memory stays proportional to tile size times worker count instead
+     * of image size, so full-resolution captures don't trigger low-memory kills.
+     * @param nativePtr Native handle
+     * @param inputData Input image data as byte array (RGBA format)
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @param outputData Output buffer for the processed image (RGBA format, same size as inputData)
+     * @return true if successful
+     */
+    public static native boolean processLargeImage(long nativePtr, byte[] inputData, int width, int height, byte[] outputData);
+
+    /**
+     * Hand a camera frame to the native processing thread.
+     * Only the newest submitted frame is kept; older unprocessed frames are dropped.
+     * @param nativePtr Native handle
+     * @param inputData Input image data as byte array (RGBA format)
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @return true if the frame was accepted
+     */
+    public static native boolean submitFrame(long nativePtr, byte[] inputData, int width, int height);
+
+    /**
+     * Process the freshest submitted frame, blocking until one is available
+     * @param nativePtr Native handle
+     * @param timeoutMs Maximum time to wait for a new frame in milliseconds
+     * @return Processed image as byte array (RGBA format), or null on timeout
+     */
+    public static native byte[] processLatestFrame(long nativePtr, int timeoutMs);
+
+    /**
+     * Process the freshest submitted frame, publishing each row band to the GL thread as it finishes.
+     * Pair with {@link #uploadFrameBands} on the GL thread; no output array is created.
+     * @param nativePtr Native handle
+     * @param timeoutMs Maximum time to wait for a new frame in milliseconds
+     * @return true if a frame was processed
+     */
+    public static native boolean processLatestFrameProgressive(long nativePtr, int timeoutMs);
+
+    /**
+     * Upload the bands of the newest progressively processed frame as they finish (GL thread only)
+     * @param nativePtr Native handle
+     * @param textureId OpenGL texture ID
+     * @param width Texture width in pixels
+     * @param height Texture height in pixels
+     * @param timeoutMs Maximum time to wait for each band in milliseconds; 0 takes only finished bands
+     * @return true once a complete frame is in the texture
+     */
+    public static native boolean uploadFrameBands(long nativePtr, int textureId, int width, int height,
+                                                  int timeoutMs);
+
+    /**
+     * Report that a draw showing the last complete frame was submitted (GL thread only).
+     * Completes the frame's capture-to-present timeline in the statistics.
+     * @param nativePtr Native handle
+     */
+    public static native void framePresented(long nativePtr);
+
+    /**
+     * Process submitted frames on a native thread at a fixed rate, independent of camera and display.
+     * Frames older than the deadline when their turn comes are dropped. Results are published as with
+     * {@link #processLatestFrameProgressive}, which must not be called while the scheduler runs.
+     * Calling again while running only changes the pacing.
+     * @param nativePtr Native handle
+     * @param targetHz Processing rate; 0 processes frames as fast as they arrive
+     * @param deadlineMs Oldest capture age a frame may start processing at; 0 = two frame intervals
+     * @return true if the scheduler is running
+     */
+    public static native boolean startScheduler(long nativePtr, double targetHz, double deadlineMs);
+
+    /**
+     * Stop the native processing thread, waiting for the frame in progress
+     * @param nativePtr Native handle
+     */
+    public static native void stopScheduler(long nativePtr);
+
+    /**
+     * Wake a thread blocked in processLatestFrame (e.g. when shutting down)
+     * @param nativePtr Native handle
+     */
+    public static native void interruptFrameWait(long nativePtr);
 
     /**
      * Initialize OpenGL ES renderer
+     * @param nativePtr Native handle
      * @param width Surface width in pixels
      * @param height Surface height in pixels
      * @return true if initialization successful
      */
-    public static native boolean initGL(int width, int height);
+    public static native boolean initGL(long nativePtr, int width, int height);
 
     /**
      * Create shader program for texture rendering
@@ -55,39 +175,107 @@ public class EdgeDetectionJNI {
 
     /**
      * Update texture with processed frame data
+     * @param nativePtr Native handle
      * @param textureId OpenGL texture ID
      * @param pixelData Processed image data (RGBA format)
      * @param width Image width in pixels
      * @param height Image height in pixels
      */
-    public static native void updateTexture(int textureId, byte[] pixelData, int width, int height);
+    public static native void updateTexture(long nativePtr, int textureId, byte[] pixelData, int width, int height);
 
     /**
      * Render current frame to screen
+     * @param nativePtr Native handle
      * @param programId Shader program ID
      * @param textureId Texture ID to render
      */
-    public static native void renderFrame(int programId, int textureId);
+    public static native void renderFrame(long nativePtr, int programId, int textureId);
 
     /**
      * Get current performance statistics
-     * @return String containing performance metrics (FPS, frame count, etc.)
+     * @param nativePtr Native handle
+     * @return Snapshot of the pipeline's counters and latency percentiles, or null on failure
      */
-    public static native String getPerformanceStats();
+    public static native ProcessingStats getPerformanceStats(long nativePtr);
 
     /**
      * Update edge detection parameters at runtime
+     * @param nativePtr Native handle
      * @param lowThreshold Lower threshold for Canny edge detection
      * @param highThreshold Upper threshold for Canny edge detection
-     * @param blurKernel Gaussian blur kernel size (3, 5, 7)
+     * @param blurKernel Gaussian blur kernel size, odd up to 31. Up to 7 blurs with sigma 1.4 exactly;
+     *                   larger kernels blur more strongly (sigma 0.3 * ((size - 1) / 2 - 1) + 0.8) at a cost
+     *                   that no longer grows with the size
+     */
+    public static native void updateParameters(long nativePtr, double lowThreshold, double highThreshold, int blurKernel);
+
+    /**
+     * Skip processing while the scene is static; the previous output stays on screen.
+     * Skipped frames are counted in ProcessingStats.framesSkipped.
+     * @param nativePtr Native handle
+     * @param enabled true to skip static frames
+     * @param threshold Largest luma change (0-255) of any 1/16-scale thumbnail pixel below
+     *                  which a frame counts as static
+     */
+    public static native void setMotionGate(long nativePtr, boolean enabled, double threshold);
+
+    /**
+     * While the camera pans, build frames from the previous edge map shifted by the estimated
+     * global motion, recomputing only newly exposed strips and a few verification tiles.
+     * Frames that fail verification are processed in full. Reused frames are counted in
+     * ProcessingStats.framesReused.
+     * @param nativePtr Native handle
+     * @param enabled true to reuse shifted edges
+     */
+    public static native void setMotionCompensation(long nativePtr, boolean enabled);
+
+    /**
+     * Preview quality mode for high resolutions: each frame recomputes only every factor-th
+     * row band (even bands on even frames, odd on odd for factor 2) and composites the rest
+     * from previous frames, cutting per-frame cost by about the factor.
+     * @param nativePtr Native handle
+     * @param factor 1 for full quality (default), 2 or 4
+     */
+    public static native void setInterlace(long nativePtr, int factor);
+
+    /** Output format: the edge mask (0 or 255) in every channel */
+    public static final int OUTPUT_FORMAT_MASK = 0;
+
+    /**
+     * Output format: R edge mask, G gradient magnitude (|dx| + |dy|) / 4, B gradient direction
+     * in 256 steps per turn from +x towards +y (down), A edge strength (255 at or above the high
+     * threshold, lower for weak edges kept by hysteresis, 0 off edges)
+     */
+    public static final int OUTPUT_FORMAT_PACKED = 1;
+
+    /**
+     * Choose the layout of processed frames. The renderer draws only the mask in either format.
+     * Motion compensation pauses while packed.
+     * @param nativePtr Native handle
+     * @param format OUTPUT_FORMAT_MASK (default) or OUTPUT_FORMAT_PACKED
+     */
+    public static native void setOutputFormat(long nativePtr, int format);
+
+    /**
+     * Start or stop recording per-stage trace events.
+     * Only native builds configured with EDGE_ENABLE_TRACING record anything.
+     * @param enabled true to record
+     */
+    public static native void setTracingEnabled(boolean enabled);
+
+    /**
+     * Write recorded trace events as Chrome trace_event JSON (open in Perfetto or chrome://tracing)
+     * @param path Output file path
+     * @return true if the file was written
      */
-    public static native void updateParameters(double lowThreshold, double highThreshold, int blurKernel);
+    public static native boolean dumpTrace(String path);
 
     /**
      * Cleanup native resources
      * Should be called when the application is shutting down
+     * @param nativePtr Native handle
      */
-    public static native void cleanup();
+    public static native void cleanup(long nativePtr);
 
     /**
      * Check if native library is properly loaded and initialized
@@ -95,8 +283,9 @@ public class EdgeDetectionJNI {
      */
     public static boolean isLibraryLoaded() {
         try {
-            nativeInit();
-            return true;
+            long nativePtr = nativeCreate();
+            nativeDestroy(nativePtr);
+            return nativePtr != 0;
         } catch (UnsatisfiedLinkError e) {
             android.util.Log.e("EdgeDetectionJNI", "Native library not properly loaded", e);
             return false;
@@ -19,6 +19,9 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
 
     private static final String TAG = "GLTextureRenderer";
 
+    // Draws never wait for processing: each takes only the bands already finished
+    private static final int BAND_WAIT_TIMEOUT_MS = 0;
+
     // Shader source code
     private static final String VERTEX_SHADER_CODE =
             "#version 100\n" +
@@ -31,13 +34,14 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
                     "    vTexCoord = aTexCoord;\n" +
                     "}";
 
+    // Draws only the edge mask in R, so packed output looks the same as the plain mask
     private static final String FRAGMENT_SHADER_CODE =
             "#version 100\n" +
                     "precision mediump float;\n" +
                     "varying vec2 vTexCoord;\n" +
                     "uniform sampler2D uTexture;\n" +
                     "void main() {\n" +
-                    "    gl_FragColor = texture2D(uTexture, vTexCoord);\n" +
+                    "    gl_FragColor = vec4(texture2D(uTexture, vTexCoord).r);\n" +
                     "}";
 
     // Vertex coordinates for a quad
@@ -56,7 +60,8 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
 
     // OpenGL objects
     private int shaderProgram;
-    private int textureId;
+    private int textureId;          // Shown by every draw
+    private int backTextureId;      // Receives the bands of the frame being processed
     private int vertexBuffer;
     private int indexBuffer;
 
@@ -82,13 +87,17 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
     // Context reference
     private Context context;
 
+    // Native pipeline owning the GL buffer objects
+    private final long nativeDetector;
+
     // Performance tracking
     private long lastFrameTime = 0;
     private int frameCount = 0;
     private float currentFPS = 0.0f;
 
-    public GLTextureRenderer(Context context) {
+    public GLTextureRenderer(Context context, long nativeDetector) {
         this.context = context;
+        this.nativeDetector = nativeDetector;
         initializeBuffers();
     }
 
@@ -136,7 +145,7 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
         createBuffers();
 
         // Initialize native OpenGL
-        EdgeDetectionJNI.initGL(textureWidth, textureHeight);
+        EdgeDetectionJNI.initGL(nativeDetector, textureWidth, textureHeight);
 
         checkGLError("onSurfaceCreated");
     }
@@ -168,6 +177,15 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
         // Calculate FPS
         calculateFPS();
 
+        // Upload the finished bands of the newest frame into the back texture, overlapping
+        // its processing; once the whole frame is there it becomes the one shown
+        if (EdgeDetectionJNI.uploadFrameBands(nativeDetector, backTextureId, textureWidth, textureHeight,
+                BAND_WAIT_TIMEOUT_MS)) {
+            int shown = textureId;
+            textureId = backTextureId;
+            backTextureId = shown;
+        }
+
         // Clear screen
         GLES20.glClear(GLES20.GL_COLOR_BUFFER_BIT | GLES20.GL_DEPTH_BUFFER_BIT);
 
@@ -201,6 +219,9 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
         GLES20.glDisableVertexAttribArray(positionHandle);
         GLES20.glDisableVertexAttribArray(texCoordHandle);
 
+        // Completes the measured timeline of the frame just drawn the first time
+        EdgeDetectionJNI.framePresented(nativeDetector);
+
         checkGLError("onDrawFrame");
     }
 
@@ -262,14 +283,27 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
     }
 
     /**
-     * Create texture for displaying processed frames
+     * Create the shown and back textures for displaying processed frames
      */
     private void createTexture() {
-        int[] textures = new int[1];
-        GLES20.glGenTextures(1, textures, 0);
+        int[] textures = new int[2];
+        GLES20.glGenTextures(2, textures, 0);
         textureId = textures[0];
+        backTextureId = textures[1];
 
-        GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, textureId);
+        for (int texture : textures) {
+            allocateTexture(texture);
+        }
+
+        Log.i(TAG, "Textures created: IDs=" + textureId + "/" + backTextureId
+                + ", Size=" + textureWidth + "x" + textureHeight);
+    }
+
+    /**
+     * Set parameters and allocate storage of one frame texture
+     */
+    private void allocateTexture(int texture) {
+        GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, texture);
 
         // Set texture parameters
         GLES20.glTexParameteri(GLES20.GL_TEXTURE_2D, GLES20.GL_TEXTURE_MIN_FILTER, GLES20.GL_LINEAR);
@@ -281,8 +315,6 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
         GLES20.glTexImage2D(GLES20.GL_TEXTURE_2D, 0, GLES20.GL_RGBA,
                 textureWidth, textureHeight, 0, GLES20.GL_RGBA,
                 GLES20.GL_UNSIGNED_BYTE, null);
-
-        Log.i(TAG, "Texture created: ID=" + textureId + ", Size=" + textureWidth + "x" + textureHeight);
     }
 
     /**
@@ -388,9 +420,10 @@ public class GLTextureRenderer implements GLSurfaceView.Renderer {
      * Cleanup OpenGL resources
      */
     public void cleanup() {
-        if (textureId != 0) {
-            GLES20.glDeleteTextures(1, new int[]{textureId}, 0);
+        if (textureId != 0 || backTextureId != 0) {
+            GLES20.glDeleteTextures(2, new int[]{textureId, backTextureId}, 0);
             textureId = 0;
+            backTextureId = 0;
         }
 
         if (shaderProgram != 0) {
@@ -4,6 +4,8 @@ import android.Manifest;
 import android.content.pm.PackageManager;
 import android.opengl.GLSurfaceView;
 import android.os.Bundle;
+import android.os.Handler;
+import android.os.Looper;
 import android.util.Log;
 import android.view.TextureView;
 import android.view.View;
@@ -23,6 +25,13 @@ public class MainActivity extends AppCompatActivity {
 
     private static final String TAG = "MainActivity";
     private static final int CAMERA_PERMISSION_REQUEST_CODE = 1001;
+    // Native processing rate, independent of the camera's frame rate and the display's refresh
+    private static final double PROCESSING_TARGET_HZ = 30.0;
+    // Frames older than this when their turn comes are dropped; 0 = two processing intervals
+    private static final double FRAME_DEADLINE_MS = 0.0;
+    private static final long STATS_REFRESH_INTERVAL_MS = 500;
+    // Largest thumbnail luma change below which a frame is skipped; well above sensor noise
+    private static final double MOTION_GATE_THRESHOLD = 4.0;
 
     // UI Components
     private TextureView cameraTextureView;
@@ -32,6 +41,7 @@ public class MainActivity extends AppCompatActivity {
     private Button captureFrameButton;
 
     // Core components
+    private long nativeDetector;
     private CameraRenderer cameraRenderer;
     private GLTextureRenderer glTextureRenderer;
 
@@ -40,6 +50,19 @@ public class MainActivity extends AppCompatActivity {
     private boolean isCameraInitialized = false;
     private boolean isGLInitialized = false;
 
+    // Native scheduler thread consuming the latest-frame mailbox
+    private boolean isSchedulerRunning = false;
+
+    // Statistics are polled on the UI thread rather than pushed per processed frame
+    private final Handler statsHandler = new Handler(Looper.getMainLooper());
+    private final Runnable statsRefresh = new Runnable() {
+        @Override
+        public void run() {
+            updatePerformanceStats();
+            statsHandler.postDelayed(this, STATS_REFRESH_INTERVAL_MS);
+        }
+    };
+
     @Override
     protected void onCreate(Bundle savedInstanceState) {
         super.onCreate(savedInstanceState);
@@ -53,6 +76,22 @@ public class MainActivity extends AppCompatActivity {
             return;
         }
 
+        // Create this activity's native pipeline, warmed up for the expected preview size
+        nativeDetector = EdgeDetectionJNI.nativeCreate();
+        if (nativeDetector == 0 || !EdgeDetectionJNI.nativeInit(nativeDetector,
+                CameraRenderer.PREFERRED_WIDTH, CameraRenderer.PREFERRED_HEIGHT)) {
+            // Drop a half-initialized pipeline so onResume does not start its scheduler
+            if (nativeDetector != 0) {
+                EdgeDetectionJNI.nativeDestroy(nativeDetector);
+                nativeDetector = 0;
+            }
+            showError("Failed to initialize native edge detector");
+            return;
+        }
+
+        // An idle scene then costs a thumbnail comparison per frame instead of a full pass
+        EdgeDetectionJNI.setMotionGate(nativeDetector, true, MOTION_GATE_THRESHOLD);
+
         // Initialize UI components
         initializeUI();
 
@@ -132,11 +171,11 @@ public class MainActivity extends AppCompatActivity {
             glSurfaceView.setEGLContextClientVersion(2);
 
             // Create custom renderer
-            glTextureRenderer = new GLTextureRenderer(this);
+            glTextureRenderer = new GLTextureRenderer(this, nativeDetector);
             glSurfaceView.setRenderer(glTextureRenderer);
 
-            // Set render mode to only render when data changes
-            glSurfaceView.setRenderMode(GLSurfaceView.RENDERMODE_WHEN_DIRTY);
+            // Draw at display refresh from the latest finished frame, whatever the processing rate
+            glSurfaceView.setRenderMode(GLSurfaceView.RENDERMODE_CONTINUOUSLY);
 
             isGLInitialized = true;
             Log.i(TAG, "OpenGL initialized successfully");
@@ -148,31 +187,43 @@ public class MainActivity extends AppCompatActivity {
     }
 
     /**
-     * Process camera frame with edge detection
+     * Hand camera frame to the processing thread.
+     * Runs on the camera handler thread, so it only copies the frame into the native mailbox.
      */
     private void processFrame(byte[] frameData, int width, int height) {
         if (!isProcessingEnabled || !isGLInitialized || frameData == null) {
             return;
         }
 
-        try {
-            // Process frame using native code
-            byte[] processedData = EdgeDetectionJNI.processFrame(frameData, width, height);
-
-            if (processedData != null && glTextureRenderer != null) {
-                // Update OpenGL texture with processed data
-                glTextureRenderer.updateTexture(processedData, width, height);
+        EdgeDetectionJNI.submitFrame(nativeDetector, frameData, width, height);
+    }
 
-                // Trigger render
-                glSurfaceView.requestRender();
+    /**
+     * Start the native scheduler that processes the freshest submitted frame at a fixed rate
+     */
+    private void startScheduler() {
+        if (isSchedulerRunning || nativeDetector == 0) {
+            return;
+        }
 
-                // Update performance stats
-                updatePerformanceStats();
-            }
+        isSchedulerRunning = EdgeDetectionJNI.startScheduler(nativeDetector, PROCESSING_TARGET_HZ,
+                FRAME_DEADLINE_MS);
+        statsHandler.post(statsRefresh);
+        Log.i(TAG, "Processing scheduler started at " + PROCESSING_TARGET_HZ + " Hz");
+    }
 
-        } catch (Exception e) {
-            Log.e(TAG, "Error processing frame: " + e.getMessage());
+    /**
+     * Stop the native scheduler and wait for the frame in progress
+     */
+    private void stopScheduler() {
+        statsHandler.removeCallbacks(statsRefresh);
+        if (!isSchedulerRunning) {
+            return;
         }
+
+        isSchedulerRunning = false;
+        EdgeDetectionJNI.stopScheduler(nativeDetector);
+        Log.i(TAG, "Processing scheduler stopped");
     }
 
     /**
@@ -212,10 +263,15 @@ public class MainActivity extends AppCompatActivity {
      */
     private void updatePerformanceStats() {
         try {
-            String stats = EdgeDetectionJNI.getPerformanceStats();
+            ProcessingStats stats = EdgeDetectionJNI.getPerformanceStats(nativeDetector);
+            if (stats == null) {
+                return;
+            }
+
+            String text = stats.toString();
             runOnUiThread(() -> {
                 if (statsTextView != null) {
-                    statsTextView.setText(stats);
+                    statsTextView.setText(text);
                 }
             });
         } catch (Exception e) {
@@ -278,6 +334,8 @@ public class MainActivity extends AppCompatActivity {
             glSurfaceView.onResume();
         }
 
+        startScheduler();
+
         if (cameraRenderer != null && isCameraInitialized) {
             cameraRenderer.startCamera();
         }
@@ -295,6 +353,8 @@ public class MainActivity extends AppCompatActivity {
         if (cameraRenderer != null) {
             cameraRenderer.stopCamera();
         }
+
+        stopScheduler();
     }
 
     @Override
@@ -312,6 +372,11 @@ public class MainActivity extends AppCompatActivity {
         }
 
         // Cleanup native resources
-        EdgeDetectionJNI.cleanup();
+        stopScheduler();
+        if (nativeDetector != 0) {
+            EdgeDetectionJNI.cleanup(nativeDetector);
+            EdgeDetectionJNI.nativeDestroy(nativeDetector);
+            nativeDetector = 0;
+        }
     }
 }
\ No newline at end of file
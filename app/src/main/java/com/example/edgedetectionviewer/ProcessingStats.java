@@ -0,0 +1,92 @@
+package com.example.edgedetectionviewer;
+
+import java.util.Locale;
+
+/**
+ * Snapshot of a native pipeline's performance counters.
+ * Filled in by EdgeDetectionJNI.getPerformanceStats(); all times are in milliseconds.
+ */
+public class ProcessingStats {
+
+    /** Names of the entries in stageAverageMs / stageMaxMs, in order */
+    public static final String[] STAGE_NAMES = {"gray", "blur", "canny", "rgba", "copy", "gate", "motion"};
+
+    public int framesProcessed;
+    public int framesDropped;
+    /** Frames the motion gate found static; the previous output was shown again */
+    public int framesSkipped;
+    /** Processed frames built from the previous edge map shifted by the camera's global motion */
+    public int framesReused;
+    public double averageFps;
+    public double lastFrameMs;
+
+    public double latencyP50Ms;
+    public double latencyP90Ms;
+    public double latencyP99Ms;
+    public double latencyMaxMs;
+
+    /** Measured timeline of frames shown on screen: capture to present, and its segments */
+    public int framesPresented;
+    public double endToEndP50Ms;
+    public double endToEndP99Ms;
+    public double queueDelayMs;
+    public double processDelayMs;
+    public double uploadDelayMs;
+    public double presentDelayMs;
+
+    public long bytesProcessed;
+
+    /** Time nativeInit spent warming the pipeline up */
+    public double warmUpMs;
+
+    public int lowThreshold;
+    public int highThreshold;
+    public int blurKernel;
+
+    public int bandsPerFrame;
+    public long tasksStolen;
+    public double workerIdleMs;
+
+    /** Pooled OpenCV Mat allocator (process-wide) */
+    public long matAllocations;
+    public long matPoolHits;
+    public long matBytesInUse;
+    public long matBytesCached;
+
+    public double[] stageAverageMs = new double[STAGE_NAMES.length];
+    public double[] stageMaxMs = new double[STAGE_NAMES.length];
+
+    /** Fraction of frames the motion gate skipped */
+    public double skipRate() {
+        int frames = framesProcessed + framesSkipped;
+        return frames > 0 ? (double) framesSkipped / frames : 0.0;
+    }
+
+    @Override
+    public String toString() {
+        StringBuilder stages = new StringBuilder();
+        for (int i = 0; i < STAGE_NAMES.length && i < stageAverageMs.length; i++) {
+            if (i > 0) {
+                stages.append(", ");
+            }
+            stages.append(String.format(Locale.US, "%s %.2f", STAGE_NAMES[i], stageAverageMs[i]));
+        }
+
+        return String.format(Locale.US,
+                "Frames: %d, FPS: %.1f, Dropped: %d, warm-up %.0f ms\n"
+                        + "Static skips: %d (%.0f%%), shifted reuse: %d\n"
+                        + "Latency p50/p90/p99/max: %.1f/%.1f/%.1f/%.1f ms\n"
+                        + "End-to-end p50/p99: %.1f/%.1f ms (queue %.1f, process %.1f, upload %.1f, present %.1f)\n"
+                        + "Stages (ms): %s\n"
+                        + "Canny %d/%d, blur %d, bands %d, steals %d\n"
+                        + "Mat pool: %d allocs, %.0f%% reused, %.1f MB in use, %.1f MB cached",
+                framesProcessed, averageFps, framesDropped, warmUpMs,
+                framesSkipped, skipRate() * 100.0, framesReused,
+                latencyP50Ms, latencyP90Ms, latencyP99Ms, latencyMaxMs,
+                endToEndP50Ms, endToEndP99Ms, queueDelayMs, processDelayMs, uploadDelayMs, presentDelayMs,
+                stages,
+                lowThreshold, highThreshold, blurKernel, bandsPerFrame, tasksStolen,
+                matAllocations, matAllocations > 0 ? 100.0 * matPoolHits / matAllocations : 0.0,
+                matBytesInUse / 1048576.0, matBytesCached / 1048576.0);
+    }
+}